@@ -0,0 +1,179 @@
+/* benchOCLSource.c -
+ *             Times the decoder over the same OCL file read from each kind
+ *             of byte source (see oclSource.c): a stdio stream, the file
+ *             memory-mapped, and the file read into a buffer first - or for
+ *             a gzipped file, decompressed into memory by zlib.  Each pass
+ *             decodes every station's headers and whole profile, and the
+ *             values decoded are checksummed, so the sources can be checked
+ *             against each other as well as timed.
+ *
+ * usage:      benchOCLSource <oclfile> [<passes>]
+ *             (default 3 passes over each source; the fastest is reported)
+ *
+ *             Times are CPU seconds from clock(), so the stdio stream's
+ *             reads from the page cache count, but not waiting on a cold
+ *             disk - run it once first to warm the file up.
+ *
+ * required sources/files: ocl.h, getOCLStationData.c, oclSource.c,
+ *                         oclIndex.c, oclCache.c, oclBathy.c, oclArena.c,
+ *                         oclExpr.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ocl.h"
+
+#define BENCH_STDIO 0
+#define BENCH_MMAP 1
+#define BENCH_BUFFER 2
+#define BENCH_GZIP 3
+#define NUM_BENCH_SOURCES 4
+
+static char *benchSourceName[NUM_BENCH_SOURCES] =
+   { "stdio", "mmap", "buffer", "gzip" };
+
+
+/* what one pass over the file decoded */
+typedef struct BenchResult {
+   long int bytes;             /* of OCL data (decompressed, for gzip) */
+   long int numStations;
+   long int numLevels;
+   double checksum;            /* sum of all the non-NaN values decoded */
+   double seconds;
+}  BenchResultType;
+
+
+
+
+/* "Bench OCL source" - set up dec's source as the given kind, decode the
+   whole file with it, and fill in result.  Returns UNSPECIFIED_PROBLEM if
+   the file can't be read that way. */
+static int benchOCLSource(char *filename, int kind, BenchResultType *result) {
+
+   OCLDecoderType dec;
+   FILE *fp=NULL;
+   char *buf=NULL;
+   long int len=0, j, k;
+   double x;
+   int status;
+   clock_t start;
+
+   initOCLDecoder(&dec);
+   result->numStations = 0;
+   result->numLevels = 0;
+   result->checksum = 0.;
+
+   /* (opening the source is part of what's timed - for mmap and gzip it's
+      where a good part of the work is) */
+   start = clock();
+   if( kind==BENCH_STDIO || kind==BENCH_BUFFER ) {
+      if( (fp=fopen(filename, "r")) == NULL ) {
+         fprintf(stderr, "benchOCLSource: unable to open %s.\n", filename);
+         return UNSPECIFIED_PROBLEM;
+      }
+      if( kind==BENCH_STDIO ) setOCLSourceFile(&(dec.src), fp);
+      else {
+         fseek(fp, 0L, SEEK_END);
+         len = ftell(fp);
+         rewind(fp);
+         if( len<0 || (buf=(char *)malloc((size_t)len+1)) == NULL ||
+             fread(buf, 1, (size_t)len, fp) != (size_t)len ) {
+            fprintf(stderr, "benchOCLSource: unable to read %s.\n", filename);
+            fclose(fp);
+            free(buf);
+            return UNSPECIFIED_PROBLEM;
+         }
+         fclose(fp);
+         fp = NULL;
+         setOCLSourceBuffer(&(dec.src), buf, len);
+      }
+   }
+   else if( kind==BENCH_MMAP ) {
+      if( mapOCLSource(&(dec.src), filename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else if( loadOCLGzSource(&(dec.src), filename) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+
+
+   result->bytes = sizeOfOCLSource(&(dec.src));
+   while( (status=decodeOCLStation(&dec, OCL_PROFILE_ALL)) == SUCCESSFUL ) {
+      result->numStations++;
+      result->numLevels += dec.stnData.numberOfLevels;
+      for(j=0; j<dec.stnData.numberOfLevels; j++) {
+         x = dec.stnData.depthValue[j];
+         if( x==x ) result->checksum += x;
+         for(k=0; k<dec.stnData.numberOfVarCodes; k++) {
+            x = dec.stnData.varValue[k][j];
+            if( x==x ) result->checksum += x;
+         }
+      }
+   }
+   result->seconds = (double)(clock()-start)/CLOCKS_PER_SEC;
+
+   freeOCLDecoder(&dec);
+   if( fp!=NULL ) fclose(fp);
+   free(buf);
+
+   if( status!=OCL_DECODER_END ) {
+      fprintf(stderr, "benchOCLSource: failure decoding %s from %s at "
+         "stn#%ld.\n", filename, benchSourceName[kind], result->numStations);
+      return UNSPECIFIED_PROBLEM;
+   }
+   return SUCCESSFUL;
+}
+
+
+
+
+int main (int argc, char *argv[]) {
+
+   BenchResultType best[NUM_BENCH_SOURCES], result;
+   int kind, firstKind, lastKind, pass, numPasses=3, status=SUCCESSFUL;
+
+   if( argc<2 || argc>3 || (argc==3 && (numPasses=atoi(argv[2]))<1) ) {
+      fprintf(stderr, "usage: benchOCLSource <oclfile> [<passes>]\n");
+      exit(1);
+   }
+   memset(best, 0, sizeof(best));
+
+   /* a gzipped file can only be decoded decompressed, so that's the one
+      source for it */
+   if( isGzipFile(argv[1]) ) firstKind = lastKind = BENCH_GZIP;
+   else {
+      firstKind = BENCH_STDIO;
+      lastKind = BENCH_BUFFER;
+   }
+
+   /* passes take turns over the sources, so that anything else going on
+      on the machine is spread over all of them */
+   for(pass=0; pass<numPasses; pass++)
+      for(kind=firstKind; kind<=lastKind; kind++) {
+         if( benchOCLSource(argv[1], kind, &result) != SUCCESSFUL ) exit(1);
+         if( pass==0 || result.seconds<best[kind].seconds )
+            best[kind] = result;
+      }
+
+   printf("%% %s: %ld bytes, %ld stations, %ld levels (best of %d)\n",
+      argv[1], best[firstKind].bytes, best[firstKind].numStations,
+      best[firstKind].numLevels, numPasses);
+   for(kind=firstKind; kind<=lastKind; kind++) {
+      printf("%-7s %8.3f s  %8.1f MB/s\n", benchSourceName[kind],
+         best[kind].seconds, (best[kind].seconds>0.) ?
+         best[kind].bytes/best[kind].seconds/1.e6 : 0.);
+
+      /* every source has to decode exactly the same values */
+      if( best[kind].numStations!=best[firstKind].numStations ||
+          best[kind].numLevels!=best[firstKind].numLevels ||
+          best[kind].checksum!=best[firstKind].checksum ) {
+         fprintf(stderr, "benchOCLSource: %s decoded different values than"
+            " %s!\n", benchSourceName[kind], benchSourceName[firstKind]);
+         status = UNSPECIFIED_PROBLEM;
+      }
+   }
+
+   return status;
+
+}  /* end of main */
@@ -0,0 +1,182 @@
+/* checkOCLDigits.c -
+ *             Checks the span source's fast digit-run conversion (see
+ *             spanDigitRun() in oclSourcePolicy.h - SSE2 where the compiler
+ *             has it) against the plain byte-at-a-time decoder, bit for bit.
+ *             The same bytes are read with getIntDigitsSrc() from a stdio
+ *             stream, which always takes the byte-at-a-time state machine,
+ *             and from a span in memory, which takes the fast path when it
+ *             can; the status, value and bytes used up have to agree for
+ *             every field.
+ *
+ *             Fields tried, for each width of 1 to 9 digits:
+ *               - at every position through the first 40 bytes of the span,
+ *                 so both sides of the scalar/SSE2 switch (the run ending
+ *                 before or at byte 16) get each kind of field below:
+ *                 all digits, leading blanks, a sign (+ or -) after blanks,
+ *                 a newline or CR in among the digits, a lone '-', blanks
+ *                 only, and a stray char
+ *               - then <fields> more (default 3000000) at random positions
+ *                 in a span of random digits, blanks, signs and newlines
+ *
+ * usage:      checkOCLDigits [<fields> [<seed>]]
+ *
+ * required sources/files: ocl.h, getOCLStationData.c, oclSource.c,
+ *                         oclIndex.c, oclCache.c, oclBathy.c, oclArena.c,
+ *                         oclExpr.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+#define CHECK_SPAN_LEN 32768  /* (so positions fit in the least RAND_MAX) */
+#define CHECK_PAD 64        /* digits at the end, so no field runs off it */
+#define CHECK_FIXED_LEN 40  /* positions tried for the fixed fields */
+#define CHECK_MAX_REPORTS 10
+
+
+static char span[CHECK_SPAN_LEN];
+static FILE *fp_span;       /* the same bytes, read thru stdio */
+static long int numChecked=0, numFailed=0;
+
+
+
+
+/* "Check field" - decode the numDigits-digit field at pos both ways and
+   compare, reporting the first few that differ */
+static void checkField(long int pos, int numDigits) {
+
+   OCLSourceType stdioSrc, spanSrc;
+   long int stdioValue=-1, spanValue=-1, stdioEnd, spanEnd;
+   int stdioStatus, spanStatus, i;
+
+   fseek(fp_span, pos, SEEK_SET);
+   setOCLSourceFile(&stdioSrc, fp_span);
+   stdioStatus = getIntDigitsSrc(&stdioSrc, numDigits, &stdioValue);
+   stdioEnd = ftell(fp_span);
+
+   setOCLSourceBuffer(&spanSrc, span, CHECK_SPAN_LEN);
+   spanSrc.pos = pos;
+   spanStatus = getIntDigitsSrc(&spanSrc, numDigits, &spanValue);
+   spanEnd = spanSrc.pos;
+
+   /* (an empty field's value is a NaN cast to long, so not compared) */
+   numChecked++;
+   if( stdioStatus==spanStatus && stdioEnd==spanEnd &&
+       (stdioStatus==ZERO_LENGTH_FIELD || stdioValue==spanValue) )
+      return;
+
+   if( numFailed++ < CHECK_MAX_REPORTS ) {
+      fprintf(stderr, "checkOCLDigits: %d digits at %ld \"", numDigits, pos);
+      for(i=0; i<numDigits+4 && pos+i<CHECK_SPAN_LEN; i++) {
+         if( span[pos+i]=='\n' ) fputs("\\n", stderr);
+         else if( span[pos+i]=='\r' ) fputs("\\r", stderr);
+         else fputc(span[pos+i], stderr);
+      }
+      fprintf(stderr, "\": stdio %d %ld (to %ld), span %d %ld (to %ld)\n",
+         stdioStatus, stdioValue, stdioEnd, spanStatus, spanValue, spanEnd);
+   }
+}
+
+
+
+
+/* "Put span" - copy the first len bytes of the span out to the stdio
+   stream as well */
+static void putSpan(long int len) {
+   rewind(fp_span);
+   if( (long int)fwrite(span, 1, (size_t)len, fp_span) != len ||
+       fflush(fp_span) != 0 ) {
+      fprintf(stderr, "checkOCLDigits: unable to write temp file.\n");
+      exit(1);
+   }
+}
+
+
+
+
+/* "Fixed field" - fill field[] (numDigits chars, not counting any newline)
+   with the given kind of field, kind 0 to CHECK_NUM_KINDS-1 */
+#define CHECK_NUM_KINDS 9
+static int fixedField(char *field, int numDigits, int kind, int k) {
+   int i, n=0, blanks = (numDigits>1) ? k%numDigits : 0;
+
+   for(i=0; i<numDigits; i++) field[n++] = (char)('0' + (i*7+k+1)%10);
+   switch( kind ) {
+      case 0:  break;                                    /* all digits */
+      case 1:  memset(field, ' ', (size_t)blanks); break; /* leading blanks */
+      case 2:  case 3:                                   /* sign */
+         if( numDigits<2 ) return 0;
+         if( blanks>numDigits-2 ) blanks = numDigits-2;
+         memset(field, ' ', (size_t)blanks);
+         field[blanks] = (kind==2) ? '-' : '+';
+         break;
+      case 4:  case 5:                       /* newline or CR in the digits */
+         memmove(field+k%numDigits+1, field+k%numDigits,
+            (size_t)(numDigits-k%numDigits));
+         field[k%numDigits] = (kind==4) ? '\n' : '\r';
+         n++;
+         break;
+      case 6:                                            /* lone '-' */
+         memset(field, ' ', (size_t)numDigits);
+         field[numDigits-1] = '-';
+         break;
+      case 7:  memset(field, ' ', (size_t)numDigits); break;  /* blanks */
+      case 8:  field[k%numDigits] = 'x'; break;          /* stray char */
+   }
+   return n;
+}
+
+
+
+
+int main (int argc, char *argv[]) {
+
+   long int numRandom=3000000L, i, pos;
+   unsigned int seed=1;
+   int numDigits, kind, k, n;
+   char field[16];
+   static const char randomChars[] = "01234567890123456789    -+\n";
+
+   if( argc>3 || (argc>1 && (numRandom=atol(argv[1]))<0) ) {
+      fprintf(stderr, "usage: checkOCLDigits [<fields> [<seed>]]\n");
+      exit(1);
+   }
+   if( argc>2 ) seed = (unsigned int)atol(argv[2]);
+   if( (fp_span=tmpfile()) == NULL ) {
+      fprintf(stderr, "checkOCLDigits: unable to open temp file.\n");
+      exit(1);
+   }
+
+   /* each kind of field, at each position near the front of the span */
+   memset(span, '7', CHECK_SPAN_LEN);
+   putSpan(CHECK_SPAN_LEN);
+   for(numDigits=1; numDigits<=9; numDigits++)
+      for(kind=0; kind<CHECK_NUM_KINDS; kind++)
+         for(k=0; k<numDigits; k++) {
+            if( (n=fixedField(field, numDigits, kind, k)) == 0 ) continue;
+            for(pos=0; pos<CHECK_FIXED_LEN; pos++) {
+               memset(span, '7', CHECK_PAD);
+               memcpy(span+pos, field, (size_t)n);
+               putSpan(CHECK_PAD);
+               checkField(pos, numDigits);
+            }
+         }
+
+   /* and random fields all over a random span */
+   srand(seed);
+   for(i=0; i<CHECK_SPAN_LEN-CHECK_PAD; i++)
+      span[i] = randomChars[rand()%(sizeof(randomChars)-1)];
+   memset(span+CHECK_SPAN_LEN-CHECK_PAD, '5', CHECK_PAD);
+   putSpan(CHECK_SPAN_LEN);
+   for(i=0; i<numRandom; i++)
+      checkField(rand()%(CHECK_SPAN_LEN-2*CHECK_PAD), 1+rand()%9);
+
+   fclose(fp_span);
+
+   printf("checkOCLDigits: %ld fields, %ld differed\n", numChecked,
+      numFailed);
+   return (numFailed==0) ? SUCCESSFUL : UNSPECIFIED_PROBLEM;
+
+}  /* end of main */
@@ -0,0 +1,168 @@
+/* checkOCLIndex.c -
+ *             Checks that an OCL file's station index gets oclfilt -s and -k
+ *             the same stations as reading through the file does.  Every
+ *             station is decoded twice: once reading straight through the
+ *             file, and once after seekOCLStation() to it with the index, as
+ *             oclfilt -s does; the two have to agree field for field (header,
+ *             secondary header, and every profile value and error code, bit
+ *             for bit).  The index has to match the file first, as oclfilt
+ *             checks too (see matchOCLIndex() in oclIndex.c).
+ *
+ * usage:      checkOCLIndex <oclfile> [<indexfile>]
+ *             (default indexfile is <oclfile>.idx, as made by makeOCLIndex)
+ *
+ *             <oclfile> is opened the way oclfilt -i opens it: an OCL cache
+ *             file as a cache, a gzipped one decompressed, anything else
+ *             memory-mapped.
+ *
+ * required sources/files: ocl.h, oclIndex.c, getOCLStationData.c,
+ *                         oclSource.c, oclCache.c, oclBathy.c, oclArena.c,
+ *                         oclExpr.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+#define CHECK_MAX_REPORTS 10
+
+
+static long int numFailed=0;
+
+
+
+
+/* "Open check source" - open the file as oclfilt -i would */
+static int openCheckSource(OCLSourceType *src, char *filename) {
+   if( isGzipFile(filename) ) return loadOCLGzSource(src, filename);
+   else if( isOCLCacheFile(filename) ) return openOCLCache(src, filename);
+   else return mapOCLSource(src, filename);
+}
+
+
+
+
+/* "Read check station" - decode station stn from src, profile and all, with
+   no filters */
+static int readCheckStation(OCLSourceType *src, long int stn,
+   OCLStationType *stnData) {
+   return getOCLStationDataSrc( src, stn, stnData, 1, 0, 0, 0, NULL, 0, 0, 0,
+      0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, NULL );
+}
+
+
+
+
+/* "Same values" - n doubles the same bit for bit (so NaNs compare too) */
+static int sameValues(const double *a, const double *b, long int n) {
+   return n<=0 || memcmp(a, b, (size_t)n*sizeof(double)) == 0;
+}
+
+
+
+
+/* "Check station" - report station stn if the two decodings of it differ */
+static void checkStation(long int stn, OCLStationType *a, OCLStationType *b) {
+   long int j, n=a->numberOfLevels;
+   int same;
+
+   same = a->oclStationNumber==b->oclStationNumber &&
+      a->bytesInStation==b->bytesInStation &&
+      a->countryCode==b->countryCode && a->cruiseNumber==b->cruiseNumber &&
+      a->year==b->year && a->month==b->month && a->day==b->day &&
+      sameValues(&(a->time), &(b->time), 1) &&
+      sameValues(&(a->lat), &(b->lat), 1) &&
+      sameValues(&(a->lon), &(b->lon), 1) &&
+      a->bottomDepthSource==b->bottomDepthSource &&
+      (a->bottomDepthPtr==NULL) == (b->bottomDepthPtr==NULL) &&
+      (a->bottomDepthPtr==NULL ||
+         sameValues(a->bottomDepthPtr, b->bottomDepthPtr, 1)) &&
+      a->numberOfLevels==b->numberOfLevels &&
+      a->stationType==b->stationType &&
+      a->numberOfVarCodes==b->numberOfVarCodes &&
+      a->numberOfSecHdrEntries==b->numberOfSecHdrEntries;
+   for(j=0; same && j<a->numberOfVarCodes; j++)
+      same = a->varCode[j]==b->varCode[j] &&
+         a->errCodeForVarCode[j]==b->errCodeForVarCode[j] &&
+         sameValues(a->varValue[j], b->varValue[j], n) &&
+         memcmp(a->errCodeForVarValue[j], b->errCodeForVarValue[j],
+            (size_t)n) == 0;
+   for(j=0; same && j<a->numberOfSecHdrEntries; j++)
+      same = a->secHdrCode[j]==b->secHdrCode[j];
+   same = same &&
+      sameValues(a->secHdrValue, b->secHdrValue, a->numberOfSecHdrEntries) &&
+      sameValues(a->depthValue, b->depthValue, n) &&
+      memcmp(a->errCodeForDepthValue, b->errCodeForDepthValue, (size_t)n)
+         == 0;
+
+   if( !same && numFailed++ < CHECK_MAX_REPORTS )
+      fprintf(stderr, "checkOCLIndex: stn#%ld (OCL stn %ld) differs when"
+         " seeked to with the index.\n", stn, a->oclStationNumber);
+}
+
+
+
+
+int main (int argc, char *argv[]) {
+
+  static OCLStationType seqStn, idxStn;  /* (static, for their arenas) */
+  OCLSourceType seqSrc, idxSrc;
+  OCLIndexType idx;
+  char indexFilename[256];
+  long int i;
+
+  if( argc<2 || argc>3 ) {
+    fprintf(stderr, "usage: checkOCLIndex <oclfile> [<indexfile>]\n");
+    exit(1);
+  }
+  if( argc==3 ) sprintf(indexFilename, "%.255s", argv[2]);
+  else sprintf(indexFilename, "%.251s.idx", argv[1]);
+
+  if( openCheckSource(&seqSrc, argv[1]) != SUCCESSFUL ||
+      openCheckSource(&idxSrc, argv[1]) != SUCCESSFUL ) exit(1);
+  if( readOCLIndex(indexFilename, &idx) != SUCCESSFUL ) {
+    fprintf(stderr, "checkOCLIndex: unable to read index %s.\n",
+       indexFilename);
+    exit(1);
+  }
+  if( matchOCLIndex(&idxSrc, &idx) != SUCCESSFUL ) {
+    fprintf(stderr, "checkOCLIndex: index %s doesn't match %s.\n",
+       indexFilename, argv[1]);
+    exit(1);
+  }
+  initOCLStation(&seqStn);
+  initOCLStation(&idxStn);
+
+  for(i=0; i<idx.numStations; i++) {
+    if( endOfOCLSource(&seqSrc) ) {
+      fprintf(stderr, "checkOCLIndex: %s ends at stn#%ld, but the index has"
+         " %ld stations.\n", argv[1], i, idx.numStations);
+      exit(1);
+    }
+    if( readCheckStation(&seqSrc, i, &seqStn) != SUCCESSFUL ||
+        seekOCLStation(&idxSrc, &idx, i) != SUCCESSFUL ||
+        readCheckStation(&idxSrc, i, &idxStn) != SUCCESSFUL ) {
+      fprintf(stderr, "checkOCLIndex: failure reading stn#%ld.\n", i);
+      exit(1);
+    }
+    checkStation(i, &seqStn, &idxStn);
+  }
+  if( !endOfOCLSource(&seqSrc) ) {
+    fprintf(stderr, "checkOCLIndex: %s has more than the index's %ld"
+       " stations.\n", argv[1], idx.numStations);
+    numFailed++;
+  }
+
+  printf("checkOCLIndex: %ld stations, %ld differed\n", idx.numStations,
+     numFailed);
+
+  freeOCLStation(&seqStn);
+  freeOCLStation(&idxStn);
+  freeOCLIndex(&idx);
+  closeOCLSource(&seqSrc);
+  closeOCLSource(&idxSrc);
+
+  return (numFailed==0) ? SUCCESSFUL : UNSPECIFIED_PROBLEM;
+
+}  /* end of main */
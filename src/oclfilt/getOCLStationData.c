@@ -4,14 +4,25 @@
  *             are specified in args, getOCLStationData will stop reading and
  *             skip to the next station in the input file (and return to the
  *             calling function) as soon as a filter applies, in order to
- *             reduce computation time (mostly I/O time).
+ *             reduce computation time (mostly I/O time).  Each filter is
+ *             checked as soon as the header fields it needs are read - year,
+ *             month, lat/lon, number of levels, then the variable codes -
+ *             so a station cut by -y say is skipped after four digits of
+ *             its year.  (Pointing the station struct's filterCounts at an
+ *             OCLFilterCountsType counts how many each filter cut.)  And
+ *             pointing its filterExpr at a compiled filter expression (see
+ *             oclExpr.c) checks that too, as soon as the last of the fields
+ *             it tests is read.  Or at an array of numFilterExprs of them,
+ *             for a station that satisfies any one to pass, with which
+ *             ones it satisfies set in the caller's filterExprMatches[].
  *             Note that getOCLStationData skips right over the station's
  *             character data, PI data, and bio/taxo data (since I'm not
  *             interested in those), but the framework set up in this code
  *             makes it easy enough to add those if desired.  Comments in the
  *             code label the places to change.  (seach for PI, bio, taxo...)
  *
- * other required sources/files: ocl.h
+ * other required sources/files: ocl.h, oclSourcePolicy.h, oclSource.c,
+ *                               oclCache.c, oclArena.c, oclBathy.c
  *
  * language:   ANSI C
  *
@@ -73,18 +84,69 @@
  *               int dbBathyFlag, FILE *fp_dbBathy,
  *               int zeroLatLonFlag, char *wmoSquare );
  *
+ *             A second entry point, getOCLStationDataSrc(), takes the same
+ *             args except that fp_in is replaced by an OCLSourceType *src,
+ *             which can be a stdio stream or the whole file in memory
+ *             (memory-mapped, or a buffer already filled by the caller) -
+ *             see oclSource.c.  The field decoders are compiled once for each
+ *             kind of source (see oclSourcePolicy.h), and from memory the
+ *             fields are converted in place with a cursor, which is faster
+ *             still than stdio.  The source can also be an OCL cache file made
+ *             by makeOCLCache, whose stations are already decoded - see
+ *             oclCache.c.
+ *
+ *             To read a station's profile a level at a time, or only part
+ *             of it, getOCLStationHeader( src, stn, stnData, &cursor ) reads
+ *             just the station's headers (no filters) and leaves an
+ *             OCLProfileCursorType at the start of its profile.  Then
+ *             readOCLProfileLevels( &cursor, n ) decodes the next n levels,
+ *             skipOCLProfileLevels( &cursor, n ) hops over them without
+ *             decoding (n<0 means all the rest, either way), and
+ *             finishOCLStation( &cursor ) goes on to the next station.
+ *             bytesLeftInStation is kept right however much was read.
+ *
+ *             getOCLStationData() keeps its OCLSourceType in a static
+ *             between calls, so it's only for reading one stream at a time.
+ *             For several at once (eg one per thread, on separate files) use
+ *             a decoder instead - an OCLDecoderType, which holds the source,
+ *             the bathy file, the filters and the station, so decoders share
+ *             no state at all:
+ *                OCLDecoderType dec;
+ *                initOCLDecoder( &dec );
+ *                mapOCLSource( &(dec.src), filename );   (or setOCLSourceFile,
+ *                                                        loadOCLGzSource...)
+ *                while( decodeOCLStation( &dec, 1 ) == SUCCESSFUL )
+ *                   ...dec.stnData, and dec.bottomDepth (NaN for none)...
+ *                freeOCLDecoder( &dec );
+ *             A decoder looks its bottom depths up in a bathy grid or sidecar
+ *             if dec.stnData.bathy is set (see fp_dbBathy below).
+ *             getOCLBottomDepth( stnData ) gives any station's bottom depth by
+ *             value the same way, rather than through bottomDepthPtr.
+ *
  *             Explanation of function args:
  *
  *              FILE *fp_in - OCL-formatted input file we read data from.
  *                 File opened & closed in the calling function.
  *
  *              long int stn - current station # (from loop in calling funct)
+ *                 counting from 0 in each file, 0 telling getOCLStationData
+ *                 that fp_in is at the start of a new file
  *
  *              OCLStationType *stnData - pointer to structure which will hold
  *                 all the station data we read; note that since this is a
  *                 pointer to struct we use stnData->element in the code below,
  *                 rathen than stnData.element.  Referencing from a pointer
  *                 allows us to pass all our data back to the calling routine.
+ *                 The station's secondary header entries and profile go in
+ *                 the station's arena (see oclArena.c and OCLStationType in
+ *                 ocl.h), so they're only good till the next station is read
+ *                 into stnData - or if the caller gave stnData an arena of its
+ *                 own, till the caller resets that.
+ *                 If the caller set a projection in stnData (numProjectionVars
+ *                 and projectionVars), only the profile columns of those
+ *                 variables are decoded; the others are stepped over by their
+ *                 length digits alone, and their varValue[]s left NULL (see
+ *                 decodedVars).
  *
  *              int wantProfileFlag - true (1) = yes, we want to read the
  *                                       profile data for this station.
@@ -94,6 +156,12 @@
  *                                       when filtering or doing stats
  *                                       (like report station bytecounts
  *                                       and which vars they have)
+ *                                    OCL_PROFILE_LAST_LEVEL (2) = only the
+ *                                       deepest level, for the bottom
+ *                                       depth - the levels above it are
+ *                                       skipped over without decoding
+ *                                       them (so they're not in the
+ *                                       profile arrays)
  *
  *              int skipFlag - true (1) = yes, we're skipping the station
  *                                specified by stnToSkipTo, so if we're
@@ -168,7 +236,10 @@
  *
  *              long int *monthRange - two-element array holding
  *                                  minmonth,maxmonth to filter between,
- *                                  inclusive of both.
+ *                                  inclusive of both.  If minmonth is
+ *                                  greater than maxmonth the range wraps
+ *                                  around the end of the year, eg 11,2
+ *                                  is Nov, Dec, Jan and Feb.
  *
  *              int dbBathyFlag - true (1) = yes, we want to look up the
  *                                   bathy value for this station's
@@ -182,6 +253,13 @@
  *                 File is a premade ASCII lat-lon-depth file made specifically
  *                 for use with this OCL input-file, by the shell script 
  *                 bathyForThisOCLfile.  File opened/closed in calling function
+ *                 Or instead of the file, point stnData->bathy at a bathy grid
+ *                 (mapOCLBathy(), see oclBathy.c) and the value is looked up
+ *                 by the station's lat/lon in that, with no file to keep in
+ *                 step - fp_dbBathy is then ignored.  Or at a bathy sidecar
+ *                 made for this input file (writeOCLBathySidecar()), in
+ *                 which it's looked up by stn, so it doesn't matter which
+ *                 stations were read before.
  *
  *              int zeroLatLonFlag - true (1) = yes, we want to filter out
  *                                      stations with an invalid value of zero
@@ -211,6 +289,7 @@
  * int main() {
  *   OCLStationType stnData;
  *   int stnNum;
+ *   initOCLStation( &stnData );
  *   for( stnNum=0; !feof(stdin) && stnNum<10; stnNum++ ) {
  *     if( getOCLStationData( stdin, stnNum, &stnData, 1, 0, 0, 0, 0, 0, 0, 0,
  *                            0, 0, 0, 0, 0, 0, 0, 0, 0, 0 ) != SUCCESSFUL ) {
@@ -220,6 +299,7 @@
  *     else
  *       printf("Stn %ld Lat=%f Lon=%f\n", stnNum, stnData.lat, stnData.lon);
  *   }
+ *   freeOCLStation( &stnData );
  *   return SUCCESSFUL;
  * }
  *
@@ -230,6 +310,8 @@
  *   gunzip -c nbds1106.gz | tr -d '\r' | exampleprog | more
  */
 
+#define _POSIX_C_SOURCE 199506L  /* for getc_unlocked() with -ansi */
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -237,6 +319,50 @@
 #include <math.h>  /* <-- remember need to specify "-lm" on compile cmd line */
 #include "ocl.h"
 
+/* array of standard-level depths : */
+static const double stdLevelDepth[] = { 0, 10, 20, 30, 50, 75, 100, 125,
+   150, 200, 250, 300, 400, 500, 600, 700, 800, 900, 1000, 1100, 1200,
+   1300, 1400, 1500, 1750, 2000, 2500, 3000, 3500, 4000, 4500, 5000, 5500,
+   6000, 6500, 7000, 7500, 8000, 8500, 9000 };
+static const long int numStdLevels =
+   (long int)(sizeof(stdLevelDepth)/sizeof(stdLevelDepth[0]));
+
+/* an error code as stored in the station (they're single digits, so anything
+   else read for one, ie a bad digit, is kept as a 9 - still flagged) */
+#define OCL_ERR_CODE(e) ( (unsigned char)(((e)>=0 && (e)<=9) ? (e) : 9) )
+
+static int decodeOCLStationSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, int wantProfileFlag, int skipFlag,
+   long int stnToSkipTo, int dbBathyFlag, FILE *fp_dbBathy,
+   const OCLStationFiltersType *filtersIn );
+static void setOCLLevelFlagsAt( OCLStationType *stnData, long int j );
+
+/* Powers of ten for a value's precision digit (10^0 to 10^9 are exact in a
+   double, and the same as pow() gives) - shared with the OCL cache, which
+   rebuilds values the same way (see oclCache.c) */
+const double oclPowersOfTen[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+   1e8, 1e9 };
+
+/* The field decoders and profile loops, compiled once for each kind of byte
+   source (see oclSourcePolicy.h) - getIntDigitsStdio(), getIntDigitsSpan(),
+   readProfileLevelsStdio() etc.  The public functions below look at the
+   source once and hand off to one or the other. */
+#include "oclSourcePolicy.h"
+
+#define OCL_POLICY(name) name##Stdio
+#define OCL_POLICY_GETC(src) OCL_STDIO_GETC(src)
+#define OCL_POLICY_SET_EOF(src) OCL_STDIO_SET_EOF(src)
+#include "oclSourcePolicy.h"
+
+#define OCL_POLICY(name) name##Span
+#define OCL_POLICY_GETC(src) OCL_SPAN_GETC(src)
+#define OCL_POLICY_SET_EOF(src) OCL_SPAN_SET_EOF(src)
+#define OCL_POLICY_DIGIT_RUN(src,numDigits,value) \
+   spanDigitRun(src,numDigits,value)
+#define OCL_POLICY_SKIP_FIELD(src,bytesLeftInStation) \
+   spanSkipField(src,bytesLeftInStation)
+#include "oclSourcePolicy.h"
+
 
 int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
    int wantProfileFlag, int skipFlag, long int stnToSkipTo,
@@ -247,21 +373,287 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
    int monthRangeFlag, long int *monthRange,
    int dbBathyFlag, FILE *fp_dbBathy, int zeroLatLonFlag, char *wmoSquare ) {
 
-   long int j, k, ld_dummy;
-   double lf_dummy;
-   int status=SUCCESSFUL, reallyWantProfile, assignLastProfileDepth=0;
-   static double databaseBathyValue;
-   /* array of standard-level depths : */
-   double stdLevelDepth[] = { 0, 10, 20, 30, 50, 75, 100, 125, 150, 200, 250,
-      300, 400, 500, 600, 700, 800, 900, 1000, 1100, 1200, 1300, 1400, 1500,
-      1750, 2000, 2500, 3000, 3500, 4000, 4500, 5000, 5500, 6000, 6500, 7000,
-      7500, 8000, 8500, 9000 };
+   /* (kept between calls so the line geometry of fp_in is only checked once,
+      see skipToNextStationSrc.  It's checked again from each file's first
+      station, stn 0, rather than only when fp_in changes: a stream fopen'ed
+      after another's fclose often gets the same FILE* back, and mustn't
+      inherit the last file's geometry) */
+   static OCLSourceType src;
+
+   if( src.fp!=fp_in || stn==0 ) setOCLSourceFile( &src, fp_in );
+   return getOCLStationDataSrc( &src, stn, stnData, wantProfileFlag,
+      skipFlag, stnToSkipTo, varListFlag, varList, numVarsOnVarList,
+      minLevelsFlag, minLevels, latlonRegionFlag, latlonRegion,
+      yearRangeFlag, yearRange, monthRangeFlag, monthRange,
+      dbBathyFlag, fp_dbBathy, zeroLatLonFlag, wmoSquare );
+}
+
+
+
+
+
+
+
+/* Same as getOCLStationData() but reads from an OCLSourceType rather than
+   straight from a FILE, so the station can come from a memory-mapped file or
+   a buffer in memory as well as from a stdio stream (see oclSource.c). */
+int getOCLStationDataSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData,
+   int wantProfileFlag, int skipFlag, long int stnToSkipTo,
+   int varListFlag, long int *varList, long int numVarsOnVarList,
+   int minLevelsFlag, long int minLevels,
+   int latlonRegionFlag, double *latlonRegion,
+   int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange,
+   int dbBathyFlag, FILE *fp_dbBathy, int zeroLatLonFlag, char *wmoSquare ) {
+
+   OCLStationFiltersType filters;
+
+   setOCLStationFilters( &filters, varListFlag, varList, numVarsOnVarList,
+      minLevelsFlag, minLevels, latlonRegionFlag, latlonRegion,
+      yearRangeFlag, yearRange, monthRangeFlag, monthRange,
+      zeroLatLonFlag, wmoSquare );
+   return decodeOCLStationSrc( src, stn, stnData, wantProfileFlag,
+      skipFlag, stnToSkipTo, dbBathyFlag, fp_dbBathy, &filters );
+}
+
+
+
+
+
+
+/* "Decode OCL station" - the body of getOCLStationDataSrc(), with its
+   filter args already gathered up into *filtersIn (which is left as is) */
+static int decodeOCLStationSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, int wantProfileFlag, int skipFlag,
+   long int stnToSkipTo, int dbBathyFlag, FILE *fp_dbBathy,
+   const OCLStationFiltersType *filtersIn ) {
+
+   OCLProfileCursorType cursor;
+   OCLStationFiltersType filters;
+   int status;
+   long int e;
+
+
+   /* the last station's secondary header & profile go, unless they're in
+      the caller's arena, which is the caller's to reset */
+   if( stnData->arena==NULL ) resetOCLArena( &(stnData->ownArena) );
+
+   filters = *filtersIn;
+   if( stnData->numFilterExprs>0 ) {
+      filters.expr = stnData->filterExpr;
+      filters.numExprs = stnData->numFilterExprs;
+      filters.exprMatches = stnData->filterExprMatches;
+      for(e=0; e<filters.numExprs; e++)
+         if( filters.expr[e].readyStage > filters.exprReadyStage )
+            filters.exprReadyStage = filters.expr[e].readyStage;
+   }
+   clearOCLStationFilterFlags( stnData );
+
+
+   /* stations in an OCL cache file are already decoded, so just come
+      straight out of its columns (see oclCache.c) */
+   if( src->cacheProfiles!=NULL )
+      return getOCLCacheStationData( src, stn, stnData, wantProfileFlag,
+         skipFlag, stnToSkipTo, dbBathyFlag, fp_dbBathy, &filters );
+
+
+   /* Read the station header, char/PI data & secondary header (or skip the
+      whole station, if not up to stnToSkipTo yet).  Each filter is checked
+      as soon as the header fields it needs are read, and a station that one
+      of them cuts is skipped over right there, with only its header fields
+      up to that point read and that filter's flag saying why. */
+   status = readOCLStationHeaderSrc( src, stn, stnData, skipFlag,
+      stnToSkipTo, dbBathyFlag, fp_dbBathy, &filters );
+   if( status==FILTERED_OUT ) return SUCCESSFUL;
+   if( status!=SUCCESSFUL ) return status;
+
+
+   /* Interlude before reading profile to assign and calculate bottomDepth
+    * values, and to decide whether or not to read rest of station for profile
+    * (both done in functions below, which the OCL cache reader shares)
+    */
+   setOCLBottomDepth( stnData, stn, dbBathyFlag, fp_dbBathy );
+
+
+
+
+   /* Go ahead and read rest of station if our criteria is met (the
+      filters already were, as the header was read) */
+   if( checkOCLStationFilters( stnData, wantProfileFlag, NULL ) ) {
+
+      if( startOCLProfileSrc( src, stn, stnData, &cursor ) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+
+      /* (if it's just for the bottom depth, hop over the levels above the
+         deepest one without decoding them) */
+      if( wantProfileFlag==OCL_PROFILE_LAST_LEVEL )
+         skipOCLProfileLevels( &cursor, cursor.numLevels-1 );
+      readOCLProfileLevels( &cursor, -1 );
+
+      /* recheck bottomDepth value against lowest profile depth */
+      checkOCLBottomDepth( stnData, dbBathyFlag );
+
+
+   } /* done reading rest of profile */
+
+
+   /* even at end of station, still need to do this to get past any remaining
+      white space till end of line */
+   skipToNextStationSrc( src, stnData->bytesLeftInStation);
+
+   return SUCCESSFUL;
+
+} /* end of decodeOCLStationSrc */
+
+
+
+
+
+
+
+/* "Init OCL decoder" - start off a decoder with no source, no bathy file,
+   no filters, and its station in its own arena at station 0.  Then the
+   caller sets up dec->src (setOCLSourceFile(), mapOCLSource() etc), and
+   dec->fp_dbBathy, dec->filters (setOCLStationFilters()) and dec->stnData's
+   projection and filter expressions if wanted, and decodes stations in
+   turn with decodeOCLStation(). */
+void initOCLDecoder( OCLDecoderType *dec ) {
+
+   memset( &(dec->src), 0, sizeof(dec->src) );
+   dec->fp_dbBathy = NULL;
+   setOCLStationFilters( &(dec->filters), 0, NULL, 0, 0, 0, 0, NULL, 0, NULL,
+      0, NULL, 0, NULL );
+   dec->stn = 0;
+   initOCLStation( &(dec->stnData) );
+   dec->bottomDepth = nan();
+   dec->bottomDepthSource = '-';
+}
+
+
+
+
+
+
+/* "Decode OCL station" - getOCLStationDataSrc() for a decoder: decode the
+   next station of dec->src into dec->stnData, with dec's filters (and
+   stepping dec->fp_dbBathy along with it, if set), and put its bottom depth
+   in dec->bottomDepth.  Returns as getOCLStationDataSrc() does, or
+   OCL_DECODER_END with nothing read once the source is used up. */
+int decodeOCLStation( OCLDecoderType *dec, int wantProfileFlag ) {
+
+   int status;
+
+   if( endOfOCLSource( &(dec->src) ) ) return OCL_DECODER_END;
+
+   status = decodeOCLStationSrc( &(dec->src), dec->stn, &(dec->stnData),
+      wantProfileFlag, 0, 0,
+      dec->fp_dbBathy!=NULL || dec->stnData.bathy!=NULL, dec->fp_dbBathy,
+      &(dec->filters) );
+   dec->stn++;
+   dec->bottomDepth = getOCLBottomDepth( &(dec->stnData) );
+   dec->bottomDepthSource = dec->stnData.bottomDepthSource;
+   return status;
+}
+
+
+
+
+
+
+/* "Free OCL decoder" - release the decoder's station arena, and its source's
+   span if it mapped or loaded one (streams are left to the caller to close,
+   as with closeOCLSource()) */
+void freeOCLDecoder( OCLDecoderType *dec ) {
+   freeOCLStation( &(dec->stnData) );
+   closeOCLSource( &(dec->src) );
+}
+
+
+
+
+
+
+/* "Get OCL station header" - for reading a profile a level at a time, or
+   only partly: read the next station's headers from src into stnData (no
+   filters, and the bottom depth only from the secondary header), and set up
+   cursor at the start of its profile.  Then readOCLProfileLevels() decodes
+   the next so many levels, skipOCLProfileLevels() hops over them without
+   decoding, and finishOCLStation() goes on to the next station, however
+   much of the profile was read - eg
+      getOCLStationHeader( &src, i, &stnData, &cursor );
+      readOCLProfileLevels( &cursor, 10 );      <- the top 10 levels
+      finishOCLStation( &cursor );
+   The profile arrays are sized to the whole profile, but only the levels
+   read hold values (and count in levelFlags & anyLevelFlagged). */
+int getOCLStationHeader( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor ) {
+
+   int status;
+
+   if( stnData->arena==NULL ) resetOCLArena( &(stnData->ownArena) );
+
+   if( src->cacheProfiles!=NULL )
+      return getOCLCacheStationHeader( src, stn, stnData, cursor );
+
+   status = readOCLStationHeaderSrc( src, stn, stnData, 0, 0, 0, NULL,
+      NULL );
+   if( status!=SUCCESSFUL ) return status;
+   setOCLBottomDepth( stnData, stn, 0, NULL );
+   return startOCLProfileSrc( src, stn, stnData, cursor );
+}
+
+
+
+
+
+
+/* "Cut OCL station" - a filter has cut the station partway through its
+   header: skip over the rest of it undecoded (and its line in the bathy
+   file, if using one) */
+static int cutOCLStationSrc( OCLSourceType *src, OCLStationType *stnData,
+   int dbBathyFlag, FILE *fp_dbBathy ) {
+
+   if( stnData->filterCounts!=NULL )
+      stnData->filterCounts->bytesSkipped += stnData->bytesLeftInStation;
+   skipToNextStationSrc( src, stnData->bytesLeftInStation );
+   skipOCLBathyLine( stnData, dbBathyFlag, fp_dbBathy );
+   stnData->bottomDepthPtr = NULL;
+   stnData->bottomDepthSource = '-';
+   return FILTERED_OUT;
+}
+
+
+
+
+
+
+/* "Read OCL station header" - the first part of getOCLStationDataSrc():
+   the station's header fields, its char/PI data (skipped over) and its
+   secondary header.  Returns SKIPPED, having skipped the whole station, if
+   skipFlag is set and stn isn't up to stnToSkipTo yet.  And if filters
+   isn't NULL, each one is checked as soon as the fields it needs are read,
+   and if it cuts the station the rest is skipped over and FILTERED_OUT
+   returned. */
+int readOCLStationHeaderSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, int skipFlag, long int stnToSkipTo,
+   int dbBathyFlag, FILE *fp_dbBathy, OCLStationFiltersType *filters ) {
+
+   long int j, ld_dummy;
+   int status=SUCCESSFUL;
 
 
    /* first two fields of station tell how many bytes in station,
       so for now must flag bytesLeftInStation as unusable */
    stnData->bytesLeftInStation=-1;
 
+   /* (nothing of the last station's left to be mistaken for this one's, if
+      it's cut before these are read) */
+   stnData->numberOfVarCodes=0;
+   stnData->numberOfSecHdrEntries=0;
+   stnData->secHdrCode=NULL;
+   stnData->secHdrValue=NULL;
+
 
    /* The byte-reading sequence below can be understood by comparing it
       line-for-line with the NODC OCL format.txt (included with WOD98),
@@ -270,66 +662,76 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
 
    /* Read station header : */
 
-   if( getVarlenIntField( fp_in, &(stnData->bytesInStation),
+   if( getVarlenIntFieldSrc( src, &(stnData->bytesInStation),
       &(stnData->bytesLeftInStation) ) == ZERO_LENGTH_FIELD )
       stnData->bytesInStation=0;
 
-   if( getVarlenIntField( fp_in, &(stnData->oclStationNumber),
+   if( getVarlenIntFieldSrc( src, &(stnData->oclStationNumber),
       &(stnData->bytesLeftInStation) ) == ZERO_LENGTH_FIELD )
       stnData->oclStationNumber=-1;
 
    if( skipFlag && stn<stnToSkipTo ) {
-     skipToNextStation( fp_in, stnData->bytesLeftInStation);
+     skipToNextStationSrc( src, stnData->bytesLeftInStation);
      /* if using bathy file, skip past line in there, too */
-     if( dbBathyFlag ) {
-       fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
-            &ld_dummy, &lf_dummy );
-     }
+     skipOCLBathyLine( stnData, dbBathyFlag, fp_dbBathy );
      return SKIPPED;
    }
 
-   if( getIntDigits( fp_in, 2, &(stnData->countryCode) ) == ZERO_LENGTH_FIELD)
+   if( getIntDigitsSrc( src, 2, &(stnData->countryCode) ) == ZERO_LENGTH_FIELD)
      stnData->countryCode=-1;
    stnData->bytesLeftInStation-=2;
 
-   if( getVarlenIntField( fp_in, &(stnData->cruiseNumber),
+   if( getVarlenIntFieldSrc( src, &(stnData->cruiseNumber),
       &(stnData->bytesLeftInStation) ) == ZERO_LENGTH_FIELD)
      stnData->cruiseNumber=-1;
 
-   getIntDigits( fp_in, 4, &(stnData->year) );
+   getIntDigitsSrc( src, 4, &(stnData->year) );
    stnData->bytesLeftInStation-=4;
+   if( !checkOCLFilterStage( stnData, filters, OCL_FILTER_YEAR ) )
+      return cutOCLStationSrc( src, stnData, dbBathyFlag, fp_dbBathy );
 
-   getIntDigits( fp_in, 2, &(stnData->month) );
+   getIntDigitsSrc( src, 2, &(stnData->month) );
    stnData->bytesLeftInStation-=2;
 
-   getIntDigits( fp_in, 2, &(stnData->day) );
+   getIntDigitsSrc( src, 2, &(stnData->day) );
    stnData->bytesLeftInStation-=2;
+   if( !checkOCLFilterStage( stnData, filters, OCL_FILTER_MONTH ) )
+      return cutOCLStationSrc( src, stnData, dbBathyFlag, fp_dbBathy );
 
-   getVarlenFloatField( fp_in, &(stnData->time),
+   getVarlenFloatFieldSrc( src, &(stnData->time),
       &(stnData->bytesLeftInStation) );
 
-   getVarlenFloatField(fp_in, &(stnData->lat), &(stnData->bytesLeftInStation));
+   getVarlenFloatFieldSrc( src, &(stnData->lat),
+      &(stnData->bytesLeftInStation) );
 
-   getVarlenFloatField(fp_in, &(stnData->lon), &(stnData->bytesLeftInStation));
+   getVarlenFloatFieldSrc( src, &(stnData->lon),
+      &(stnData->bytesLeftInStation) );
+   if( !checkOCLFilterStage( stnData, filters, OCL_FILTER_LATLON ) ||
+       !checkOCLFilterStage( stnData, filters, OCL_FILTER_ZERO_LATLON ) )
+      return cutOCLStationSrc( src, stnData, dbBathyFlag, fp_dbBathy );
 
-   if( getVarlenIntField( fp_in, &(stnData->numberOfLevels),
+   if( getVarlenIntFieldSrc( src, &(stnData->numberOfLevels),
       &(stnData->bytesLeftInStation) ) == ZERO_LENGTH_FIELD)
      stnData->numberOfLevels=0;
+   if( !checkOCLFilterStage( stnData, filters, OCL_FILTER_MIN_LEVELS ) )
+      return cutOCLStationSrc( src, stnData, dbBathyFlag, fp_dbBathy );
 
-   getIntDigits( fp_in, 1, &(stnData->stationType) );
+   getIntDigitsSrc( src, 1, &(stnData->stationType) );
    stnData->bytesLeftInStation-=1;
 
-   getIntDigits( fp_in, 2, &(stnData->numberOfVarCodes) );
+   getIntDigitsSrc( src, 2, &(stnData->numberOfVarCodes) );
    stnData->bytesLeftInStation-=2;
 
    for(j=0; j<stnData->numberOfVarCodes; j++) {
      /* varCodes are the data column descriptors, eg 1=temp, 2=sal, etc.
         as defined in Table 4 in the NODC OCL readmev1 doc */
-     getVarlenIntField( fp_in, &(stnData->varCode[j]),
+     getVarlenIntFieldSrc( src, &(stnData->varCode[j]),
         &(stnData->bytesLeftInStation) );
-     getIntDigits( fp_in, 1, &(stnData->errCodeForVarCode[j]) );
+     getIntDigitsSrc( src, 1, &(stnData->errCodeForVarCode[j]) );
      stnData->bytesLeftInStation-=1;
    }
+   if( !checkOCLFilterStage( stnData, filters, OCL_FILTER_VAR_LIST ) )
+      return cutOCLStationSrc( src, stnData, dbBathyFlag, fp_dbBathy );
 
 
 
@@ -338,13 +740,13 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
    /* (note this section has some char data - would need to write a
       getCharField function if I decided to actually take data from here) */
 
-   status = getVarlenIntField( fp_in, &(stnData->bytesInCharPI),
+   status = getVarlenIntFieldSrc( src, &(stnData->bytesInCharPI),
       &(stnData->bytesLeftInStation) );
 
    if( status != ZERO_LENGTH_FIELD ) {
       /* skipping rest of this section for now */
       for(j=0; j<stnData->bytesInCharPI; j++) {
-         getIntDigits( fp_in, 1, &ld_dummy );
+         getIntDigitsSrc( src, 1, &ld_dummy );
          stnData->bytesLeftInStation-=1;
       }
    }
@@ -354,13 +756,22 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
 
    /* Read secondary header : */
 
-   status = getVarlenIntField( fp_in, &(stnData->bytesInSecHdr),
+   status = getVarlenIntFieldSrc( src, &(stnData->bytesInSecHdr),
       &(stnData->bytesLeftInStation) );
 
    if( status != ZERO_LENGTH_FIELD ) {
 
-      getVarlenIntField( fp_in, &(stnData->numberOfSecHdrEntries),
-         &(stnData->bytesLeftInStation) );
+      if( getVarlenIntFieldSrc( src, &(stnData->numberOfSecHdrEntries),
+         &(stnData->bytesLeftInStation) ) == ZERO_LENGTH_FIELD )
+        stnData->numberOfSecHdrEntries=0;
+
+      if( allocOCLStationSecHdr( stnData, stnData->numberOfSecHdrEntries )
+          != SUCCESSFUL ) {
+         fprintf(stderr, "%% getOCLStationData: error: not enough memory for"
+            " stn %ld's %ld secondary header entries.\n", stn,
+            stnData->numberOfSecHdrEntries);
+         return UNSPECIFIED_PROBLEM;
+      }
 
       for(j=0; j<stnData->numberOfSecHdrEntries; j++) {
 
@@ -368,10 +779,10 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
             eg 10=bottom depth, 18=sea state, etc.
             as defined in Table 6 in the NODC OCL readmev1 doc */
 
-         getVarlenIntField( fp_in, &(stnData->secHdrCode[j]),
+         getVarlenIntFieldSrc( src, &(stnData->secHdrCode[j]),
             &(stnData->bytesLeftInStation) );
 
-         getVarlenFloatField( fp_in, &(stnData->secHdrValue[j]),
+         getVarlenFloatFieldSrc( src, &(stnData->secHdrValue[j]),
             &(stnData->bytesLeftInStation) );
       }
    }
@@ -380,13 +791,161 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
       stnData->numberOfSecHdrEntries=0;
    }
 
+   return SUCCESSFUL;
+}
 
 
-   /* Interlude before reading profile to assign and calculate bottomDepth
-    * values, and to decide whether or not to read rest of station for profile
-    */
 
 
+
+
+/* "Start OCL profile" - the rest of the station's headers before its
+   profile (the bio header, skipped over), then make room for the profile
+   in the station's arena and point cursor at its first level */
+int startOCLProfileSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor ) {
+
+   long int j, ld_dummy;
+   int status;
+
+   /* Read biological header : */
+   status = getVarlenIntFieldSrc( src, &(stnData->bytesInBioHdr),
+      &(stnData->bytesLeftInStation) );
+
+   if ( status != ZERO_LENGTH_FIELD ) {
+      /* skipping rest of this section for now */
+      for(j=0; j<stnData->bytesInBioHdr; j++) {
+         getIntDigitsSrc( src, 1, &ld_dummy);
+         stnData->bytesLeftInStation-=1;
+      }
+   }
+   else stnData->bytesInBioHdr=0;
+
+
+
+   /* Read taxonomic and biomass data : */
+   /* (skipped already by virtue of the fact that all the bio data is
+       skipped from within the above bio-hdr section - but here's a place-
+       holder/reminder for future expansion) */
+
+
+
+   /* Profile data : */
+
+   /* size the profile arrays to this station, in its arena */
+   if( allocOCLStationProfile( stnData, stnData->numberOfLevels,
+          stnData->numberOfVarCodes ) != SUCCESSFUL ) {
+      fprintf(stderr, "%% getOCLStationData: error: not enough memory for"
+         " stn %ld's %ld levels.\n", stn, stnData->numberOfLevels);
+      return UNSPECIFIED_PROBLEM;
+   }
+   stnData->anyLevelFlagged=0;
+
+   cursor->src = src;
+   cursor->stnData = stnData;
+   cursor->level = 0;
+   cursor->numLevels = (stnData->numberOfLevels>0) ? stnData->numberOfLevels :
+      0;
+   cursor->cacheMantissas = NULL;
+   cursor->cachePrecisions = NULL;
+   cursor->cacheErrCodes = NULL;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+
+
+/* "Read OCL profile levels" - decode the next numLevels levels of the
+   profile at cursor (or all the rest if numLevels<0, or if there aren't
+   that many left) into the station's profile arrays */
+int readOCLProfileLevels( OCLProfileCursorType *cursor, long int numLevels ) {
+
+   OCLStationType *stnData = cursor->stnData;
+   long int j, k, n=cursor->numLevels, endLevel;
+
+   endLevel = cursor->level + numLevels;
+   if( numLevels<0 || endLevel>n ) endLevel = n;
+
+   /* (a cache's columns just get copied out - see oclCache.c) */
+   if( cursor->cacheMantissas!=NULL ) {
+      for(j=cursor->level; j<endLevel; j++) {
+         getOCLCacheValues( cursor->cacheMantissas, cursor->cacheMantissaSize,
+            cursor->cachePrecisions, j, 1, &(stnData->depthValue[j]) );
+         stnData->errCodeForDepthValue[j] = cursor->cacheErrCodes[j];
+         for(k=0; k<stnData->numberOfVarCodes; k++) {
+            if( !(stnData->decodedVars & OCL_VAR_BIT(k)) ) continue;
+            getOCLCacheValues( cursor->cacheMantissas,
+               cursor->cacheMantissaSize, cursor->cachePrecisions, (k+1)*n+j,
+               1, &(stnData->varValue[k][j]) );
+            stnData->errCodeForVarValue[k][j] =
+               cursor->cacheErrCodes[(k+1)*n+j];
+         }
+         setOCLLevelFlagsAt( stnData, j );
+      }
+   }
+   else if( cursor->src->fp!=NULL ) readProfileLevelsStdio( cursor, endLevel );
+   else readProfileLevelsSpan( cursor, endLevel );
+
+   cursor->level = endLevel;
+   return SUCCESSFUL;
+}
+
+
+
+
+
+
+/* "Skip OCL profile levels" - move cursor past the next numLevels levels
+   (or all the rest if numLevels<0) without decoding them - just their
+   digit counts are read, to know how many digits to step over */
+int skipOCLProfileLevels( OCLProfileCursorType *cursor, long int numLevels ) {
+
+   long int endLevel;
+
+   endLevel = cursor->level + numLevels;
+   if( numLevels<0 || endLevel>cursor->numLevels ) endLevel = cursor->numLevels;
+
+   if( cursor->cacheMantissas==NULL ) {
+      if( cursor->src->fp!=NULL ) skipProfileLevelsStdio( cursor, endLevel );
+      else skipProfileLevelsSpan( cursor, endLevel );
+   }
+
+   if( endLevel>cursor->level ) cursor->level = endLevel;
+   return SUCCESSFUL;
+}
+
+
+
+
+
+
+/* "Finish OCL station" - done with the station at cursor, however much of
+   its profile was read: go on to the start of the next station */
+int finishOCLStation( OCLProfileCursorType *cursor ) {
+   if( cursor->cacheMantissas!=NULL ) return SUCCESSFUL; /* (already there) */
+   return skipToNextStationSrc( cursor->src,
+      cursor->stnData->bytesLeftInStation );
+}
+
+
+
+
+
+
+/* "Set OCL bottom depth" - first pick of the station's bottom depth (see
+   bottomDepthPtr in ocl.h), from its secondary header or the bathy database,
+   made right after the headers are read in case the profile isn't read.
+   stn is the station's number in its file, for a bathy sidecar. */
+void setOCLBottomDepth( OCLStationType *stnData, long int stn,
+   int dbBathyFlag, FILE *fp_dbBathy ) {
+
+   long int j, ld_dummy;
+   double lf_dummy;
+   int inDomain;
+
    /* Get bottomDepth values now, in case we don't read rest of station : */
 
       /* initializing bottomDepth elements */
@@ -401,35 +960,273 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
             stnData->bottomDepthSource='h';
          }
 
-      /* if we're using the dbBathy file, read/increment the file pointer, and
-         reassign bottomDepth from the dbBathy file if we want it.  (otherwise
-         the bottomDepth from header will remain) */
+      /* if we're using the bathy database, look the value up in the grid
+         or sidecar or read/increment the file pointer, and reassign
+         bottomDepth from it if we want it.  (otherwise the bottomDepth from
+         header will remain) */
       if( dbBathyFlag ) {
-         /* Get the bathy value for current lat/lon from bathy file.  Note
-            there should one line in bathy file for each station in the
-            input file - for my use, the file is created automatically in the
-            shell script processOcean, using outputAllLatsLons & grdtrack.  */
-         fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
-            &ld_dummy, &databaseBathyValue );
-         databaseBathyValue *= -1;        /* (converting neg depths to pos) */
-
-         /* set bottomDepthPtr as databaseBathyValue if:
+         if( stnData->bathy!=NULL &&
+             stnData->bathy->kind==OCL_BATHY_SIDECAR ) {
+            /* The station's own record in the sidecar (see oclBathy.c),
+               which doesn't depend on which stations were read before it -
+               NaN if it has none.  Its domain is also within the lat limit
+               of the database it was made from. */
+            stnData->dbBathy = lookupOCLBathyStation( stnData->bathy, stn );
+            inDomain = stnData->dbBathy==stnData->dbBathy &&
+               fabs(stnData->lat)<=stnData->bathy->latLimit;
+         }
+         else if( stnData->bathy!=NULL ) {
+            /* Interpolate the bathy value at current lat/lon from the grid
+               (see oclBathy.c) - NaN if it's off the grid, which is then
+               the grid's domain */
+            lookupOCLBathy( stnData->bathy, 1, &(stnData->lat),
+               &(stnData->lon), &(stnData->dbBathy) );
+            inDomain = stnData->dbBathy==stnData->dbBathy;
+         }
+         else {
+            /* Get the bathy value for current lat/lon from bathy file.  Note
+               there should one line in bathy file for each station in the
+               input file - for my use, the file is created automatically in
+               the shell script processOcean, using outputAllLatsLons &
+               grdtrack.  */
+            fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
+               &ld_dummy, &(stnData->dbBathy) );
+            inDomain = stnData->lat<=72. && stnData->lat>=-72.;
+         }
+         stnData->dbBathy *= -1;        /* (converting neg depths to pos) */
+
+         /* set bottomDepthPtr as stnData->dbBathy if:
             we're in domain of dbBathy, and:
                no hdrDepth available, or
                hdrDepth available, but diff between hdrDepth value and dbBathy
                   value is to big. */
-         if( stnData->lat<=72. && stnData->lat>=-72. ) {
+         if( inDomain ) {
             if( stnData->bottomDepthSource!='h' ||
-                (-80 > *(stnData->bottomDepthPtr)-databaseBathyValue) ||
-                (*(stnData->bottomDepthPtr)-databaseBathyValue > 80 )    ) {
-               stnData->bottomDepthPtr = &databaseBathyValue;
+                (-80 > *(stnData->bottomDepthPtr)-stnData->dbBathy) ||
+                (*(stnData->bottomDepthPtr)-stnData->dbBathy > 80 )    ) {
+               stnData->bottomDepthPtr = &(stnData->dbBathy);
                stnData->bottomDepthSource = 'd';
             }
          }
       }
 
+}
+
+
 
 
+
+
+
+/* "Get OCL bottom depth" - the station's bottom depth (see bottomDepthPtr
+   in ocl.h) by value, or NaN if it has none.  Unlike bottomDepthPtr, the
+   value stays good after the next station is read into stnData. */
+double getOCLBottomDepth( OCLStationType *stnData ) {
+   if( stnData->bottomDepthPtr==NULL ) return nan();
+   return *(stnData->bottomDepthPtr);
+}
+
+
+
+
+
+
+
+/* "Set OCL station filters" - gather getOCLStationData()'s filter args up
+   into filters, for checking a stage at a time */
+void setOCLStationFilters( OCLStationFiltersType *filters,
+   int varListFlag, long int *varList, long int numVarsOnVarList,
+   int minLevelsFlag, long int minLevels,
+   int latlonRegionFlag, double *latlonRegion,
+   int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange,
+   int zeroLatLonFlag, char *wmoSquare ) {
+
+   filters->yearRangeFlag = yearRangeFlag;
+   filters->yearRange = yearRange;
+   filters->monthRangeFlag = monthRangeFlag;
+   filters->monthRange = monthRange;
+   filters->latlonRegionFlag = latlonRegionFlag;
+   filters->latlonRegion = latlonRegion;
+   filters->zeroLatLonFlag = zeroLatLonFlag;
+   filters->wmoSquare = wmoSquare;
+   filters->minLevelsFlag = minLevelsFlag;
+   filters->minLevels = minLevels;
+   filters->varListFlag = varListFlag;
+   filters->varList = varList;
+   filters->numVarsOnVarList = numVarsOnVarList;
+   filters->expr = NULL;
+   filters->numExprs = 0;
+   filters->exprMatches = NULL;
+   filters->exprReadyStage = OCL_FILTER_YEAR;
+}
+
+
+
+
+
+
+
+/* "Clear OCL station filter flags" - set all the station's filter flags to
+   passing, as they're left for the filters that aren't checked (because
+   they're not in use, or an earlier one already cut the station) */
+void clearOCLStationFilterFlags( OCLStationType *stnData ) {
+
+   long int e;
+
+   stnData->yearInRange = 1;
+   stnData->monthInRange = 1;
+   stnData->latlonInRange = 1;
+   stnData->badLatLon = 0;
+   stnData->enoughProfileLevels = 1;
+   stnData->varListChecksOut = 1;
+   stnData->exprPasses = 1;
+   for(e=0; stnData->filterExprMatches!=NULL && e<stnData->numFilterExprs; e++)
+      stnData->filterExprMatches[e] = 1;
+}
+
+
+
+
+
+
+
+/* "Check OCL filter" - checkOCLFilterStage() for just the one filter */
+static int checkOCLFilter( OCLStationType *stnData,
+   OCLStationFiltersType *filters, int stage ) {
+
+   int pass=1, match;
+   long int e;
+
+   switch( stage ) {
+
+      /* Won't need rest of station if we're filtering out year values and
+         the current one isn't in yearRange */
+      case OCL_FILTER_YEAR:
+         if( !filters->yearRangeFlag ) return 1;
+         pass = stnData->year >= filters->yearRange[0] &&
+            stnData->year <= filters->yearRange[1];
+         stnData->yearInRange = pass;
+         break;
+
+      /* Won't need rest of station if we're filtering out month values and
+         the current one isn't in monthRange (which can wrap around new
+         year) */
+      case OCL_FILTER_MONTH:
+         if( !filters->monthRangeFlag ) return 1;
+         pass = inOCLCyclicRange(stnData->month, filters->monthRange);
+         stnData->monthInRange = pass;
+         break;
+
+      /* Won't need rest of station if we're filtering out Lat/Lon values
+         and the current ones aren't in latlonRegion */
+      case OCL_FILTER_LATLON:
+         if( !filters->latlonRegionFlag ) return 1;
+         pass = !(stnData->lon < filters->latlonRegion[0] ||
+                  stnData->lon > filters->latlonRegion[1] ||
+                  stnData->lat < filters->latlonRegion[2] ||
+                  stnData->lat > filters->latlonRegion[3]);
+         stnData->latlonInRange = pass;
+         break;
+
+      /* Won't need rest of station if we're filtering out bad Lat/Lon values
+         and we find zero-values for lat or lon when we're not on the equator
+         or prime meridian (respectively).  We check this merely by looking
+         at the wmo-square value that was specified on the command line. */
+      case OCL_FILTER_ZERO_LATLON:
+         if( !filters->zeroLatLonFlag ) return 1;
+         stnData->badLatLon=0;
+         /* (remember can't rely on doubles being exactly equal...) */
+         if( stnData->lat<0.0000001 && stnData->lat>-0.0000001 ) {  /*if zero*/
+            stnData->badLatLon += !zeroLatLonOkay( filters->wmoSquare, "lat" );
+         }
+         if( stnData->lon<0.0000001 && stnData->lon>-0.0000001 ) {  /*if zero*/
+            stnData->badLatLon += !zeroLatLonOkay( filters->wmoSquare, "lon" );
+         }
+         pass = !stnData->badLatLon;
+         break;
+
+      /* Won't need rest of station if we're filtering out stations based on
+         minimum number of profile levels, and current one doesn't have that
+         many */
+      case OCL_FILTER_MIN_LEVELS:
+         if( !filters->minLevelsFlag ) return 1;
+         pass = stnData->numberOfLevels >= filters->minLevels;
+         stnData->enoughProfileLevels = pass;
+         break;
+
+      /* Won't need rest of station if varList isn't covered and error-free:
+         checking if station vars include those on varList, and have no
+         errors covering the whole variable column */
+      case OCL_FILTER_VAR_LIST:
+         if( !filters->varListFlag ) return 1;
+         pass = checkVarsInclAndNoErrors( filters->varList,
+            stnData->varCode, stnData->errCodeForVarCode,
+            filters->numVarsOnVarList, stnData->numberOfVarCodes);
+         stnData->varListChecksOut = pass;
+         break;
+
+      /* Won't need rest of station if it doesn't satisfy the filter
+         expression (see oclExpr.c) - or with several, any of them, each
+         one's result going in exprMatches[] if the caller wants them */
+      case OCL_FILTER_EXPR:
+         if( filters->expr==NULL ) return 1;
+         pass = 0;
+         for(e=0; e<filters->numExprs; e++) {
+            match = evalOCLExpr( &(filters->expr[e]), stnData );
+            if( match ) pass = 1;
+            if( filters->exprMatches!=NULL ) filters->exprMatches[e] = match;
+            else if( pass ) break;  /* (no need to try the rest) */
+         }
+         stnData->exprPasses = pass;
+         break;
+   }
+
+   if( stnData->filterCounts!=NULL ) {
+      stnData->filterCounts->numChecked[stage]++;
+      if( !pass ) stnData->filterCounts->numCut[stage]++;
+   }
+   return pass;
+}
+
+
+
+
+
+
+
+/* "Check OCL filter stage" - check the station against one of the filters
+   (stage is an OCL_FILTER_...), once the header fields it needs have been
+   read - and against the filter expression too, if those are the last
+   fields it needs: set the station's flags for them, and return false if
+   either cuts the station.  Filters not in use (or a NULL filters) pass
+   everything, and aren't counted in the station's filterCounts. */
+int checkOCLFilterStage( OCLStationType *stnData,
+   OCLStationFiltersType *filters, int stage ) {
+
+   if( filters==NULL ) return 1;
+   if( !checkOCLFilter( stnData, filters, stage ) ) return 0;
+   if( filters->expr!=NULL && filters->exprReadyStage==stage )
+      return checkOCLFilter( stnData, filters, OCL_FILTER_EXPR );
+   return 1;
+}
+
+
+
+
+
+
+
+/* "Check OCL station filters" - check the station's headers against all the
+   filters in turn, stopping at the first one that cuts it (or none, if
+   filters is NULL because they were checked as the header was read), and
+   return true if the rest of the station (the profile) needs to be read, ie
+   we want the profile and no filter has cut the station */
+int checkOCLStationFilters( OCLStationType *stnData, int wantProfileFlag,
+   OCLStationFiltersType *filters ) {
+
+   int stage;
+
    /* Deciding whether to read rest of station */
 
       /* Reading the rest of the station (including profile) is conditional
@@ -437,227 +1234,326 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
          specify that we aren't interested in the profile, or perhaps we've
          found that the list of required variables isn't covered, so we don't
          want this station. (Skipping saves a bunch of comp & I/O time...) */
-   
-      /* Won't need rest of station if varList isn't covered and error-free */
-      if( varListFlag ) {
-         /* checking if station vars include those on varList, and have no
-            errors covering the whole variable column */
-         stnData->varListChecksOut = checkVarsInclAndNoErrors( varList, 
-            stnData->varCode, stnData->errCodeForVarCode, numVarsOnVarList,
-            stnData->numberOfVarCodes);
-      }
-      else stnData->varListChecksOut = 1;
-   
+      for(stage=0; stage<OCL_FILTER_EXPR; stage++)  /* (expr goes w/ one) */
+         if( !checkOCLFilterStage( stnData, filters, stage ) ) return 0;
+
       /* Won't need rest of station if we specified we don't want the profile.
          But even if we don't want profile, if bottomDepth still has not been
          set from either the Secondary Hdr or from the bathy database, we must
          read profile in order to assign last profile depth to bottomDepth */
-      if(!wantProfileFlag && stnData->bottomDepthPtr!=NULL)
-         reallyWantProfile=0;
-      else reallyWantProfile=1;
-
-      /* Won't need rest of station if we're filtering out Lat/Lon values and
-         the current ones aren't in latlonRegion */
-      if( latlonRegionFlag && 
-          (stnData->lon < latlonRegion[0] ||
-           stnData->lon > latlonRegion[1] ||
-           stnData->lat < latlonRegion[2] ||
-           stnData->lat > latlonRegion[3] )  )
-         stnData->latlonInRange=0;
-      else stnData->latlonInRange=1;
-
-      /* Won't need rest of station if we're filtering out year values and the
-         current one isn't in yearRange */
-      if( yearRangeFlag &&
-          (stnData->year < yearRange[0] || stnData->year > yearRange[1]) )
-         stnData->yearInRange=0;
-      else stnData->yearInRange=1;
-
-      /* Won't need rest of station if we're filtering out month values and the
-         current one isn't in monthRange */
-      if( monthRangeFlag &&
-          (stnData->month < monthRange[0] || stnData->month > monthRange[1]) )
-         stnData->monthInRange=0;
-      else stnData->monthInRange=1;
+      if(!wantProfileFlag && stnData->bottomDepthPtr!=NULL) return 0;
 
-      /* Won't need rest of station if we're filtering out stations based on
-         minimum number of profile levels, and current one doesn't have that
-         many */
-      if( minLevelsFlag && stnData->numberOfLevels<minLevels )
-         stnData->enoughProfileLevels=0;
-      else stnData->enoughProfileLevels=1;
+   return 1;
+}
 
-      /* Won't need rest of station if we're filtering out bad Lat/Lon values
-         and we find zero-values for lat or lon when we're not on the equator
-         or prime meridian (respectively).  We check this merely by looking at
-         the wmo-square value that was specified on the command line. */
-      stnData->badLatLon=0;
-      if( zeroLatLonFlag ) {
-         /* (remember can't rely on doubles being exactly equal...) */
-         if( stnData->lat<0.0000001 && stnData->lat>-0.0000001 ) {  /*if zero*/
-            stnData->badLatLon += !zeroLatLonOkay( wmoSquare, "lat" );
-         }
-         if( stnData->lon<0.0000001 && stnData->lon>-0.0000001 ) {  /*if zero*/
-            stnData->badLatLon += !zeroLatLonOkay( wmoSquare, "lon" );
-         }
-      }
 
 
 
 
-   /* Go ahead and read rest of station if our criteria is met */
-   if( reallyWantProfile && stnData->varListChecksOut && !stnData->badLatLon &&
-      stnData->latlonInRange && stnData->monthInRange && stnData->yearInRange
-      && stnData->enoughProfileLevels ) {
 
-      /* Read biological header : */
-      status = getVarlenIntField( fp_in, &(stnData->bytesInBioHdr),
-         &(stnData->bytesLeftInStation) );
 
-      if ( status != ZERO_LENGTH_FIELD ) {
-         /* skipping rest of this section for now */
-         for(j=0; j<stnData->bytesInBioHdr; j++) {
-            getIntDigits( fp_in, 1, &ld_dummy);
-            stnData->bytesLeftInStation-=1;
-         }
-      }
-      else stnData->bytesInBioHdr=0;
+/* "Report OCL filter counts" - a comment line for fp with how many stations
+   each filter stage in use checked and cut, and the bytes of the cut ones
+   that were skipped over without being decoded */
+void reportOCLFilterCounts( OCLFilterCountsType *counts, FILE *fp,
+   char *label ) {
 
+   static const char *option[OCL_NUM_FILTERS] =
+      { "-y", "-m", "-l", "-w", "-p", "-v", "-x" };
+   int stage;
 
+   fprintf(fp, "%% %s: filters:", label);
+   for(stage=0; stage<OCL_NUM_FILTERS; stage++)
+      if( counts->numChecked[stage]>0 )
+         fprintf(fp, " %s cut %ld of %ld,", option[stage],
+            counts->numCut[stage], counts->numChecked[stage]);
+   fprintf(fp, " %ld bytes skipped undecoded\n", counts->bytesSkipped);
+}
 
-      /* Read taxonomic and biomass data : */
-      /* (skipped already by virtue of the fact that all the bio data is
-          skipped from within the above bio-hdr section - but here's a place-
-          holder/reminder for future expansion) */
 
 
 
-      /* Read profile data : */
 
-      /* make sure profile will fit in memory set aside for it */
-      /* (this should really be variably-allocated... I'll get to it someday)*/
-      if(stnData->numberOfLevels>MAX_LEVELS) {
-         fprintf(stderr, "%% getOCLStationData: warning: stn %ld numLevels=%ld"
-            " > MAX_LEVELS=%d.\n", stn, stnData->numberOfLevels,
-            MAX_LEVELS);
-         fprintf(stderr, "%%   botDepth might be wrong and not all the profile"
-            " levels will be output.\n");
-      }
 
-      /* loop over profile levels */
-      for(j=0; j<stnData->numberOfLevels && j<MAX_LEVELS; j++) {
 
-         /* depth values */
-         if( stnData->stationType==0 /*observed level*/ ) {
-            status = getVarlenFloatField( fp_in, &(stnData->depthValue[j]),
-               &(stnData->bytesLeftInStation) );
-            if( status != ZERO_LENGTH_FIELD ) {
-               getIntDigits( fp_in, 1, &(stnData->errCodeForDepthValue[j]) );
-               stnData->bytesLeftInStation-=1;
-            }
-         }
-         else stnData->depthValue[j]=stdLevelDepth[j];
+/* "Skip OCL bathy line" - a station's been skipped or cut without its
+   bottom depth being set: step the bathy file past its line, to stay in
+   step with the stations.  (Nothing to do with a bathy grid or sidecar,
+   which are looked up by position or station number instead.) */
+void skipOCLBathyLine( OCLStationType *stnData, int dbBathyFlag,
+   FILE *fp_dbBathy ) {
 
-         /* the values for each varCode (temp, sal, etc) */
-         for(k=0; k<stnData->numberOfVarCodes; k++) {
-            status = getVarlenFloatField( fp_in, &(stnData->varValue[k][j]),
-               &(stnData->bytesLeftInStation) );
-            if( status != ZERO_LENGTH_FIELD ) {
-               getIntDigits( fp_in, 1, &(stnData->errCodeForVarValue[k][j]) );
-               stnData->bytesLeftInStation-=1;
-            }
-         }
-      }
+   long int ld_dummy;
+   double lf_dummy;
+
+   if( dbBathyFlag && stnData->bathy==NULL )
+      fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
+         &ld_dummy, &lf_dummy );
+}
 
 
 
 
-      /* recheck bottomDepth value against lowest profile depth: if lowest
-         profile depth is deeper than bottomDepth (=hdrdepth or =dbdepth)
-         we rechoose which value we use for bottomDepth, or use lowest profile
-         depth for bottomDepth if they're both bad */
-      if( stnData->numberOfLevels>0 ) {
-         if( stnData->bottomDepthPtr==NULL) assignLastProfileDepth=1;/*if none*/
-         else if( stnData->bottomDepthSource=='h' &&     /* if hdrdepth bad */
-                  ( *(stnData->bottomDepthPtr) < 
-                  stnData->depthValue[stnData->numberOfLevels-1] ) ) {
-            if( dbBathyFlag ) {  /* maybe substitute db value if using db */
-               if( databaseBathyValue < 
-                  stnData->depthValue[stnData->numberOfLevels-1] ) {
-                  assignLastProfileDepth=1;
-               }
-               else {
-                  stnData->bottomDepthPtr = &databaseBathyValue;
-                  stnData->bottomDepthSource = 'd';
-               }
+
+
+/* "Check OCL bottom depth" - once the profile's been read, recheck the
+   bottomDepth value against the lowest profile depth: if lowest profile
+   depth is deeper than bottomDepth (=hdrdepth or =dbdepth) we rechoose which
+   value we use for bottomDepth, or use lowest profile depth for bottomDepth
+   if they're both bad */
+void checkOCLBottomDepth( OCLStationType *stnData, int dbBathyFlag ) {
+
+   int assignLastProfileDepth=0;
+
+   if( stnData->numberOfLevels>0 ) {
+      if( stnData->bottomDepthPtr==NULL) assignLastProfileDepth=1;/*if none*/
+      else if( stnData->bottomDepthSource=='h' &&     /* if hdrdepth bad */
+               ( *(stnData->bottomDepthPtr) < 
+               stnData->depthValue[stnData->numberOfLevels-1] ) ) {
+         /* maybe substitute db value if using db (and it has one here) */
+         if( dbBathyFlag && stnData->dbBathy==stnData->dbBathy ) {
+            if( stnData->dbBathy < 
+               stnData->depthValue[stnData->numberOfLevels-1] ) {
+               assignLastProfileDepth=1;
+            }
+            else {
+               stnData->bottomDepthPtr = &(stnData->dbBathy);
+               stnData->bottomDepthSource = 'd';
             }
-            else assignLastProfileDepth=1;  /*no db value so just use profile*/
-         }
-         else if( stnData->bottomDepthSource=='d' &&      /* if dbdepth bad */
-                  ( *(stnData->bottomDepthPtr) < 
-                  stnData->depthValue[stnData->numberOfLevels-1] ) ) {
-            assignLastProfileDepth=1;
          }
-         else assignLastProfileDepth=0;  /* we have a good bottomDepth value */
+         else assignLastProfileDepth=1;  /*no db value so just use profile*/
+      }
+      else if( stnData->bottomDepthSource=='d' &&      /* if dbdepth bad */
+               ( *(stnData->bottomDepthPtr) < 
+               stnData->depthValue[stnData->numberOfLevels-1] ) ) {
+         assignLastProfileDepth=1;
+      }
+      else assignLastProfileDepth=0;  /* we have a good bottomDepth value */
 
-         if( assignLastProfileDepth ) {
-            stnData->bottomDepthPtr =
-               &(stnData->depthValue[stnData->numberOfLevels-1]);
-            stnData->bottomDepthSource='p';
-         }
+      if( assignLastProfileDepth ) {
+         stnData->bottomDepthPtr =
+            &(stnData->depthValue[stnData->numberOfLevels-1]);
+         stnData->bottomDepthSource='p';
       }
+   }
+}
+
+
+
+
+
+
+
+/* "Init OCL station" - start off a station struct with no profile, and its
+   data going in its own (empty) arena (a static one already starts off that
+   way) */
+void initOCLStation( OCLStationType *stnData ) {
+   int k;
+
+   stnData->numberOfSecHdrEntries = 0;
+   stnData->secHdrCode = NULL;
+   stnData->secHdrValue = NULL;
+   stnData->depthValue = NULL;
+   stnData->errCodeForDepthValue = NULL;
+   for(k=0; k<MAX_VARS; k++) {
+      stnData->varValue[k] = NULL;
+      stnData->errCodeForVarValue[k] = NULL;
+   }
+   stnData->levelFlags = NULL;
+   stnData->anyLevelFlagged = 0;
+   stnData->decodedVars = 0;
+   stnData->arena = NULL;
+   stnData->numProjectionVars = 0;
+   stnData->projectionVars = NULL;
+   stnData->filterCounts = NULL;
+   stnData->filterExpr = NULL;
+   stnData->numFilterExprs = 0;
+   stnData->filterExprMatches = NULL;
+   stnData->bathy = NULL;
+   initOCLArena( &(stnData->ownArena) );
+}
 
 
-   } /* done reading rest of profile */
 
 
-   /* even at end of station, still need to do this to get past any remaining
-      white space till end of line */
-   skipToNextStation( fp_in, stnData->bytesLeftInStation);
 
+
+
+/* "Alloc OCL station sec hdr" - make room in the station's arena for
+   numEntries secondary header entries, and point secHdrCode and secHdrValue
+   at it */
+int allocOCLStationSecHdr( OCLStationType *stnData, long int numEntries ) {
+   OCLArenaType *arena =
+      (stnData->arena!=NULL) ? stnData->arena : &(stnData->ownArena);
+
+   if( numEntries<0 ) numEntries=0;
+   stnData->secHdrCode = (long int *)allocOCLArena( arena,
+      numEntries*(long int)sizeof(long int) );
+   stnData->secHdrValue = (double *)allocOCLArena( arena,
+      numEntries*(long int)sizeof(double) );
+   if( stnData->secHdrCode==NULL || stnData->secHdrValue==NULL )
+      return UNSPECIFIED_PROBLEM;
    return SUCCESSFUL;
+}
 
-} /* end of getOCLStationData */
 
 
 
 
 
 
+/* "Alloc OCL station profile" - make room in the station's arena for
+   numLevels levels of depth and of each of the first numVars variables that
+   the station's projection wants (see decodedVars), and point depthValue,
+   those varValue[]s, their error codes and levelFlags at it */
+int allocOCLStationProfile( OCLStationType *stnData, long int numLevels,
+   long int numVars ) {
 
-/* "Get integer digits" - number of digits is specified, take from fp and place
-   in integer */
-int getIntDigits(FILE *fp, int numDigits, long int *value) {
-   char nextch=0, valueStr[10]="", *p;
-   int i, status;
-   double badValue=nan();  /* assigning NaN */
+   long int i, k, n, numDecoded=0;
+   double *values;
+   unsigned char *errCodes;
+   OCLArenaType *arena =
+      (stnData->arena!=NULL) ? stnData->arena : &(stnData->ownArena);
 
-   p=valueStr;
+   if( numLevels<0 ) numLevels=0;
+   if( numVars<0 ) numVars=0;
+   if( numVars>MAX_VARS ) numVars=MAX_VARS;
 
-   for(i=0; i<numDigits; i++) {
-      if( (nextch=fgetc(fp))==EOF ) {  /* read & check for eof at same time */
-         fprintf(stderr,"%%oclfilt: unexpected EOF - empty or truncated input file?\n");
-         exit(1);
+   stnData->decodedVars = 0;
+   for(k=0; k<numVars; k++) {
+      for(i=0; i<stnData->numProjectionVars; i++)
+         if( stnData->varCode[k]==stnData->projectionVars[i] ) break;
+      if( stnData->numProjectionVars<=0 || i<stnData->numProjectionVars ) {
+         stnData->decodedVars |= OCL_VAR_BIT(k);
+         numDecoded++;
       }
-      if(nextch=='\n' || nextch=='\r') i--; /*don't inc j for newlines or CRs*/
-      else *(p++)=nextch;  /* tack chars onto valueStr, keeping place with p */
    }
-
-   /*check if at least rightmost char is a digit (the others may be spaces)*/
-   if(numDigits>0 && isdigit((int)nextch) ) {
-      sscanf(valueStr,"%ld", value);
-      status=SUCCESSFUL;
-   }
-   else if(numDigits==0 || (numDigits==1 && nextch=='-') ) {
-      *value=(long int)badValue;
-      status=ZERO_LENGTH_FIELD;
-   }
-   else {
-      status=UNSPECIFIED_PROBLEM;
+   n = numLevels*(1+numDecoded);
+
+   values = (double *)allocOCLArena( arena, n*(long int)sizeof(double) );
+   errCodes = (unsigned char *)allocOCLArena( arena, n );
+   stnData->levelFlags = (unsigned int *)allocOCLArena( arena,
+      numLevels*(long int)sizeof(unsigned int) );
+   if( values==NULL || errCodes==NULL || stnData->levelFlags==NULL )
+      return UNSPECIFIED_PROBLEM;
+
+   /* depths first, then each decoded variable's column */
+   stnData->depthValue = values;
+   stnData->errCodeForDepthValue = errCodes;
+   for(i=1, k=0; k<MAX_VARS; k++) {
+      if( stnData->decodedVars & OCL_VAR_BIT(k) ) {
+         stnData->varValue[k] = values + i*numLevels;
+         stnData->errCodeForVarValue[k] = errCodes + i*numLevels;
+         i++;
+      }
+      else {
+         stnData->varValue[k] = NULL;
+         stnData->errCodeForVarValue[k] = NULL;
+      }
    }
+   return SUCCESSFUL;
+}
+
+
+
+
+
+
+
+/* "Free OCL station" - release a station struct's own arena (a caller's
+   arena it was using is left to the caller) */
+void freeOCLStation( OCLStationType *stnData ) {
+   freeOCLArena( &(stnData->ownArena) );
+   initOCLStation(stnData);
+}
+
+
+
+
 
-  return status;
 
+
+/* "Set OCL level flags" - make levelFlags and anyLevelFlagged from a
+   profile's values and error codes, for a profile that didn't come from the
+   decoder above (which makes them as it goes), eg from an OCL cache */
+void setOCLLevelFlags( OCLStationType *stnData ) {
+   long int j;
+
+   stnData->anyLevelFlagged=0;
+   for(j=0; j<stnData->numberOfLevels; j++) setOCLLevelFlagsAt( stnData, j );
+}
+
+/* (the same for level j alone, adding its flags to anyLevelFlagged) */
+static void setOCLLevelFlagsAt( OCLStationType *stnData, long int j ) {
+   long int k;
+   unsigned int levelFlags=0;
+
+   if( OCL_VALUE_FLAGGED(stnData->depthValue[j],
+          stnData->errCodeForDepthValue[j]) )
+      levelFlags |= OCL_DEPTH_BIT;
+   for(k=0; k<stnData->numberOfVarCodes; k++)
+      if( (stnData->decodedVars & OCL_VAR_BIT(k)) &&
+          OCL_VALUE_FLAGGED(stnData->varValue[k][j],
+             stnData->errCodeForVarValue[k][j]) )
+         levelFlags |= OCL_VAR_BIT(k);
+   stnData->levelFlags[j] = levelFlags;
+   stnData->anyLevelFlagged |= levelFlags;
+}
+
+
+
+
+
+
+
+/* "In OCL cyclic range" - true if value is within range[0] to range[1]
+   inclusive, or if range[0] is greater than range[1], within the range that
+   wraps around the end of the year (eg months 11,2 or days-of-year 335,59):
+   value>=range[0] or 0<value<=range[1], since zero means a missing month or
+   day in the OCL data. */
+int inOCLCyclicRange( long int value, long int *range ) {
+   if( range[0]<=range[1] ) return value>=range[0] && value<=range[1];
+   else return value>=range[0] || (value>0 && value<=range[1]);
+}
+
+
+
+
+
+
+
+/* "OCL day of year" - day of the year (1-366) of a station's date, or 0 if
+   its month or day is missing/bad */
+long int oclDayOfYear( long int year, long int month, long int day ) {
+   static const int daysBefore[13] = { 0, 0, 31, 59, 90, 120, 151, 181, 212,
+      243, 273, 304, 334 };
+   int leap;
+
+   if( month<1 || month>12 || day<1 || day>31 ) return 0;
+   leap = ( year%4==0 && year%100!=0 ) || year%400==0;
+   return daysBefore[month] + day + (leap && month>2);
+}
+
+
+
+
+
+
+
+/* "Get integer digits" - number of digits is specified, take from fp and place
+   in integer (the stdio version of the decoders in oclSourcePolicy.h) */
+int getIntDigits(FILE *fp, int numDigits, long int *value) {
+   OCLSourceType src;
+
+   setOCLSourceFile(&src, fp);
+   return getIntDigitsStdio(&src, numDigits, value);
+}
+
+/* "Get integer digits" from an OCLSourceType - hands off to the stdio
+   or span version */
+int getIntDigitsSrc(OCLSourceType *src, int numDigits, long int *value) {
+   if( src->fp!=NULL ) return getIntDigitsStdio(src, numDigits, value);
+   else return getIntDigitsSpan(src, numDigits, value);
 }
 
 
@@ -667,28 +1563,17 @@ int getIntDigits(FILE *fp, int numDigits, long int *value) {
 
 /* "Get variable-length integer field" */
 int getVarlenIntField(FILE *fp, long int *value, long int *bytesLeftInStation) {
-   int status;
-   long int bytesInNextField;
-   double badValue=nan();  /* assigning NaN */
+   OCLSourceType src;
 
-   status=getIntDigits(fp,1, &bytesInNextField);
-   *bytesLeftInStation-=1;
-
-   /* note 'value' is set inside the if statement here */
-   if( getIntDigits(fp, bytesInNextField, value)==ZERO_LENGTH_FIELD ) {
-      *value=(long int)badValue;
-      status=ZERO_LENGTH_FIELD;
-   }
-   else {
-     /* if bytesLeftInStation not set yet (ie beginning of station), set it */
-     if(*bytesLeftInStation<0)
-        *bytesLeftInStation=*value-(long int)bytesInNextField-1;
-     /* otherwise decrement the actual number of bytesLeftInStation */
-     else *bytesLeftInStation-=(long int)bytesInNextField;
-     status=SUCCESSFUL;
-   }
+   setOCLSourceFile(&src, fp);
+   return getVarlenIntFieldStdio(&src, value, bytesLeftInStation);
+}
 
-   return status;
+int getVarlenIntFieldSrc(OCLSourceType *src, long int *value,
+   long int *bytesLeftInStation) {
+   if( src->fp!=NULL )
+      return getVarlenIntFieldStdio(src, value, bytesLeftInStation);
+   else return getVarlenIntFieldSpan(src, value, bytesLeftInStation);
 }
 
 
@@ -698,34 +1583,30 @@ int getVarlenIntField(FILE *fp, long int *value, long int *bytesLeftInStation) {
 
 /* "Get variable-length floating-point field" (data type is actually double) */
 int getVarlenFloatField(FILE *fp, double *value, long int *bytesLeftInStation) {
-   int status;
-   long int sigDigits, totalDigits, precision, intvalue;
-   double badValue=nan();  /* assigning NaN */
+   OCLSourceType src;
 
+   setOCLSourceFile(&src, fp);
+   return getVarlenFloatFieldStdio(&src, value, bytesLeftInStation);
+}
 
-   status = getIntDigits(fp,1, &sigDigits);
-   *bytesLeftInStation-=1;
+int getVarlenFloatFieldSrc(OCLSourceType *src, double *value,
+   long int *bytesLeftInStation) {
+   if( src->fp!=NULL )
+      return getVarlenFloatFieldStdio(src, value, bytesLeftInStation);
+   else return getVarlenFloatFieldSpan(src, value, bytesLeftInStation);
+}
 
-   if (status==SUCCESSFUL) {
-      status = getIntDigits(fp,1, &totalDigits);
-      *bytesLeftInStation-=1;
 
-      status = getIntDigits(fp,1, &precision);
-      *bytesLeftInStation-=1;
 
-      status = getIntDigits(fp, totalDigits, &intvalue);
-      *bytesLeftInStation-=totalDigits;
 
-      *value=(double)intvalue/pow(10.,(double)precision);
-      status=SUCCESSFUL;
-   }
 
-   else if (status==ZERO_LENGTH_FIELD) {
-      *value=badValue;
-      status=ZERO_LENGTH_FIELD;
-   }
 
-   return status;
+/* "Skip variable-length floating-point field" - step over a profile value
+   and its error code without converting them (see oclSourcePolicy.h) */
+int skipVarlenFloatFieldSrc(OCLSourceType *src, long int *bytesLeftInStation) {
+   if( src->fp!=NULL )
+      return skipVarlenFloatFieldStdio(src, bytesLeftInStation);
+   else return skipVarlenFloatFieldSpan(src, bytesLeftInStation);
 }
 
 
@@ -736,23 +1617,20 @@ int getVarlenFloatField(FILE *fp, double *value, long int *bytesLeftInStation) {
 /* "Skip to next station" - skip over the remaining bytes left in the station
    (which are kept track of in the conversion process) to get to next station*/
 int skipToNextStation(FILE *fp, long int bytesLeftInStation) {
-   long int i;
-   int nextch=0, status=SUCCESSFUL;
-   char dummy[80];
-
-   /* if we're not done with station bytes yet, skip over those */
-   for(i=0; i<(bytesLeftInStation); i++) {
-      nextch=fgetc(fp);
-      if(nextch=='\n' || nextch=='\r') i--; /*don't inc j for newlines or CRs*/
-   }
+   OCLSourceType src;
 
-   /* skip past blank space and newline/CR to new station (or eof) */
-   fgets(dummy,80,fp);
-
-   /* sorry, dumb hack to expose eof character so next loop stops on it */
-   nextch=fgetc(fp); if (nextch!=EOF) ungetc(nextch, fp);
+   setOCLSourceFile(&src, fp);
+   return skipToNextStationStdio(&src, bytesLeftInStation);
+}
 
-   return status;
+/* "Skip to next station" in an OCLSourceType - if the file's lines are
+   fixed-width we can work out where the next station starts and jump right
+   there (see jumpToNextStation in oclSource.c), otherwise skip byte by byte */
+int skipToNextStationSrc(OCLSourceType *src, long int bytesLeftInStation) {
+   if( jumpToNextStation(src, bytesLeftInStation) == SUCCESSFUL )
+      return SUCCESSFUL;
+   if( src->fp!=NULL ) return skipToNextStationStdio(src, bytesLeftInStation);
+   else return skipToNextStationSpan(src, bytesLeftInStation);
 }
 
 
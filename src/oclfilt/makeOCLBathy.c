@@ -0,0 +1,133 @@
+/* makeOCLBathy.c -
+ *             Makes a bathy grid file for oclfilt -d (see oclBathy.c) out of
+ *             gridded bathymetry as lon lat z text lines, eg out of GMT's
+ *             grd2xyz from the Sandwell & Smith topo grid.  oclfilt then
+ *             looks each station's bottom depth up in the grid by position,
+ *             so there's no lat-lon-depth file to make for each OCL file
+ *             with outputAllLatsLons and grdtrack.
+ *
+ * usage:      makeOCLBathy -R <west>/<east>/<south>/<north>
+ *                -I <dlon>[/<dlat>] [-t <tilesize>] <xyzfile> <bathyfile>
+ *
+ *             -R and -I give the grid's nodes, as for GMT (gridline
+ *             registration: nodes on the bounds themselves, dlon and dlat
+ *             apart), and <xyzfile> (- for stdin) has a line of lon lat z
+ *             for each node, in any order - z being elevation, negative
+ *             below sea level, as in GMT grids.  Nodes without a line get
+ *             NaN (no value), as do lines with NaN for z.  Lines off the
+ *             grid, or more than a tenth of a node spacing from a node, are
+ *             an error.  Tiles are <tilesize> nodes square (default 64).
+ *             eg for a global grid at 2 arc-minutes:
+ *                grd2xyz topo.grd | makeOCLBathy -R 0/360/-72/72 \
+ *                   -I 0.0333333333333 - topo.bth
+ *
+ * required sources/files: ocl.h, oclBathy.c, getOCLStationData.c,
+ *                         oclSource.c, oclIndex.c, oclCache.c, oclArena.c,
+ *                         oclExpr.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "ocl.h"
+
+
+static void usage(void) {
+  fprintf(stderr, "usage: makeOCLBathy -R <west>/<east>/<south>/<north>\n"
+     "          -I <dlon>[/<dlat>] [-t <tilesize>] <xyzfile> <bathyfile>\n");
+  exit(1);
+}
+
+
+int main (int argc, char *argv[]) {
+
+  OCLBathyType bathy;
+  double region[4], lon, lat, z, x, y;
+  float *grid;
+  FILE *fp_in=stdin;
+  long int i, j, k, numNodes, numLines=0, numSet=0;
+  char line[256];
+  int a, R_flag=0, I_flag=0;
+
+  memset(&bathy, 0, sizeof(bathy));
+  bathy.tileSize = 64;
+
+  for(a=1; a<argc && argv[a][0]=='-' && argv[a][1]!='\0'; a++) {
+    if( a+1>=argc ) usage();
+    if( !strcmp(argv[a],"-R") ) {
+      if( sscanf(argv[++a], "%lf/%lf/%lf/%lf", &region[0], &region[1],
+          &region[2], &region[3]) != 4 ) usage();
+      R_flag=1;
+    }
+    else if( !strcmp(argv[a],"-I") ) {
+      k = sscanf(argv[++a], "%lf/%lf", &bathy.dlon, &bathy.dlat);
+      if( k<1 ) usage();
+      if( k==1 ) bathy.dlat = bathy.dlon;
+      I_flag=1;
+    }
+    else if( !strcmp(argv[a],"-t") ) bathy.tileSize = atol(argv[++a]);
+    else usage();
+  }
+  if( !R_flag || !I_flag || argc-a!=2 || !(bathy.dlon>0.) ||
+      !(bathy.dlat>0.) || bathy.tileSize<1 || region[1]<=region[0] ||
+      region[3]<=region[2] )
+    usage();
+
+  bathy.lon0 = region[0];
+  bathy.lat0 = region[2];
+  bathy.numLons = (long int)floor((region[1]-region[0])/bathy.dlon+0.5) + 1;
+  bathy.numLats = (long int)floor((region[3]-region[2])/bathy.dlat+0.5) + 1;
+  numNodes = bathy.numLons*bathy.numLats;
+
+  if( (grid=(float *)malloc((size_t)numNodes*sizeof(float))) == NULL ) {
+    fprintf(stderr, "makeOCLBathy: not enough memory for %ld x %ld nodes.\n",
+       bathy.numLons, bathy.numLats);
+    exit(1);
+  }
+  for(k=0; k<numNodes; k++) grid[k] = (float)nan();
+
+  if( strcmp(argv[a],"-") && (fp_in=fopen(argv[a],"r")) == NULL ) {
+    fprintf(stderr, "Unable to open file %s.\n", argv[a]);
+    exit(1);
+  }
+
+  /* put each line's z on its node */
+  while( fgets(line, sizeof(line), fp_in) != NULL ) {
+    numLines++;
+    if( line[0]=='#' || line[0]=='%' ) continue;  /* (comments) */
+    if( sscanf(line, "%lf %lf %lf", &lon, &lat, &z) != 3 ) {
+      if( strspn(line, " \t\r\n")==strlen(line) ) continue;  /* (blank) */
+      fprintf(stderr, "makeOCLBathy: can't read line %ld of %s.\n",
+         numLines, argv[a]);
+      exit(1);
+    }
+    x = (lon-bathy.lon0)/bathy.dlon;
+    y = (lat-bathy.lat0)/bathy.dlat;
+    i = (long int)floor(x+0.5);
+    j = (long int)floor(y+0.5);
+    if( i<0 || i>=bathy.numLons || j<0 || j>=bathy.numLats ||
+        fabs(x-i)>0.1 || fabs(y-j)>0.1 ) {
+      fprintf(stderr, "makeOCLBathy: line %ld of %s (%f %f) isn't on a node"
+         " of the grid.\n", numLines, argv[a], lon, lat);
+      exit(1);
+    }
+    grid[j*bathy.numLons+i] = (float)z;
+  }
+  if( fp_in!=stdin ) fclose(fp_in);
+  for(k=0; k<numNodes; k++)
+    if( grid[k]==grid[k] ) numSet++;
+
+  if( writeOCLBathy(argv[a+1], &bathy, grid) != SUCCESSFUL ) {
+    fprintf(stderr, "makeOCLBathy: failed to write %s.\n", argv[a+1]);
+    exit(1);
+  }
+
+  fprintf(stderr, "makeOCLBathy: %ld x %ld nodes (%ld with values) gridded"
+     " in %s\n", bathy.numLons, bathy.numLats, numSet, argv[a+1]);
+
+  free(grid);
+
+  return SUCCESSFUL;
+
+}  /* end of main */
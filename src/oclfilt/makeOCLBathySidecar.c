@@ -0,0 +1,83 @@
+/* makeOCLBathySidecar.c -
+ *             Makes a bathy sidecar for an OCL file (see oclBathy.c): each
+ *             of its stations' bathy values in turn, so oclfilt -d can take
+ *             station i's straight from the sidecar, rather than read a
+ *             lat-lon-depth file a line per station in step with the OCL
+ *             file - whichever stations -s, the filters or -j workers leave
+ *             it to read.
+ *
+ * usage:      makeOCLBathySidecar <oclfile> <bathyfile> [<sidecarfile>]
+ *
+ *             <bathyfile> is a bathy grid from makeOCLBathy, or the old
+ *             lat-lon-depth file made for <oclfile> (with outputAllLatsLons
+ *             and grdtrack).  <oclfile> may be gzipped, or an OCL cache
+ *             file.  The sidecar goes in <sidecarfile>, by default
+ *             <oclfile>.bdep.  It only goes with the OCL file it was made
+ *             from - oclfilt checks - so remake it if that changes.
+ *
+ * required sources/files: ocl.h, oclBathy.c, getOCLStationData.c,
+ *                         oclSource.c, oclIndex.c, oclCache.c, oclArena.c,
+ *                         oclExpr.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+
+int main (int argc, char *argv[]) {
+
+  OCLSourceType src;
+  OCLBathyType grid;
+  FILE *fp_dbBathy=NULL;
+  char sidecarFilename[256];
+  int status;
+
+  if( argc<3 || argc>4 ) {
+    fprintf(stderr, "usage: makeOCLBathySidecar <oclfile> <bathyfile>"
+       " [<sidecarfile>]\n");
+    exit(1);
+  }
+  if( argc==4 ) strncpy(sidecarFilename, argv[3], sizeof(sidecarFilename)-1);
+  else sprintf(sidecarFilename, "%.250s.bdep", argv[1]);
+  sidecarFilename[sizeof(sidecarFilename)-1] = '\0';
+
+  /* the OCL file, read however oclfilt would read it */
+  if( isGzipFile(argv[1]) ) status = loadOCLGzSource(&src, argv[1]);
+  else if( isOCLCacheFile(argv[1]) ) status = openOCLCache(&src, argv[1]);
+  else status = mapOCLSource(&src, argv[1]);
+  if( status != SUCCESSFUL ) exit(1);
+
+  /* the bathy database: a grid, or a lat-lon-depth file for this OCL file */
+  if( isOCLBathyFile(argv[2]) == OCL_BATHY_GRID ) {
+    if( mapOCLBathy(argv[2], &grid) != SUCCESSFUL ) exit(1);
+  }
+  else if( isOCLBathyFile(argv[2]) == OCL_BATHY_SIDECAR ) {
+    fprintf(stderr, "makeOCLBathySidecar: %s is already a bathy sidecar.\n",
+       argv[2]);
+    exit(1);
+  }
+  else if( (fp_dbBathy=fopen(argv[2],"r")) == NULL ) {
+    fprintf(stderr, "Unable to open file %s.\n", argv[2]);
+    exit(1);
+  }
+
+  status = writeOCLBathySidecar(sidecarFilename, &src,
+     (fp_dbBathy==NULL) ? &grid : NULL, fp_dbBathy);
+
+  if( fp_dbBathy!=NULL ) fclose(fp_dbBathy);
+  else closeOCLBathy(&grid);
+  closeOCLSource(&src);
+
+  if( status != SUCCESSFUL ) {
+    fprintf(stderr, "makeOCLBathySidecar: failed to make %s.\n",
+       sidecarFilename);
+    exit(1);
+  }
+  fprintf(stderr, "makeOCLBathySidecar: bathy for %s in %s\n", argv[1],
+     sidecarFilename);
+
+  return SUCCESSFUL;
+
+}  /* end of main */
@@ -0,0 +1,57 @@
+/* makeOCLCache.c -
+ *             Converts an OCL file to an OCL cache file: the same stations,
+ *             already decoded into a binary table of station headers and
+ *             columns of profile values (see oclCache.c).  oclfilt reads a
+ *             cache file given as its input just like the OCL file it was
+ *             made from, with the same filters and the same output, but
+ *             without parsing any OCL text - worth it for data that gets
+ *             swept over and over.
+ *
+ * usage:      makeOCLCache <oclfile> [<cachefile>]
+ *             (default cachefile is <oclfile>.cache)
+ *
+ *             A gzipped OCL file is decompressed and \r-stripped as it's
+ *             read, as with oclfilt -i.  A cache file is in the native
+ *             byte order and sizes of the machine that made it, so make it
+ *             on the kind of machine that'll read it.
+ *
+ * required sources/files: ocl.h, oclCache.c, oclIndex.c, oclSource.c,
+ *                         getOCLStationData.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+
+int main (int argc, char *argv[]) {
+
+  OCLSourceType src;
+  char cacheFilename[256];
+
+  if( argc<2 || argc>3 ) {
+    fprintf(stderr, "usage: makeOCLCache <oclfile> [<cachefile>]\n");
+    exit(1);
+  }
+  if( argc==3 ) sprintf(cacheFilename, "%.255s", argv[2]);
+  else sprintf(cacheFilename, "%.249s.cache", argv[1]);
+
+  if( isGzipFile(argv[1]) ) {
+    if( loadOCLGzSource(&src, argv[1]) != SUCCESSFUL ) exit(1);
+  }
+  else if( mapOCLSource(&src, argv[1]) != SUCCESSFUL ) exit(1);
+
+  if( writeOCLCache(cacheFilename, &src) != SUCCESSFUL ) {
+    fprintf(stderr, "makeOCLCache: failed to convert %s.\n", argv[1]);
+    exit(1);
+  }
+
+  fprintf(stderr, "makeOCLCache: %s converted to %s\n", argv[1],
+     cacheFilename);
+
+  closeOCLSource(&src);
+
+  return SUCCESSFUL;
+
+}  /* end of main */
@@ -0,0 +1,71 @@
+/* makeOCLGrid.c -
+ *             Makes a spatial index ("grid") of where the stations are in a
+ *             set of OCL files - eg all the files on a WOD98 CD - for
+ *             oclfilt -G.  Then a -l region query reads just the stations in
+ *             the region, from whichever files they're in, rather than every
+ *             station header in every file (and without having to work out
+ *             which WMO squares and files to look in first).  See oclGrid.c.
+ *
+ * usage:      makeOCLGrid <gridfile> <oclfiles...>
+ *
+ *             The OCL files can be plain, gzipped (as on the WOD98 CDs), or
+ *             OCL cache files from makeOCLCache, and wildcards are expanded
+ *             even if quoted (to get past the shell's argument length limit
+ *             with a whole CD's worth of files), eg:
+ *                makeOCLGrid npac.grid \
+ *                   '/mnt/cdrom/data/npac/1[0-9][0-9][0-9]/ncts*.gz'
+ *             The file names go in the grid as given, so use full paths if
+ *             the grid will be used from another directory.
+ *
+ * required sources/files: ocl.h, oclGrid.c, oclCache.c, oclIndex.c,
+ *                         oclSource.c, getOCLStationData.c
+ */
+
+#define _POSIX_C_SOURCE 200112L  /* for glob() with -ansi */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+#include "ocl.h"
+
+
+int main (int argc, char *argv[]) {
+
+  OCLGridType grid;
+  glob_t inFiles;
+  long int f;
+  int i;
+
+  if( argc<3 ) {
+    fprintf(stderr, "usage: makeOCLGrid <gridfile> <oclfiles...>\n");
+    exit(1);
+  }
+
+  for(i=2; i<argc; i++)
+    glob(argv[i], GLOB_NOCHECK | (i>2 ? GLOB_APPEND : 0), NULL, &inFiles);
+
+  initOCLGrid(&grid);
+  for(f=0; f<(long int)inFiles.gl_pathc; f++) {
+    if( addOCLGridFile(&grid, inFiles.gl_pathv[f]) != SUCCESSFUL ) {
+      fprintf(stderr, "makeOCLGrid: failed to read %s.\n",
+         inFiles.gl_pathv[f]);
+      exit(1);
+    }
+  }
+
+  if( finishOCLGrid(&grid) != SUCCESSFUL ||
+      writeOCLGrid(argv[1], &grid) != SUCCESSFUL ) {
+    fprintf(stderr, "makeOCLGrid: failed to write %s.\n", argv[1]);
+    exit(1);
+  }
+
+  fprintf(stderr, "makeOCLGrid: %ld stations in %ld files gridded in %s\n",
+     grid.numEntries, grid.numFiles, argv[1]);
+
+  freeOCLGrid(&grid);
+  globfree(&inFiles);
+
+  return SUCCESSFUL;
+
+}  /* end of main */
@@ -0,0 +1,63 @@
+/* makeOCLIndex.c -
+ *             Writes the station offset index sidecar for an OCL file, so
+ *             that oclfilt's -s and -k options (and other programs using
+ *             seekOCLStation()) can seek straight to a station instead of
+ *             reading through all the ones before it.  See oclIndex.c.
+ *
+ * usage:      makeOCLIndex <oclfile> [<indexfile>]
+ *             (default indexfile is <oclfile>.idx)
+ *
+ *             The OCL file must be the same one that will be read later with
+ *             the index, since the offsets are byte offsets.  A gzipped file
+ *             is indexed as decompressed and \r-stripped, which is how
+ *             oclfilt -i reads it, and an OCL cache file (see oclCache.c) by
+ *             the rows of its station header table.  checkOCLIndex checks an
+ *             index against its file.
+ *
+ * required sources/files: ocl.h, oclIndex.c, oclSource.c, getOCLStationData.c,
+ *                         oclCache.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+
+int main (int argc, char *argv[]) {
+
+  OCLSourceType src;
+  OCLIndexType idx;
+  char indexFilename[256];
+
+  if( argc<2 || argc>3 ) {
+    fprintf(stderr, "usage: makeOCLIndex <oclfile> [<indexfile>]\n");
+    exit(1);
+  }
+  if( argc==3 ) sprintf(indexFilename, "%.255s", argv[2]);
+  else sprintf(indexFilename, "%.251s.idx", argv[1]);
+
+  /* the OCL file, read however oclfilt -i would read it */
+  if( isGzipFile(argv[1]) ) {
+    if( loadOCLGzSource(&src, argv[1]) != SUCCESSFUL ) exit(1);
+  }
+  else if( isOCLCacheFile(argv[1]) ) {
+    if( openOCLCache(&src, argv[1]) != SUCCESSFUL ) exit(1);
+  }
+  else if( mapOCLSource(&src, argv[1]) != SUCCESSFUL ) exit(1);
+
+  if( buildOCLIndex(&src, &idx) != SUCCESSFUL ||
+      writeOCLIndex(indexFilename, &idx) != SUCCESSFUL ) {
+    fprintf(stderr, "makeOCLIndex: failed to index %s.\n", argv[1]);
+    exit(1);
+  }
+
+  fprintf(stderr, "makeOCLIndex: %ld stations in %s indexed in %s\n",
+     idx.numStations, argv[1], indexFilename);
+
+  freeOCLIndex(&idx);
+  closeOCLSource(&src);
+
+  return SUCCESSFUL;
+
+}  /* end of main */
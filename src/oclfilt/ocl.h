@@ -6,13 +6,171 @@
 #define ZERO_LENGTH_FIELD 2
 #define SKIPPED 3
 #define HELP_LISTING 4
+#define FILTERED_OUT 5
 
 /* Constants */
 #define MAX_VARS 10
-#define MAX_LEVELS 6000  /* 100 okay for stdlvl data, 6000 needed for obslvl */
+#define OCL_OUTPUT_BUFSIZE 262144  /* stdio buffer for output files */
+#define OCL_MAX_OUTPUT_LINE 1024   /* longest line formatted for output */
+
+/* oclfilt -B's binary record streams (kept in their own include file, as
+   sspcomp reads them too) */
+#include "oclRecord.h"
+
+/* wantProfileFlag values for getOCLStationData() - just true or false,
+   or else only the deepest level of the profile, for the bottom depth */
+#define OCL_PROFILE_NONE 0
+#define OCL_PROFILE_ALL 1
+#define OCL_PROFILE_LAST_LEVEL 2
+
+/* decodeOCLStation()'s return once its source is used up */
+#define OCL_DECODER_END (-1)
+
+/* Profile level flag bits (see levelFlags in OCLStationType) - one for the
+   depth and one for each of the station's variables (ie var k in varCode[k],
+   varValue[k], etc) */
+#define OCL_DEPTH_BIT 1U
+#define OCL_VAR_BIT(k) (2U << (k))
+
+/* getOCLStationData()'s filters, in the order they're checked - which is
+   the order the header fields they need come up in a station, so a station
+   is cut (and skipped over) as soon as it can be.  See OCLFilterCounts. */
+#define OCL_FILTER_YEAR 0        /* oclfilt -y */
+#define OCL_FILTER_MONTH 1       /* -m */
+#define OCL_FILTER_LATLON 2      /* -l */
+#define OCL_FILTER_ZERO_LATLON 3 /* -w */
+#define OCL_FILTER_MIN_LEVELS 4  /* -p */
+#define OCL_FILTER_VAR_LIST 5    /* -v */
+#define OCL_FILTER_EXPR 6        /* -x, checked along with the stage above
+                                    whose fields it needs - see oclExpr.c */
+#define OCL_NUM_FILTERS 7
+
+/* Filter expression (oclfilt -x) instructions - the tests that push a true
+   or false, and the operators that pop their operands and push the result */
+#define OCL_EXPR_AND 0
+#define OCL_EXPR_OR 1
+#define OCL_EXPR_NOT 2
+#define OCL_EXPR_YEAR 3          /* year lo,hi */
+#define OCL_EXPR_MONTH 4         /* month lo,hi (can wrap the new year) */
+#define OCL_EXPR_DAY 5           /* day lo,hi (of year, can wrap too) */
+#define OCL_EXPR_REGION 6        /* region w/e/s/n, as for -l */
+#define OCL_EXPR_VARS 7          /* vars list, as for -v */
+#define OCL_EXPR_COUNTRY 8       /* country list */
+#define OCL_EXPR_CRUISE 9        /* cruise list */
+#define OCL_EXPR_LEVELS 10       /* levels lo,hi */
+#define OCL_EXPR_MAX_OPS 64
+#define OCL_EXPR_MAX_VALUES MAX_VARS
+
+/* true if a profile value is error-flagged or missing (NaN) */
+#define OCL_VALUE_FLAGGED(value,errCode) \
+   ( (errCode)!=0 || !((value)>0 || (value)<=0) )
 
 
 /* Structures */
+
+/* Arena ("bump") allocator that a station's variable-length data is carved
+   out of, and let go of all at once by a reset - see oclArena.c */
+typedef struct OCLArena {
+      char *base;              /* the arena's block of memory */
+      long int size;           /* bytes in block */
+      long int used;           /* bytes of it handed out since last reset */
+      union OCLArenaChunk *overflow;  /* chunks malloc'ed for what didn't fit
+                                  in block, till the next reset */
+      long int overflowBytes;  /* bytes handed out in them */
+      long int peak;           /* most bytes handed out between resets */
+      long int numAllocs;      /* counts of allocOCLArena() calls, */
+      long int numHeapAllocs;  /*  malloc()s done for them, */
+      long int numResets;      /*  and resets */
+      long int lastHeapAllocReset;  /* numResets at the last malloc() */
+}  OCLArenaType;
+
+/* One filter expression instruction */
+typedef struct OCLExprOp {
+      int code;                /* OCL_EXPR_... */
+      long int numValues;      /* values of a list, or a range's lo & hi */
+      long int value[OCL_EXPR_MAX_VALUES];
+      double region[4];        /* w/e/s/n for OCL_EXPR_REGION */
+}  OCLExprOpType;
+
+/* A filter expression compiled by compileOCLExpr(): its instructions in
+   postfix order, for evalOCLExpr() to run on each station's header */
+typedef struct OCLExpr {
+      long int numOps;
+      OCLExprOpType op[OCL_EXPR_MAX_OPS];
+      int readyStage;          /* the OCL_FILTER_... stage whose header
+                                  fields are the last ones the tests need */
+}  OCLExprType;
+
+/* getOCLStationData()'s filter args, gathered up by setOCLStationFilters()
+   to be checked a stage at a time as the station's header is read */
+typedef struct OCLStationFilters {
+      int yearRangeFlag;
+      long int *yearRange;
+      int monthRangeFlag;
+      long int *monthRange;
+      int latlonRegionFlag;
+      double *latlonRegion;
+      int zeroLatLonFlag;
+      char *wmoSquare;
+      int minLevelsFlag;
+      long int minLevels;
+      int varListFlag;
+      long int *varList;
+      long int numVarsOnVarList;
+      OCLExprType *expr;       /* the station's filterExpr, or NULL */
+      long int numExprs;       /*  and the rest of its filter expressions, */
+      char *exprMatches;       /*  which it sets, */
+      int exprReadyStage;      /*  and the latest readyStage among them */
+}  OCLStationFiltersType;
+
+/* Counts of stations checked and cut at each filter stage (OCL_FILTER_...),
+   kept if the caller points a station's filterCounts at one - a stage only
+   sees the stations the ones before it passed */
+typedef struct OCLFilterCounts {
+      long int numChecked[OCL_NUM_FILTERS];
+      long int numCut[OCL_NUM_FILTERS];
+      long int bytesSkipped;   /* bytes of cut stations skipped undecoded */
+}  OCLFilterCountsType;
+
+/* What an OCL file's sidecars (station index, bathy sidecar) are keyed to,
+   so that one made for some other file is caught rather than used: the
+   file's size and a checksum of its first and last OCL_SOURCE_KEY_BYTES
+   bytes.  See getOCLSourceKey() in oclSource.c */
+#define OCL_SOURCE_KEY_BYTES 8192
+typedef struct OCLSourceKey {
+      long int fileSize;
+      unsigned long int checksum;
+}  OCLSourceKeyType;
+
+
+/* Bathymetry database, memory-mapped: a grid, for looking up bottom depths
+   by position, or one OCL file's sidecar, for looking them up by station
+   number - see oclBathy.c */
+#define OCL_BATHY_GRID 1
+#define OCL_BATHY_SIDECAR 2
+typedef struct OCLBathy {
+      int kind;                /* OCL_BATHY_GRID or OCL_BATHY_SIDECAR */
+      /* a grid's */
+      long int numLons;        /* grid nodes east-west */
+      long int numLats;        /*  and north-south */
+      long int tileSize;       /* nodes on a side of each tile */
+      long int tilesPerRow;    /* (tiles east-west) */
+      double lon0;             /* position of the southwest node */
+      double lat0;
+      double dlon;             /* node spacing, degrees */
+      double dlat;
+      int wrapLon;             /* true if the columns go all the way round */
+      const float *z;          /* the tiles of elevations, in the mapping */
+      /* a sidecar's */
+      OCLSourceKeyType key;    /* the OCL file it was made for */
+      long int numStations;    /* (the number of stations in that file) */
+      double latLimit;         /* its domain is within this lat of the
+                                  equator */
+      const double *stnZ;      /* each station's elevation, in the mapping */
+      const char *base;        /* the mapped file */
+      long int len;
+}  OCLBathyType;
+
 typedef struct OCLStation {
 
       /* actual data-file contents */
@@ -33,16 +191,29 @@ typedef struct OCLStation {
       long int bytesInCharPI;
       long int bytesInSecHdr;
       long int numberOfSecHdrEntries;
-      long int secHdrCode[MAX_VARS];
-      long int bytesInBioHdr;
+      long int *secHdrCode;    /* (numberOfSecHdrEntries of these two, in */
+      long int bytesInBioHdr;  /*  the station's arena - see below)       */
       double time;
       double lat;
       double lon;
-      double secHdrValue[MAX_VARS];
-      double depthValue[MAX_LEVELS];
-      double varValue[MAX_VARS][MAX_LEVELS];
-      long int errCodeForDepthValue[MAX_LEVELS];
-      long int errCodeForVarValue[MAX_VARS][MAX_LEVELS];
+      double *secHdrValue;
+      /* the profile - numberOfLevels values in each of these (and in the
+         first numberOfVarCodes of varValue[] & errCodeForVarValue[]), which
+         point into the station's arena but are indexed just like arrays,
+         eg varValue[k][j].  Only set once a profile is read, and only for
+         the variables in decodedVars - the rest are left NULL. */
+      double *depthValue;
+      double *varValue[MAX_VARS];
+      unsigned char *errCodeForDepthValue;  /* (single digit OCL flags) */
+      unsigned char *errCodeForVarValue[MAX_VARS];
+      unsigned int *levelFlags;  /* per level, OCL_DEPTH_BIT and OCL_VAR_BIT(k)
+                                  set for values there that are error-flagged
+                                  or missing, as made while decoding */
+      unsigned int anyLevelFlagged;  /* all of levelFlags or'ed together, ie
+                                  which columns have any flagged levels */
+      unsigned int decodedVars;  /* OCL_VAR_BIT(k) set for each variable
+                                  whose column was decoded: all of them,
+                                  unless there's a projection (below) */
 
       /* added info for this station */
       double *bottomDepthPtr;  /* points to either secondary hdr, last profile
@@ -71,6 +242,11 @@ typedef struct OCLStation {
       char bottomDepthSource;  /* 'h'=secondary hdr, 'p'=last profile depth,
                                   'd'=bathy database                         */
       double dbBathy;          /* bathy value for this lat/lon from database */
+      OCLBathyType *bathy;     /* the caller's bathy grid or sidecar, to
+                                  look dbBathy up in (by position, or by
+                                  station number) rather than read it from
+                                  the bathy file, or NULL (as
+                                  initOCLStation() leaves it) for the file */
       int varListChecksOut;    /* flag, specifies whether stn includes all
                                   variables on varList                       */
       int badLatLon;           /* flag specifying that lat & lon values of zero
@@ -86,10 +262,284 @@ typedef struct OCLStation {
                                   range specified by yearRange[] array */
       int enoughProfileLevels; /* flag saying minimum number of profile levels
                                   for reporting this profile was okay */
+      int exprPasses;          /* flag saying the station's header satisfies
+                                  filterExpr (any of them, if several) */
+
+      /* where the secondary header entries and profile go (see oclArena.c):
+         the struct's own ownArena, reset as each station is read - unless
+         arena is pointed at the caller's own arena, which the caller then
+         resets, eg to keep several stations' data at once.  A struct that
+         isn't static needs initOCLStation() before its first use, and
+         freeOCLStation() releases ownArena's memory. */
+      OCLArenaType *arena;     /* (NULL for ownArena) */
+      OCLArenaType ownArena;
+
+      /* the profile projection, also set by the caller: if numProjectionVars
+         is more than zero, only the columns of the variables whose codes are
+         in projectionVars[] (the caller's array) get decoded, and the rest
+         are stepped over by their length digits without being converted or
+         stored.  initOCLStation() starts with none, ie all columns. */
+      long int numProjectionVars;
+      long int *projectionVars;
+
+      OCLFilterCountsType *filterCounts;  /* the caller's, for counting the
+                                  stations cut at each filter stage, or NULL
+                                  (as initOCLStation() leaves it) for none */
+      OCLExprType *filterExpr; /* the caller's compiled filter expressions,
+                                  checked with the other filters, or NULL
+                                  (as initOCLStation() leaves it) for none */
+      long int numFilterExprs; /* how many of them there are in filterExpr[]
+                                  - a station passes if it satisfies any */
+      char *filterExprMatches; /* the caller's array of numFilterExprs flags,
+                                  set to which ones it satisfies, or NULL */
 
 }  OCLStationType;
 
 
+/* Byte source for the decoder - either a stdio stream, or a span of the whole
+   file's bytes in memory (a mapped file or a decompressed buffer) that's read
+   by moving a cursor along it.  See oclSource.c */
+typedef struct OCLSource {
+      FILE *fp;                /* stdio stream, or NULL if reading from span */
+      const char *base;        /* first byte of span */
+      long int len;            /* number of bytes in span */
+      long int pos;            /* cursor: offset of next byte to read in span */
+      int atEOF;               /* like feof(): set once a read hits span end */
+      int isMapped;            /* span was mmap'ed by mapOCLSource() */
+      int isOwned;             /* span was malloc'ed by loadOCLGzSource() */
+      int lineGeometry;        /* 0=not checked yet, 1=fixed-width lines so
+                                  can jump to next station, -1=can't jump */
+      long int lineLen;        /* chars of data per line (eg 80) */
+      long int lineWidth;      /* bytes per line including the \n or \r\n */
+      const char *cacheProfiles;  /* if the span is an OCL cache file, where
+                                  its profile columns start (which is where
+                                  its station header table ends), else NULL.
+                                  See oclCache.c */
+}  OCLSourceType;
+
+
+/* One station's row in the header table of an OCL cache file: the station's
+   fixed-size header fields as getOCLStationData() decodes them, plus where
+   to find its secondary header entries and profile columns.  Fixed width,
+   so station i's row is just table[i].  The header fields are ints, to keep
+   the table small, with INT_MIN standing for a blank field's NaN (as a long
+   int).  See oclCache.c */
+typedef struct OCLCacheStation {
+      long int oclStationNumber;
+      long int profileOffset;  /* where the secondary header entries and
+                                  profile columns start, counting from the
+                                  start of the profile section */
+      double time;
+      double lat;
+      double lon;
+      double bottomDepth;      /* bottom depth without a bathy database (from
+                                  sec hdr or deepest profile depth), or NaN */
+      int bytesInStation;      /* (of the station in the OCL file) */
+      int bytesLeftInStation;  /* (after reading the whole station) */
+      int countryCode;
+      int cruiseNumber;
+      int year;
+      int month;
+      int day;
+      int numberOfLevels;
+      int stationType;
+      int numberOfVarCodes;
+      int varCode[MAX_VARS];
+      int errCodeForVarCode[MAX_VARS];
+      int bytesInCharPI;
+      int bytesInSecHdr;
+      int numberOfSecHdrEntries;  /* (the entries are with the profile
+                                     columns) */
+      int bytesInBioHdr;
+      int bottomDepthSource;   /* 'h', 'p', or '-' as in OCLStationType */
+      int numProfileLevels;    /* levels in the profile columns (same as
+                                  numberOfLevels, or 0 if that's bad) */
+      int mantissaSize;        /* bytes in each of the station's values'
+                                  mantissas: sizeof(int), or sizeof(long int)
+                                  if one doesn't fit in an int */
+}  OCLCacheStationType;
+
+
+
+/* A decoder: everything getOCLStationData() keeps from one station of an
+   input to the next - the byte source, the bathy file read in step with it,
+   the filters, and the last station decoded (in its own arena) - in one
+   object the caller owns.  Nothing is shared between decoders, so several
+   can run at once, eg one per thread on separate files.  See initOCLDecoder()
+   in getOCLStationData.c */
+typedef struct OCLDecoder {
+      OCLSourceType src;       /* the input, set up by the caller */
+      FILE *fp_dbBathy;        /* bathy file for src (as with oclfilt -d), or
+                                  NULL for none (or for a bathy grid, in
+                                  stnData.bathy instead) */
+      OCLStationFiltersType filters;  /* see setOCLStationFilters() */
+      long int stn;            /* station # of the next station in src */
+      OCLStationType stnData;  /* the last station decoded */
+      double bottomDepth;      /* its bottom depth by value, or NaN */
+      char bottomDepthSource;  /* and where that came from, as in
+                                  OCLStationType */
+}  OCLDecoderType;
+
+
+
+/* Spatial index ("grid") of station positions over a set of OCL files,
+   for -l region queries - see oclGrid.c */
+typedef struct OCLGridFile {
+      char name[256];
+      long int fileSize;       /* size of the OCL file when it was gridded */
+      long int numStations;
+      long int totalBytes;     /* sum of the stations' bytesInStation */
+}  OCLGridFileType;
+
+typedef struct OCLGridEntry {
+      long int file;           /* which file in the grid's file table */
+      long int stn;            /* station number in that file (from 0) */
+      long int offset;         /* byte offset in file where station starts */
+      double lat;
+      double lon;
+      short int year;          /* station's date, for -y/-m/-D queries */
+      short int dayOfYear;     /* (1-366, or 0 if the month/day is bad) */
+      unsigned char month;
+}  OCLGridEntryType;
+
+typedef struct OCLGrid {
+      long int numFiles;
+      OCLGridFileType *file;
+      long int numEntries;
+      OCLGridEntryType *entry; /* numEntries entries, binned by cell */
+      long int *cellStart;     /* cell c's entries start at entry[cellStart[c]]
+                                  (and cellStart[c+1] is where they stop) */
+      unsigned long int *cellMonths;  /* bitmap of the months found in each
+                                  cell (bit m for month m, bit 31 for any
+                                  month from 31 up) */
+      long int allocatedFiles;    /* (room in file[] and entry[], while */
+      long int allocatedEntries;  /*  files are being added)            */
+}  OCLGridType;
+
+
+/* Where the next level of a station's profile comes from, for reading the
+   profile a level at a time - see getOCLStationHeader() */
+typedef struct OCLProfileCursor {
+      OCLSourceType *src;
+      OCLStationType *stnData;
+      long int level;          /* next level to be read */
+      long int numLevels;      /* levels in the profile */
+      const char *cacheMantissas;  /* the station's profile columns if src
+                                  is an OCL cache file, else NULL: the
+                                  values' mantissas, */
+      long int cacheMantissaSize;  /*  their size, */
+      const unsigned char *cachePrecisions;  /* precisions */
+      const unsigned char *cacheErrCodes;    /* and error codes */
+}  OCLProfileCursorType;
+
+
+/* Counts for oclfilt's -e/-q summary line, from filterOCLStations() */
+typedef struct OCLFiltStats {
+      long int stationOutputCount;       /* stations that passed filters */
+      long int totalStationOutputBytes;  /* bytes in those stations */
+      long int totalStationBytes;        /* bytes in all stations read */
+      long int endStn;         /* station loop's i at the end (ie number of
+                                  stations read, counting skipped ones) */
+}  OCLFiltStatsType;
+
+
+/* One query of oclfilt's -X batch mode: the file that gets the stations
+   satisfying its expression (opt->queryExpr[] has the expressions) */
+typedef struct OCLFiltQuery {
+      char outFilename[256];
+      FILE *fp_out;
+      OCLFiltStatsType stats;  /* (for the input file being filtered) */
+      int done;                /* got its -n stations from this input file */
+}  OCLFiltQueryType;
+
+
+/* oclfilt's settings from its command line, filled in by parse_commandline()
+   and the same for every input file it filters.  See oclfilt.c */
+typedef struct OCLFiltOptions {
+      int botDepthFiltFlag;    /* -b */
+      double shallowerDLimit;
+      double deeperDLimit;
+      int varListFlag;         /* -v */
+      long int numVarsOnVarList;
+      long int varList[MAX_VARS];
+      int projectionFlag;      /* -V: the only columns decoded & output */
+      long int numProjectionVars;
+      long int projectionVars[MAX_VARS];
+      int exprFlag;            /* -x */
+      OCLExprType expr;
+      int batchFlag;           /* -X: the queries from the query file, */
+      long int numQueries;
+      OCLFiltQueryType *query;
+      OCLExprType *queryExpr;  /*  their expressions (one array, for the */
+      char *queryMatches;      /*  decoder to check at once), and flags */
+      int debugFlag;           /* -f */
+      int endStatsFlag;        /* -e */
+      int titlesFlag;          /* (-t turns off) */
+      int queryFlag;           /* -q */
+      int recordFlag;          /* -B */
+      int soundSpeedFlag;      /* -S */
+      int databaseBathyFlag;   /* -d */
+      char dbBathyFilename[256];
+      int bathyKind;           /* (-d's file is a bathy grid or sidecar -
+                                  OCL_BATHY_GRID/SIDECAR - or 0 for a
+                                  lat-lon-depth file) */
+      OCLBathyType bathy;      /* (a grid or sidecar, mapped by main()) */
+      int numStnsFlag;         /* -n */
+      long int numStnsToOutput;
+      int skipFlag;            /* -s */
+      long int stnToSkipTo;
+      int zeroLatLonFlag;      /* -w */
+      char wmoSquare[5];
+      int minLevelsFlag;       /* -p */
+      long int minLevels;
+      int latlonRegionFlag;    /* -l */
+      double latlonRegion[4];
+      int yearRangeFlag;       /* -y */
+      long int yearRange[2];
+      int monthRangeFlag;      /* -m */
+      long int monthRange[2];
+      int dayRangeFlag;        /* -D */
+      long int dayRange[2];
+      int includeErrorFlaggedData;  /* -r */
+      int mapInputFlag;        /* -M */
+      int oclStnFlag;          /* -k */
+      long int oclStnToSkipTo;
+      char indexFilename[256]; /* -I, or "" for <infilename>.idx */
+      int outFileFlag;         /* -o */
+      char outFilename[256];
+      int outDirFlag;          /* -O */
+      char outDirname[256];
+      long int numJobs;        /* -j: worker processes for input files */
+      long int numInFiles;     /* -i and the rest of cmdline; 0 means stdin */
+      char **inFilename;
+      int gridFlag;            /* -G */
+      char gridFilename[256];
+      OCLGridType grid;        /* -G grid, loaded by main(), and stations */
+      OCLGridEntryType *gridHit;  /* in it passing -l/-y/-m/-D, in file/stn
+                                     order */
+      long int *gridHitStart;  /* input file f's are gridHit[gridHitStart[f]]
+                                  up to gridHit[gridHitStart[f+1]-1] */
+      int arenaStatsFlag;      /* -c */
+      OCLArenaType arena;      /* stations are decoded into this, one per
+                                  process (so per -j worker) */
+      OCLFilterCountsType filterCounts;  /* (-c too, also per process) */
+}  OCLFiltOptionsType;
+
+
+/* Station offset index for an OCL file - see oclIndex.c */
+typedef struct OCLIndexEntry {
+      long int offset;         /* byte offset in file where station starts */
+      long int length;         /* bytes from there to start of next station */
+      long int oclStationNumber;
+}  OCLIndexEntryType;
+
+typedef struct OCLIndex {
+      OCLSourceKeyType key;    /* the OCL file that was indexed */
+      long int numStations;
+      OCLIndexEntryType *entry;  /* numStations entries, in file order */
+}  OCLIndexType;
+
+
 
 /* Function Prototypes -
    (not all these functions are globally used, most only within one other
@@ -104,26 +554,170 @@ int getOCLStationData( FILE *fp_in, long int stn, OCLStationType *stnData,
    int yearRangeFlag, long int *yearRange,
    int monthRangeFlag, long int *monthRange,
    int dbBathyFlag, FILE *fp_dbBathy, int zeroLatLonFlag, char *wmoSquare );
-int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
-   int *botDepthFiltFlag, double *shallowerDLimit, double *deeperDLimit,
-   int *varListFlag, long int *numVarsOnVarList, long int *varList,
-   int *debugFlag, int *endStatsFlag, int *titlesFlag, int *queryFlag,
-   int *databaseBathyFlag, char *databaseBathyFilename,
-   int *numStnsFlag, long int *numStnsToOutput,
-   int *skipFlag, long int *stnToSkipTo,
-   int *zeroLatLonFlag, char *wmoSquare,
-   int *minLevelsFlag, long int *minLevels,
-   int *latlonRegionFlag, double *latlonRegion,
-   int *yearRangeFlag, long int *yearRange,
-   int *monthRangeFlag, long int *monthRange,
-   int *includeErrorFlaggedData );
+int getOCLStationDataSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData,
+   int wantProfileFlag, int skipFlag, long int stnToSkipTo,
+   int varListFlag, long int *varList, long int numVarsOnVarList,
+   int minLevelsFlag, long int minLevels,
+   int latlonRegionFlag, double *latlonRegion,
+   int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange,
+   int dbBathyFlag, FILE *fp_dbBathy, int zeroLatLonFlag, char *wmoSquare );
+void initOCLDecoder( OCLDecoderType *dec );
+int decodeOCLStation( OCLDecoderType *dec, int wantProfileFlag );
+void freeOCLDecoder( OCLDecoderType *dec );
+int getOCLStationHeader( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor );
+int readOCLStationHeaderSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, int skipFlag, long int stnToSkipTo,
+   int dbBathyFlag, FILE *fp_dbBathy, OCLStationFiltersType *filters );
+int startOCLProfileSrc( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor );
+int readOCLProfileLevels( OCLProfileCursorType *cursor, long int numLevels );
+int skipOCLProfileLevels( OCLProfileCursorType *cursor, long int numLevels );
+int finishOCLStation( OCLProfileCursorType *cursor );
+int getOCLCacheStationHeader( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor );
+int getOCLCacheStationData( OCLSourceType *src, long int stn,
+   OCLStationType *stnData,
+   int wantProfileFlag, int skipFlag, long int stnToSkipTo,
+   int dbBathyFlag, FILE *fp_dbBathy, OCLStationFiltersType *filters );
+void setOCLBottomDepth( OCLStationType *stnData, long int stn,
+   int dbBathyFlag, FILE *fp_dbBathy );
+double getOCLBottomDepth( OCLStationType *stnData );
+void setOCLStationFilters( OCLStationFiltersType *filters,
+   int varListFlag, long int *varList, long int numVarsOnVarList,
+   int minLevelsFlag, long int minLevels,
+   int latlonRegionFlag, double *latlonRegion,
+   int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange,
+   int zeroLatLonFlag, char *wmoSquare );
+void clearOCLStationFilterFlags( OCLStationType *stnData );
+int checkOCLFilterStage( OCLStationType *stnData,
+   OCLStationFiltersType *filters, int stage );
+int checkOCLStationFilters( OCLStationType *stnData, int wantProfileFlag,
+   OCLStationFiltersType *filters );
+void reportOCLFilterCounts( OCLFilterCountsType *counts, FILE *fp,
+   char *label );
+void skipOCLBathyLine( OCLStationType *stnData, int dbBathyFlag,
+   FILE *fp_dbBathy );
+void checkOCLBottomDepth( OCLStationType *stnData, int dbBathyFlag );
+void initOCLStation( OCLStationType *stnData );
+int allocOCLStationSecHdr( OCLStationType *stnData, long int numEntries );
+int allocOCLStationProfile( OCLStationType *stnData, long int numLevels,
+   long int numVars );
+void freeOCLStation( OCLStationType *stnData );
+void setOCLLevelFlags( OCLStationType *stnData );
+int inOCLCyclicRange( long int value, long int *range );
+long int oclDayOfYear( long int year, long int month, long int day );
+int parse_commandline( int argc, char **argv, OCLFiltOptionsType *opt );
+int filterOCLFile(OCLFiltOptionsType *opt, char *infilename, FILE *fp_out);
+int filterOCLStations(OCLFiltOptionsType *opt, OCLSourceType *src,
+   FILE *fp_dbBathy, long int firstStn, long int endStn,
+   int skipFlag, long int stnToSkipTo, FILE *fp_out, OCLFiltStatsType *stats);
+int filterOCLInput(OCLFiltOptionsType *opt, long int f, FILE *fp_out);
+int loadOCLFiltGrid(OCLFiltOptionsType *opt);
+int filterOCLGridFile(OCLFiltOptionsType *opt, long int f, FILE *fp_out);
+int openOCLInput(OCLFiltOptionsType *opt, char *infilename,
+   OCLSourceType *src, FILE **fp_in);
+void outputQueryHeader(OCLFiltOptionsType *opt, FILE *fp_out);
+void outputOCLStation(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, FILE *fp_out);
+void outputOCLStationRecord(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, unsigned int outputVars,
+   unsigned int varListFlags, FILE *fp_out);
+void outputSoundSpeedHeader(OCLFiltOptionsType *opt, FILE *fp_out);
+void outputOCLStationSoundSpeeds(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, unsigned int outputVars,
+   unsigned int varListFlags, FILE *fp_out);
+int routeOCLStation(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, int outputThisStation);
+int readOCLFiltQueries(OCLFiltOptionsType *opt, char *queryFilename);
+void outputSummary(OCLFiltOptionsType *opt, OCLFiltStatsType *stats,
+   FILE *fp_out);
+int runOCLFiltStationJobs(OCLFiltOptionsType *opt, char *infilename,
+   OCLSourceType *src, OCLIndexType *idx, long int firstStn,
+   int skipFlag, long int stnToSkipTo, FILE *fp_out, OCLFiltStatsType *stats);
+int runOCLFiltJobs(OCLFiltOptionsType *opt, FILE *fp_out);
 int getIntDigits(FILE *fp, int numDigits, long int *value);
 int getVarlenIntField(FILE *fp, long int *value, long int *bytesLeftInStation);
 int getVarlenFloatField(FILE *fp, double *value, long int *bytesLeftInStation);
 int skipToNextStation(FILE *fp, long int bytesLeftInStation);
+int getIntDigitsSrc(OCLSourceType *src, int numDigits, long int *value);
+int getVarlenIntFieldSrc(OCLSourceType *src, long int *value,
+   long int *bytesLeftInStation);
+int getVarlenFloatFieldSrc(OCLSourceType *src, double *value,
+   long int *bytesLeftInStation);
+int skipVarlenFloatFieldSrc(OCLSourceType *src,
+   long int *bytesLeftInStation);
+int skipToNextStationSrc(OCLSourceType *src, long int bytesLeftInStation);
+void setOCLSourceFile(OCLSourceType *src, FILE *fp);
+void setOCLSourceBuffer(OCLSourceType *src, const char *buf, long int len);
+int mapOCLSource(OCLSourceType *src, char *filename);
+int isGzipFile(char *filename);
+int loadOCLGzSource(OCLSourceType *src, char *filename);
+void closeOCLSource(OCLSourceType *src);
+int endOfOCLSource(OCLSourceType *src);
+long int tellOCLSource(OCLSourceType *src);
+int seekOCLSource(OCLSourceType *src, long int offset);
+long int sizeOfOCLSource(OCLSourceType *src);
+int getOCLSourceKey(OCLSourceType *src, OCLSourceKeyType *key);
+int sameOCLSourceKey(const OCLSourceKeyType *a, const OCLSourceKeyType *b);
+int checkOCLLineGeometry(OCLSourceType *src);
+int jumpToNextStation(OCLSourceType *src, long int bytesLeftInStation);
+int buildOCLIndex(OCLSourceType *src, OCLIndexType *idx);
+int writeOCLIndex(char *filename, OCLIndexType *idx);
+int readOCLIndex(char *filename, OCLIndexType *idx);
+void freeOCLIndex(OCLIndexType *idx);
+long int findOCLIndexStation(OCLIndexType *idx, long int oclStationNumber);
+int seekOCLStation(OCLSourceType *src, OCLIndexType *idx, long int stn);
+int matchOCLIndex(OCLSourceType *src, OCLIndexType *idx);
+extern const double oclPowersOfTen[10];
+int writeOCLCache(char *filename, OCLSourceType *src);
+int isOCLCacheFile(char *filename);
+int openOCLCache(OCLSourceType *src, char *filename);
+long int sizeOfOCLCacheProfile(const OCLCacheStationType *row);
+void getOCLCacheValues(const char *mantissas, long int mantissaSize,
+   const unsigned char *precisions, long int first, long int n,
+   double *values);
+void initOCLArena( OCLArenaType *arena );
+void *allocOCLArena( OCLArenaType *arena, long int nbytes );
+void resetOCLArena( OCLArenaType *arena );
+void freeOCLArena( OCLArenaType *arena );
+void reportOCLArena( OCLArenaType *arena, FILE *fp, char *label );
+int writeOCLBathy(char *filename, OCLBathyType *bathy, const float *z);
+int isOCLBathyFile(char *filename);
+int mapOCLBathy(char *filename, OCLBathyType *bathy);
+void closeOCLBathy(OCLBathyType *bathy);
+void lookupOCLBathy(const OCLBathyType *bathy, long int n, const double *lat,
+   const double *lon, double *z);
+double lookupOCLBathyStation(const OCLBathyType *bathy, long int stn);
+int matchOCLBathySidecar(const OCLBathyType *sidecar, OCLSourceType *src,
+   long int numStations);
+int writeOCLBathySidecar(char *filename, OCLSourceType *src,
+   const OCLBathyType *grid, FILE *fp_dbBathy);
+void initOCLGrid(OCLGridType *grid);
+int addOCLGridFile(OCLGridType *grid, char *filename);
+int finishOCLGrid(OCLGridType *grid);
+int writeOCLGrid(char *filename, OCLGridType *grid);
+int readOCLGrid(char *filename, OCLGridType *grid);
+void freeOCLGrid(OCLGridType *grid);
+long int queryOCLGrid(OCLGridType *grid, int latlonRegionFlag,
+   double *latlonRegion, int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange, int dayRangeFlag,
+   long int *dayRange, OCLGridEntryType **hit);
 char *varCodeLabel(long int oneVarCode);
 char *varCodeUnits(long int oneVarCode);
 int checkVarsInclAndNoErrors(long int *varRequestedList, long int *varCodeList,
    long int *errCodeList, long int numVarsRequested, long int numVarCodes);
 int zeroLatLonOkay( char *wmoSquare, char *latlon );
+char *formatOCLFixed( char *p, const char *prefix, double x, int width,
+   int decimals );
+char *formatOCLLong( char *p, const char *prefix, long int v, int width );
+char *formatOCLString( char *p, const char *s, int width );
+void setOCLOutputBuffer( FILE *fp );
+int sspcm2(double P, double T, double S, double *sndspd);  /* (these two */
+double depth2pres(double depth);           /* are in ../sspcomp/sspcm2.c) */
+int compileOCLExpr( char *text, OCLExprType *expr );
+int evalOCLExpr( OCLExprType *expr, OCLStationType *stnData );
 double nan();
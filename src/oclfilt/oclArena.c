@@ -0,0 +1,172 @@
+/* oclArena.c -
+ *             Arena ("bump") allocator for decoded station data.  The
+ *             variable-length parts of a station - its secondary header
+ *             entries and profile columns - are carved out of one block of
+ *             memory by just moving a counter along it, and all of it is let
+ *             go at once by resetting the counter when the next station is
+ *             read.  Nothing is freed piece by piece.
+ *
+ *             Whatever doesn't fit in the block gets its own malloc'ed
+ *             overflow chunk, and at the next reset those are freed and the
+ *             block is regrown big enough for all of it (at least doubling).
+ *             So the block soon gets as big as the biggest station, and from
+ *             then on a reset just zeroes the counter, and decoding a station
+ *             does no heap allocations at all.  The counts kept here (and
+ *             printed by reportOCLArena(), eg with oclfilt's -c option) show
+ *             when that happened.
+ *
+ *             A station read into an OCLStationType goes in the station's own
+ *             arena, reset at every station, unless the caller points the
+ *             station's arena at one of its own - then the caller resets it,
+ *             eg to hold several stations at once (see ocl.h).
+ *
+ * other required sources/files: ocl.h
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             OCLArenaType arena;
+ *             initOCLArena( &arena );
+ *             initOCLStation( &stnData );
+ *             stnData.arena = &arena;
+ *             for( i=0; !endOfOCLSource(&src); i++ ) {
+ *                resetOCLArena( &arena );
+ *                getOCLStationDataSrc( &src, i, &stnData, ... );
+ *                ...
+ *             }
+ *             reportOCLArena( &arena, stderr, "myprog" );
+ *             freeOCLArena( &arena );
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "ocl.h"
+
+/* an overflow chunk's header, which the chunk's memory follows - the union
+   also gives the alignment that everything handed out is rounded to */
+union OCLArenaChunk {
+      union OCLArenaChunk *next;
+      double d;
+      long int l;
+      void *p;
+};
+
+#define OCL_ARENA_ALIGN ((long int)sizeof(union OCLArenaChunk))
+
+
+
+
+/* "Init OCL arena" - start off an arena with no memory (a static one already
+   starts off that way) */
+void initOCLArena( OCLArenaType *arena ) {
+   arena->base = NULL;
+   arena->size = 0;
+   arena->used = 0;
+   arena->overflow = NULL;
+   arena->overflowBytes = 0;
+   arena->peak = 0;
+   arena->numAllocs = 0;
+   arena->numHeapAllocs = 0;
+   arena->numResets = 0;
+   arena->lastHeapAllocReset = 0;
+}
+
+
+
+
+/* "Alloc OCL arena" - nbytes from the arena, aligned for any of the station
+   data types, and good until the arena's next reset.  NULL if out of
+   memory. */
+void *allocOCLArena( OCLArenaType *arena, long int nbytes ) {
+   union OCLArenaChunk *chunk;
+   char *p;
+
+   /* (even 0 bytes gets a unique non-NULL pointer) */
+   if( nbytes<=0 ) nbytes = OCL_ARENA_ALIGN;
+   nbytes = (nbytes+OCL_ARENA_ALIGN-1) / OCL_ARENA_ALIGN * OCL_ARENA_ALIGN;
+   arena->numAllocs++;
+
+   if( arena->size-arena->used >= nbytes ) {
+      p = arena->base + arena->used;
+      arena->used += nbytes;
+   }
+   else {
+      chunk = (union OCLArenaChunk *)malloc((size_t)(OCL_ARENA_ALIGN+nbytes));
+      if( chunk==NULL ) return NULL;
+      arena->numHeapAllocs++;
+      arena->lastHeapAllocReset = arena->numResets;
+      chunk->next = arena->overflow;
+      arena->overflow = chunk;
+      arena->overflowBytes += nbytes;
+      p = (char *)(chunk+1);
+   }
+
+   if( arena->used+arena->overflowBytes > arena->peak )
+      arena->peak = arena->used+arena->overflowBytes;
+   return p;
+}
+
+
+
+
+/* "Reset OCL arena" - let go of everything allocated from the arena.  Just
+   zeroes the counter, unless there were overflow chunks - then they're
+   freed and the block regrown to hold what they did too. */
+void resetOCLArena( OCLArenaType *arena ) {
+   union OCLArenaChunk *chunk;
+   long int size;
+
+   arena->numResets++;
+
+   if( arena->overflow!=NULL ) {
+      size = arena->used + arena->overflowBytes;
+      if( size < 2*arena->size ) size = 2*arena->size;
+      while( (chunk=arena->overflow) != NULL ) {
+         arena->overflow = chunk->next;
+         free(chunk);
+      }
+      free(arena->base);
+      arena->base = (char *)malloc((size_t)size);
+      if( arena->base!=NULL ) {
+         arena->size = size;
+         arena->numHeapAllocs++;
+         arena->lastHeapAllocReset = arena->numResets;
+      }
+      else arena->size = 0;  /* (so it'll be all chunks till memory frees) */
+   }
+
+   arena->used = 0;
+   arena->overflowBytes = 0;
+}
+
+
+
+
+/* "Free OCL arena" - release the arena's memory; it starts over as if just
+   initOCLArena()'d */
+void freeOCLArena( OCLArenaType *arena ) {
+   union OCLArenaChunk *chunk;
+
+   while( (chunk=arena->overflow) != NULL ) {
+      arena->overflow = chunk->next;
+      free(chunk);
+   }
+   free(arena->base);
+   initOCLArena(arena);
+}
+
+
+
+
+/* "Report OCL arena" - a comment line for fp with the arena's counts: how
+   many resets (ie stations, as oclfilt uses it) and allocations, the peak
+   bytes in use, and the heap allocations behind it all - and since which
+   reset there haven't been any */
+void reportOCLArena( OCLArenaType *arena, FILE *fp, char *label ) {
+   fprintf(fp, "%% %s: arena: %ld resets, %ld allocations, peak %ld bytes,"
+      " %ld heap allocations", label, arena->numResets, arena->numAllocs,
+      arena->peak, arena->numHeapAllocs);
+   if( arena->numHeapAllocs>0 )
+      fprintf(fp, " (none after reset %ld)", arena->lastHeapAllocReset);
+   fprintf(fp, "\n");
+}
@@ -0,0 +1,512 @@
+/* oclBathy.c -
+ *             Bathymetry databases for getting each station's bottom depth
+ *             as it's decoded, without reading a bathy file in lockstep:
+ *             a grid, looked up by position, or a sidecar, looked up by
+ *             station number.
+ *
+ *             Gridded bathymetry database, for looking up the bottom depth at
+ *             each station's position right as it's decoded (oclfilt -d
+ *             given a bathy grid file).  The old way was a lat-lon-depth
+ *             text file with one line per station of the OCL file, made
+ *             beforehand for every OCL file with outputAllLatsLons and GMT's
+ *             grdtrack, and read in lockstep with the stations - so any
+ *             station read out of order, or any change in what got read,
+ *             put the depths out of step.  With a grid there's nothing to
+ *             make per OCL file and nothing to keep in step: the one grid
+ *             does for every file, and the depth is looked up by position.
+ *
+ *             Grids are made once with makeOCLBathy (from lon lat z text,
+ *             eg out of GMT's grd2xyz) and memory-mapped to be read, so only
+ *             the parts of the grid around the stations actually looked up
+ *             get read off disk - a global grid at one arc-minute is the
+ *             best part of a GB, but a WMO square's worth of stations only
+ *             touches a few MB of it.  To keep that so, the nodes are stored
+ *             in square tiles rather than row by row: the four nodes around a
+ *             position are (nearly always) in the same tile, and stations
+ *             near each other in the same few tiles, rather than in rows a
+ *             whole grid width apart.
+ *
+ *             The elevation at a position is interpolated bilinearly from
+ *             the four nodes around it.  Positions off the grid, or next to
+ *             a node with no value (NaN), give NaN.  Lons are taken in
+ *             whichever style the grid is in (eg -75 on a 0 to 360 grid is
+ *             285), and a grid that goes all the way round wraps between its
+ *             last and first columns.  lookupOCLBathy() takes a whole batch
+ *             of positions at a time: the node offsets and weights for a
+ *             batch are all worked out first, then the nodes fetched, so the
+ *             fetches (which are what's slow, on a grid that's mostly not in
+ *             memory) don't each wait on the arithmetic before them.
+ *
+ *             Bathy grid file layout (native byte order, as written by
+ *             fwrite):
+ *               8 bytes         magic "OCLBTH1" + '\0'
+ *               long int        numLons, nodes east-west
+ *               long int        numLats, nodes north-south
+ *               long int        tileSize, nodes on a side of each tile
+ *               double          lon0, lat0 - position of the southwest node
+ *               double          dlon, dlat - node spacing in degrees
+ *               then the tiles, south to north and west to east within each
+ *               row of tiles, each tileSize x tileSize floats of elevation
+ *               (negative below sea level, as in GMT grids), south to north
+ *               and west to east within the tile.  Tiles along the north and
+ *               east edges are padded out with NaN.
+ *
+ *             A bathy sidecar is one OCL file's stations' values, made once
+ *             with makeOCLBathySidecar (from a bathy grid, or from the old
+ *             lat-lon-depth file for the OCL file) and kept next to it like
+ *             the station index (<oclfile>.bdep).  It's just the value for
+ *             each station in turn, so station i's is read straight off
+ *             the mapping, whichever stations get read and in whatever
+ *             order - skipped (-s), cut by the filters, or split among -j
+ *             workers.  Like the index, it records the key of the file it
+ *             was made for (its size and a checksum of its first and last
+ *             few KB, see getOCLSourceKey() in oclSource.c) and how many
+ *             stations that has, and matchOCLBathySidecar() checks both, so
+ *             a stale one or another file's gets caught.  Stations off a
+ *             grid get NaN.  A lat-lon-depth file's values are kept as
+ *             they are, along with the lat limit that goes with that file
+ *             (its domain is within 72 degrees of the equator, as oclfilt
+ *             -d takes the file itself) - so the sidecar gives the same
+ *             bottom depths as the file would.
+ *
+ *             Bathy sidecar layout (native byte order, as written by fwrite):
+ *               8 bytes         magic "OCLBSC2" + '\0'
+ *               long int        size in bytes of the OCL file (as it's read,
+ *                               eg decompressed)
+ *               unsigned long   checksum of its first and last few KB
+ *               long int        number of stations
+ *               double          lat limit (90, or 72 from a lat-lon-depth
+ *                               file)
+ *               numStations x   double, the elevation at each station
+ *                               (negative below sea level), or NaN
+ *
+ * other required sources/files: ocl.h, getOCLStationData.c, oclSource.c,
+ *                               oclIndex.c
+ *
+ * language:   ANSI C, plus POSIX mmap() for mapOCLBathy()
+ *
+ * Usage:
+ *             OCLBathyType bathy;
+ *             if( mapOCLBathy( "topo.bth", &bathy ) != SUCCESSFUL ) exit(1);
+ *             lookupOCLBathy( &bathy, n, lat, lon, z );
+ *             ...or with stnData.bathy = &bathy, getOCLStationData() with
+ *                dbBathyFlag set looks up each station's own...
+ *             closeOCLBathy( &bathy );
+ *
+ *             writeOCLBathySidecar( "ncts1311.bdep", &src, &bathy, NULL );
+ *             mapOCLBathy( "ncts1311.bdep", &sidecar );
+ *             if( matchOCLBathySidecar( &sidecar, &src, -1 ) == SUCCESSFUL )
+ *                z = lookupOCLBathyStation( &sidecar, stn );
+ */
+
+#define _POSIX_C_SOURCE 199506L  /* for mmap() etc with -ansi (but not
+                                    200112L, whose math.h has a nan() of
+                                    its own) */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "ocl.h"
+
+#define OCL_BATHY_MAGIC "OCLBTH1"   /* (plus its '\0' makes 8 bytes) */
+#define OCL_BATHY_SIDECAR_MAGIC "OCLBSC2"
+#define OCL_BATHY_HEADER_SIZE \
+   (8 + 3*(long int)sizeof(long int) + 4*(long int)sizeof(double))
+#define OCL_BATHY_SIDECAR_HEADER_SIZE \
+   (8 + 2*(long int)sizeof(long int) + (long int)sizeof(unsigned long int) \
+   + (long int)sizeof(double))
+#define OCL_BATHY_BATCH 64          /* positions at a time in lookupOCLBathy */
+
+
+
+
+/* "Size of OCL bathy tiles" - floats in the tiles of a grid of bathy's
+   numLons x numLats nodes, padding included (and sets bathy->tilesPerRow) */
+static long int sizeOfOCLBathyTiles(OCLBathyType *bathy) {
+   long int tilesPerCol;
+
+   bathy->tilesPerRow = (bathy->numLons+bathy->tileSize-1)/bathy->tileSize;
+   tilesPerCol = (bathy->numLats+bathy->tileSize-1)/bathy->tileSize;
+   return bathy->tilesPerRow*tilesPerCol*bathy->tileSize*bathy->tileSize;
+}
+
+
+
+
+/* "OCL bathy node" - offset into the tiles of node i (east-west), j
+   (north-south) */
+static long int oclBathyNode(const OCLBathyType *bathy, long int i,
+   long int j) {
+   long int t = bathy->tileSize;
+   return ((j/t)*bathy->tilesPerRow + i/t)*t*t + (j%t)*t + i%t;
+}
+
+
+
+
+/* "Write OCL bathy" - save a grid to a bathy grid file: bathy's numLons,
+   numLats, lon0, lat0, dlon, dlat and tileSize describe it, and z[] has its
+   numLons x numLats elevations row by row, south to north (so node i, j is
+   z[j*numLons+i]) - they're put into tiles here. */
+int writeOCLBathy(char *filename, OCLBathyType *bathy, const float *z) {
+
+   FILE *fp;
+   char magic[8];
+   float *tile;
+   long int t=bathy->tileSize, tx, ty, i, j, tilesPerCol;
+   int status=SUCCESSFUL;
+
+   if( bathy->numLons<2 || bathy->numLats<2 || t<1 ||
+       !(bathy->dlon>0.) || !(bathy->dlat>0.) ) {
+      fprintf(stderr, "writeOCLBathy: bad grid dimensions.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+   sizeOfOCLBathyTiles(bathy);
+   tilesPerCol = (bathy->numLats+t-1)/t;
+
+   if( (tile=(float *)malloc((size_t)(t*t)*sizeof(float))) == NULL ) {
+      fprintf(stderr, "writeOCLBathy: out of memory.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+   if( (fp=fopen(filename,"wb")) == NULL ) {
+      fprintf(stderr, "Unable to open file %s.\n", filename);
+      free(tile);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   memset(magic, 0, sizeof(magic));
+   strcpy(magic, OCL_BATHY_MAGIC);
+   if( fwrite(magic, sizeof(magic), 1, fp) != 1 ||
+       fwrite(&(bathy->numLons), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(bathy->numLats), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(bathy->tileSize), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(bathy->lon0), sizeof(double), 1, fp) != 1 ||
+       fwrite(&(bathy->lat0), sizeof(double), 1, fp) != 1 ||
+       fwrite(&(bathy->dlon), sizeof(double), 1, fp) != 1 ||
+       fwrite(&(bathy->dlat), sizeof(double), 1, fp) != 1 )
+      status=UNSPECIFIED_PROBLEM;
+
+   for(ty=0; ty<tilesPerCol && status==SUCCESSFUL; ty++)
+      for(tx=0; tx<bathy->tilesPerRow && status==SUCCESSFUL; tx++) {
+         for(j=0; j<t; j++)
+            for(i=0; i<t; i++)
+               tile[j*t+i] = ( tx*t+i<bathy->numLons &&
+                  ty*t+j<bathy->numLats ) ?
+                  z[(ty*t+j)*bathy->numLons + tx*t+i] : (float)nan();
+         if( (long int)fwrite(tile, sizeof(float), (size_t)(t*t), fp) != t*t )
+            status=UNSPECIFIED_PROBLEM;
+      }
+
+   if( fclose(fp) != 0 ) status=UNSPECIFIED_PROBLEM;
+   if( status!=SUCCESSFUL )
+      fprintf(stderr, "writeOCLBathy: unable to write %s.\n", filename);
+   free(tile);
+   return status;
+}
+
+
+
+
+/* "Is OCL bathy file" - OCL_BATHY_GRID or OCL_BATHY_SIDECAR if the file
+   starts with that one's magic, or 0 if neither (so oclfilt -d can tell them
+   from an old lat-lon-depth text file) */
+int isOCLBathyFile(char *filename) {
+   FILE *fp;
+   char magic[8];
+   int kind=0;
+
+   if( (fp=fopen(filename,"rb")) == NULL ) return 0;
+   if( fread(magic, sizeof(magic), 1, fp) == 1 ) {
+      if( !strncmp(magic, OCL_BATHY_MAGIC, sizeof(magic)) )
+         kind = OCL_BATHY_GRID;
+      else if( !strncmp(magic, OCL_BATHY_SIDECAR_MAGIC, sizeof(magic)) )
+         kind = OCL_BATHY_SIDECAR;
+   }
+   fclose(fp);
+   return kind;
+}
+
+
+
+
+/* "Map OCL bathy" - memory-map a bathy grid or sidecar file read-only, for
+   lookups (bathy->kind says which it is) */
+int mapOCLBathy(char *filename, OCLBathyType *bathy) {
+   int fd;
+   struct stat st;
+   void *p;
+   const char *hdr;
+
+   memset(bathy, 0, sizeof(*bathy));
+
+   if( (fd=open(filename, O_RDONLY)) < 0 ) {
+      fprintf(stderr, "Unable to open bathy file %s.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+   if( fstat(fd, &st) != 0 ||
+       (long int)st.st_size < OCL_BATHY_SIDECAR_HEADER_SIZE ) {
+      fprintf(stderr, "%s is not a bathy grid or sidecar file.\n", filename);
+      close(fd);
+      return UNSPECIFIED_PROBLEM;
+   }
+   p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);  /* (mapping stays valid after close) */
+   if( p == MAP_FAILED ) {
+      fprintf(stderr, "Unable to memory-map file %s.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+   bathy->base = (const char *)p;
+   bathy->len = (long int)st.st_size;
+
+   if( !strncmp(bathy->base, OCL_BATHY_SIDECAR_MAGIC, 8) ) {
+      bathy->kind = OCL_BATHY_SIDECAR;
+      hdr = bathy->base + 8;
+      memcpy(&(bathy->key.fileSize), hdr, sizeof(long int));
+      hdr += sizeof(long int);
+      memcpy(&(bathy->key.checksum), hdr, sizeof(unsigned long int));
+      hdr += sizeof(unsigned long int);
+      memcpy(&(bathy->numStations), hdr, sizeof(long int));
+      memcpy(&(bathy->latLimit), hdr+sizeof(long int), sizeof(double));
+      if( bathy->numStations<0 ||
+          bathy->len != OCL_BATHY_SIDECAR_HEADER_SIZE +
+             bathy->numStations*(long int)sizeof(double) ) {
+         fprintf(stderr, "Bathy sidecar file %s is truncated.\n", filename);
+         closeOCLBathy(bathy);
+         return UNSPECIFIED_PROBLEM;
+      }
+      bathy->stnZ = (const double *)(bathy->base +
+         OCL_BATHY_SIDECAR_HEADER_SIZE);
+      return SUCCESSFUL;
+   }
+
+   bathy->kind = OCL_BATHY_GRID;
+   hdr = bathy->base + 8;
+   memcpy(&(bathy->numLons), hdr, sizeof(long int));
+   memcpy(&(bathy->numLats), hdr+sizeof(long int), sizeof(long int));
+   memcpy(&(bathy->tileSize), hdr+2*sizeof(long int), sizeof(long int));
+   hdr += 3*sizeof(long int);
+   memcpy(&(bathy->lon0), hdr, sizeof(double));
+   memcpy(&(bathy->lat0), hdr+sizeof(double), sizeof(double));
+   memcpy(&(bathy->dlon), hdr+2*sizeof(double), sizeof(double));
+   memcpy(&(bathy->dlat), hdr+3*sizeof(double), sizeof(double));
+
+   if( bathy->len < OCL_BATHY_HEADER_SIZE ||
+       strncmp(bathy->base, OCL_BATHY_MAGIC, 8) ||
+       bathy->numLons<2 || bathy->numLats<2 || bathy->tileSize<1 ||
+       !(bathy->dlon>0.) || !(bathy->dlat>0.) ||
+       bathy->len != OCL_BATHY_HEADER_SIZE +
+          sizeOfOCLBathyTiles(bathy)*(long int)sizeof(float) ) {
+      fprintf(stderr, "%s is not a bathy grid or sidecar file (or is"
+         " truncated).\n", filename);
+      closeOCLBathy(bathy);
+      return UNSPECIFIED_PROBLEM;
+   }
+   bathy->z = (const float *)(bathy->base + OCL_BATHY_HEADER_SIZE);
+
+   /* a grid whose columns go all the way round wraps from its last column
+      back to its first (but not one that repeats its first column at the
+      end, as gridline-registered GMT grids do - that's already closed) */
+   bathy->wrapLon = fabs(bathy->numLons*bathy->dlon - 360.) <
+      0.001*bathy->dlon;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Close OCL bathy" - unmap the grid or sidecar */
+void closeOCLBathy(OCLBathyType *bathy) {
+   if( bathy->base!=NULL )
+      munmap((void *)bathy->base, (size_t)bathy->len);
+   memset(bathy, 0, sizeof(*bathy));
+}
+
+
+
+
+/* "Look up OCL bathy" - the grid's elevation at each of n positions lat[],
+   lon[], interpolated bilinearly from the four nodes around it, into z[]
+   (negative below sea level, as in the grid).  NaN for positions off the
+   grid or next to a node with no value. */
+void lookupOCLBathy(const OCLBathyType *bathy, long int n, const double *lat,
+   const double *lon, double *z) {
+
+   long int node[OCL_BATHY_BATCH][4], b, m, k, i, j;
+   double wx[OCL_BATHY_BATCH], wy[OCL_BATHY_BATCH], x, y;
+   int onGrid[OCL_BATHY_BATCH];
+   const float *g = bathy->z;
+
+   for(b=0; b<n; b+=OCL_BATHY_BATCH) {
+      m = (n-b<OCL_BATHY_BATCH) ? n-b : OCL_BATHY_BATCH;
+
+      /* where each position falls: the nodes to its southwest, southeast,
+         northwest and northeast, and how far it is across the cell */
+      for(k=0; k<m; k++) {
+         x = lon[b+k] - bathy->lon0;
+         x = (x - 360.*floor(x/360.)) / bathy->dlon;  /* (lon style) */
+         y = (lat[b+k] - bathy->lat0) / bathy->dlat;
+         onGrid[k] = y>=0. && y<=bathy->numLats-1 && x>=0. &&
+            (bathy->wrapLon ? x<bathy->numLons : x<=bathy->numLons-1);
+         if( !onGrid[k] ) continue;  /* (NaN positions too) */
+         i = (long int)x;
+         j = (long int)y;
+         if( !bathy->wrapLon && i==bathy->numLons-1 ) i--;  /* (on the */
+         if( j==bathy->numLats-1 ) j--;                     /*  edges) */
+         wx[k] = x-i;
+         wy[k] = y-j;
+         node[k][0] = oclBathyNode(bathy, i, j);
+         node[k][2] = oclBathyNode(bathy, i, j+1);
+         if( i+1==bathy->numLons ) i = -1;  /* (wrapping round) */
+         node[k][1] = oclBathyNode(bathy, i+1, j);
+         node[k][3] = oclBathyNode(bathy, i+1, j+1);
+      }
+
+      /* then fetch the nodes and blend them (a NaN node gives NaN) */
+      for(k=0; k<m; k++) {
+         if( !onGrid[k] ) z[b+k] = nan();
+         else z[b+k] =
+            (1.-wy[k])*((1.-wx[k])*g[node[k][0]] + wx[k]*g[node[k][1]]) +
+            wy[k]*((1.-wx[k])*g[node[k][2]] + wx[k]*g[node[k][3]]);
+      }
+   }
+}
+
+
+
+
+
+/* "Look up OCL bathy station" - a sidecar's elevation at station stn of its
+   file (negative below sea level), or NaN if it has none */
+double lookupOCLBathyStation(const OCLBathyType *bathy, long int stn) {
+   if( stn<0 || stn>=bathy->numStations ) return nan();
+   return bathy->stnZ[stn];
+}
+
+
+
+
+/* "Match OCL bathy sidecar" - SUCCESSFUL if sidecar was made for src: from
+   a file with the same key, and with the same number of stations.  Give
+   numStations if it's known (eg from src's station index), or -1 to have
+   src's stations counted here (from its current position, normally the
+   start).  Leaves src where it was. */
+int matchOCLBathySidecar(const OCLBathyType *sidecar, OCLSourceType *src,
+   long int numStations) {
+   OCLSourceKeyType key;
+   OCLIndexType idx;
+   long int pos=tellOCLSource(src);
+
+   if( getOCLSourceKey(src, &key) != SUCCESSFUL ||
+       !sameOCLSourceKey(&key, &(sidecar->key)) )
+      return UNSPECIFIED_PROBLEM;
+   if( numStations<0 ) {
+      if( buildOCLIndex(src, &idx) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+      numStations = idx.numStations;
+      freeOCLIndex(&idx);
+      if( seekOCLSource(src, pos) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+   }
+   return (numStations==sidecar->numStations) ?
+      SUCCESSFUL : UNSPECIFIED_PROBLEM;
+}
+
+
+
+
+/* "Write OCL bathy sidecar" - read the headers of all the stations in src
+   (from its current position, normally the start) and save a sidecar of
+   their bathy values: looked up by position in grid, or if grid is NULL,
+   read in lockstep from fp_dbBathy, a lat-lon-depth file made for src as
+   for oclfilt -d. */
+int writeOCLBathySidecar(char *filename, OCLSourceType *src,
+   const OCLBathyType *grid, FILE *fp_dbBathy) {
+
+   static OCLStationType stnData;  /* (static, so its buffer gets reused) */
+   double *lat=NULL, *lon=NULL, *z=NULL, *newLat, *newLon, *newZ;
+   double lf_dummy, latLimit;
+   long int i, allocated=0, ld_dummy;
+   OCLSourceKeyType key;
+   char magic[8];
+   FILE *fp;
+   int status=SUCCESSFUL;
+
+   if( getOCLSourceKey(src, &key) != SUCCESSFUL ) {
+      fprintf(stderr, "writeOCLBathySidecar: can only make a sidecar for a"
+         " file.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   for(i=0; !endOfOCLSource(src); i++) {
+      if( i==allocated ) {
+         allocated = (allocated==0) ? 4096 : 2*allocated;
+         /* (each kept as soon as it's got, so the end frees it either way) */
+         newLat = (double *)realloc(lat, allocated*sizeof(double));
+         if( newLat!=NULL ) lat = newLat;
+         newLon = (newLat==NULL) ? NULL :
+            (double *)realloc(lon, allocated*sizeof(double));
+         if( newLon!=NULL ) lon = newLon;
+         newZ = (newLon==NULL) ? NULL :
+            (double *)realloc(z, allocated*sizeof(double));
+         if( newZ!=NULL ) z = newZ;
+         if( newZ==NULL ) {
+            fprintf(stderr, "writeOCLBathySidecar: out of memory.\n");
+            status = UNSPECIFIED_PROBLEM;
+            break;
+         }
+      }
+      if( getOCLStationDataSrc( src, i, &stnData, 0, 0, 0, 0, NULL, 0, 0, 0,
+             0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, NULL ) != SUCCESSFUL ) {
+         fprintf(stderr, "writeOCLBathySidecar: failure reading stn#%ld.\n",
+            i);
+         status = UNSPECIFIED_PROBLEM;
+         break;
+      }
+      lat[i] = stnData.lat;
+      lon[i] = stnData.lon;
+      if( grid==NULL &&
+          fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
+             &ld_dummy, &z[i] ) != 4 ) {
+         fprintf(stderr, "writeOCLBathySidecar: bathy file has no line for"
+            " stn#%ld.\n", i);
+         status = UNSPECIFIED_PROBLEM;
+         break;
+      }
+   }
+
+   /* all of the positions at once, for lookupOCLBathy() to batch up */
+   if( status==SUCCESSFUL && grid!=NULL ) lookupOCLBathy(grid, i, lat, lon, z);
+   latLimit = (grid!=NULL) ? 90. : 72.;
+
+   if( status==SUCCESSFUL ) {
+      if( (fp=fopen(filename,"wb")) == NULL ) {
+         fprintf(stderr, "Unable to open file %s.\n", filename);
+         status = UNSPECIFIED_PROBLEM;
+      }
+      else {
+         memset(magic, 0, sizeof(magic));
+         strcpy(magic, OCL_BATHY_SIDECAR_MAGIC);
+         if( fwrite(magic, sizeof(magic), 1, fp) != 1 ||
+             fwrite(&(key.fileSize), sizeof(long int), 1, fp) != 1 ||
+             fwrite(&(key.checksum), sizeof(unsigned long int), 1, fp) != 1 ||
+             fwrite(&i, sizeof(long int), 1, fp) != 1 ||
+             fwrite(&latLimit, sizeof(double), 1, fp) != 1 ||
+             (long int)fwrite(z, sizeof(double), (size_t)i, fp) != i )
+            status = UNSPECIFIED_PROBLEM;
+         if( fclose(fp) != 0 ) status = UNSPECIFIED_PROBLEM;
+         if( status!=SUCCESSFUL )
+            fprintf(stderr, "writeOCLBathySidecar: unable to write %s.\n",
+               filename);
+      }
+   }
+
+   free(lat);
+   free(lon);
+   free(z);
+   return status;
+}
@@ -0,0 +1,641 @@
+/* oclCache.c -
+ *             Binary "cache" files of OCL data.  The WOD98 data never
+ *             changes, but its digit-count-prefixed ASCII gets decoded all
+ *             over again on every oclfilt run.  An OCL cache file holds the
+ *             same stations already decoded, made once with makeOCLCache, so
+ *             a later run just copies values out of memory.
+ *
+ *             A cache file is read as an OCLSourceType (it's memory-mapped),
+ *             so getOCLStationDataSrc() - and so oclfilt, with all its
+ *             filters, -s/-k, -j, etc - reads it just like the OCL file it
+ *             was made from, with the same output.  The filters are tried on
+ *             a station's header row before its profile columns are touched,
+ *             same as the OCL reader does before reading a profile.
+ *
+ *             Values are kept as they are in the OCL file, as an integer
+ *             mantissa and a precision digit, and rebuilt as the OCL reader
+ *             does (mantissa / 10^precision, see getVarlenFloatField()), so
+ *             they come out bit for bit the same - and a value takes 5 bytes
+ *             rather than a double's 8, keeping a cache smaller than the OCL
+ *             text it's made from.  A station's mantissas are ints, unless
+ *             one of them needs a long int (which the OCL format's 9 digits
+ *             never do).  The writer works each value's mantissa and
+ *             precision back out of the decoded double, taking the first
+ *             precision that rebuilds exactly the same double.
+ *
+ *             Cache file layout (native byte order and sizes, as written by
+ *             fwrite - so a cache is only good on the kind of machine that
+ *             made it, which the row size in the header checks for):
+ *               8 bytes         magic "OCLCCH3" + '\0'
+ *               long int        size in bytes of the (decompressed) OCL file
+ *               long int        number of stations
+ *               long int        sizeof(OCLCacheStationType)
+ *               numStations x   OCLCacheStationType - the header table, one
+ *                               fixed-width row per station (see ocl.h),
+ *                               its header fields narrowed to ints
+ *               secondary header entries and profile columns, for each
+ *               station in turn at its row's profileOffset from the end of
+ *               the header table, with ns = numberOfSecHdrEntries,
+ *               n = numProfileLevels, nv = numberOfVarCodes, and each
+ *               mantissa the row's mantissaSize (int or long int):
+ *                  mantissa      of secHdrValue[ns]
+ *                  mantissa      of depthValue[n]
+ *                  mantissa      of varValue[nv][n]
+ *                  short         secHdrCode[ns]
+ *                  unsigned char precision of each of those values, in the
+ *                                same order (OCL_CACHE_NAN for NaN)
+ *                  unsigned char errCodeForDepthValue[n]
+ *                  unsigned char errCodeForVarValue[nv][n]
+ *                  padding out to a multiple of 8 bytes
+ *
+ *             (Caches made by an older makeOCLCache - with magic "OCLCCH1",
+ *             before the secondary header entries moved out of the header
+ *             table, or "OCLCCH2", with values as doubles - need making
+ *             again.)
+ *
+ * other required sources/files: ocl.h, oclSource.c, oclIndex.c,
+ *                               getOCLStationData.c, oclArena.c
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             OCLSourceType src;
+ *             if( openOCLCache( &src, "ncts1311.cache" ) != SUCCESSFUL )
+ *                exit(1);
+ *             for( i=0; !endOfOCLSource(&src); i++ )
+ *                getOCLStationDataSrc( &src, i, &stnData, ... );
+ *             closeOCLSource( &src );
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "ocl.h"
+
+#define OCL_CACHE_MAGIC "OCLCCH3"   /* (plus its '\0' makes 8 bytes) */
+#define OCL_CACHE_MAGIC_LEN 6       /* (the part without the version) */
+#define OCL_CACHE_HDR_SIZE (8+3*(long int)sizeof(long int))
+#define OCL_CACHE_NAN 255           /* precision of a missing value */
+
+/* a station's secondary header entries and profile columns, in the cache */
+typedef struct OCLCacheProfile {
+   const char *mantissas;      /* of the sec hdr values, then the columns */
+   const short *secHdrCodes;
+   const unsigned char *precisions;  /* (same order as the mantissas) */
+   const unsigned char *errCodes;    /* of the columns */
+}  OCLCacheProfileType;
+
+/* writeOCLCache()'s buffers for encoding a station's values */
+typedef struct OCLCacheScratch {
+   long int *mantissas;
+   int *narrow;                /* (the mantissas as ints) */
+   unsigned char *precisions;
+   short *codes;               /* (the sec hdr codes) */
+   long int allocated;         /* values each buffer has room for */
+}  OCLCacheScratchType;
+
+
+
+
+/* "Size of OCL cache profile" - bytes in a station's secondary header
+   entries and profile columns, padding included */
+long int sizeOfOCLCacheProfile(const OCLCacheStationType *row) {
+   long int ns = row->numberOfSecHdrEntries;
+   long int n = row->numProfileLevels*(1+row->numberOfVarCodes);
+
+   return ( (ns+n)*(row->mantissaSize+1) + ns*(long int)sizeof(short) + n
+      + 7 ) / 8 * 8;
+}
+
+
+
+
+/* "Get OCL cache profile" - where the parts of a station's secondary header
+   entries and profile columns are */
+static void getOCLCacheProfile( OCLSourceType *src,
+   const OCLCacheStationType *row, OCLCacheProfileType *profile ) {
+   long int numValues = row->numberOfSecHdrEntries +
+      row->numProfileLevels*(1+row->numberOfVarCodes);
+
+   profile->mantissas = src->cacheProfiles + row->profileOffset;
+   profile->secHdrCodes = (const short *)(profile->mantissas +
+      numValues*row->mantissaSize);
+   profile->precisions = (const unsigned char *)(profile->secHdrCodes +
+      row->numberOfSecHdrEntries);
+   profile->errCodes = profile->precisions + numValues;
+}
+
+
+
+
+/* "Narrow OCL cache field" - put a header field in its row's int, with a
+   blank field's NaN (as a long int) as INT_MIN.  Returns 0 if it doesn't
+   fit. */
+static int narrowOCLCacheField( long int value, int *field ) {
+   if( value==(long int)nan() ) *field = INT_MIN;
+   else if( value>INT_MIN && value<=INT_MAX ) *field = (int)value;
+   else return 0;
+   return 1;
+}
+
+
+
+
+/* "Widen OCL cache field" - a header field back out of its row's int */
+static long int widenOCLCacheField( int field ) {
+   return (field==INT_MIN) ? (long int)nan() : (long int)field;
+}
+
+
+
+
+/* "Get OCL cache values" - rebuild values first to first+n-1 of a cache's
+   mantissas and precisions into values[], just as getVarlenFloatField()
+   makes them from the OCL file's digits */
+void getOCLCacheValues(const char *mantissas, long int mantissaSize,
+   const unsigned char *precisions, long int first, long int n,
+   double *values) {
+
+   long int i, m;
+
+   for(i=0; i<n; i++) {
+      if( precisions[first+i]==OCL_CACHE_NAN ) {
+         values[i] = nan();
+         continue;
+      }
+      if( mantissaSize==(long int)sizeof(int) )
+         m = ((const int *)mantissas)[first+i];
+      else m = ((const long int *)mantissas)[first+i];
+      values[i] = (double)m/oclPowersOfTen[precisions[first+i]];
+   }
+}
+
+
+
+
+/* "Encode OCL cache value" - the mantissa and precision that
+   getOCLCacheValues() rebuilds value from, bit for bit: the first precision
+   that does.  Returns UNSPECIFIED_PROBLEM if there's none (which a value
+   decoded from an OCL file always has). */
+static int encodeOCLCacheValue( double value, long int *mantissa,
+   unsigned char *precision ) {
+
+   double x;
+   int p;
+
+   if( value!=value ) {
+      *mantissa = 0;
+      *precision = OCL_CACHE_NAN;
+      return SUCCESSFUL;
+   }
+   for(p=0; p<10; p++) {
+      x = floor(value*oclPowersOfTen[p] + 0.5);
+      if( !(fabs(x) < (double)LONG_MAX) ) break;
+      *mantissa = (long int)x;
+      x = (double)*mantissa/oclPowersOfTen[p];
+      if( !memcmp(&x, &value, sizeof(double)) ) {
+         *precision = (unsigned char)p;
+         return SUCCESSFUL;
+      }
+   }
+   return UNSPECIFIED_PROBLEM;
+}
+
+
+
+
+/* "Write OCL cache profile" - encode and write a station's secondary header
+   entries and profile columns (as getOCLCacheProfile() finds them), setting
+   row->mantissaSize.  scratch's buffers are grown here as needed. */
+static int writeOCLCacheProfile( FILE *fp, long int stn,
+   OCLStationType *stnData, OCLCacheStationType *row,
+   OCLCacheScratchType *scratch ) {
+
+   static const char padding[8];
+   long int *newMantissas;
+   int *newNarrow;
+   unsigned char *newPrecisions;
+   short *newCodes;
+   const void *mantissas;
+   long int i, j, k, v, ns, n, numValues, padBytes;
+   int status=SUCCESSFUL;
+
+   ns = stnData->numberOfSecHdrEntries;
+   n = row->numProfileLevels;
+   numValues = ns + n*(1+stnData->numberOfVarCodes);
+
+   if( numValues > scratch->allocated ) {
+      if( (newMantissas=(long int *)realloc(scratch->mantissas,
+             (size_t)numValues*sizeof(long int))) != NULL )
+         scratch->mantissas = newMantissas;
+      if( (newNarrow=(int *)realloc(scratch->narrow,
+             (size_t)numValues*sizeof(int))) != NULL )
+         scratch->narrow = newNarrow;
+      if( (newPrecisions=(unsigned char *)realloc(scratch->precisions,
+             (size_t)numValues)) != NULL )
+         scratch->precisions = newPrecisions;
+      if( (newCodes=(short *)realloc(scratch->codes,
+             (size_t)numValues*sizeof(short))) != NULL )
+         scratch->codes = newCodes;
+      if( newMantissas==NULL || newNarrow==NULL || newPrecisions==NULL ||
+          newCodes==NULL ) {
+         fprintf(stderr, "writeOCLCache: out of memory.\n");
+         return UNSPECIFIED_PROBLEM;
+      }
+      scratch->allocated = numValues;
+   }
+
+   /* each value's mantissa & precision: sec hdr values, depths, then each
+      var's values */
+   for(i=0; i<ns && status==SUCCESSFUL; i++) {
+      status = encodeOCLCacheValue( stnData->secHdrValue[i],
+         &(scratch->mantissas[i]), &(scratch->precisions[i]) );
+      if( stnData->secHdrCode[i]<SHRT_MIN || stnData->secHdrCode[i]>SHRT_MAX )
+         status = UNSPECIFIED_PROBLEM;
+      scratch->codes[i] = (short)stnData->secHdrCode[i];
+   }
+   for(k=-1, v=ns; k<stnData->numberOfVarCodes && status==SUCCESSFUL; k++)
+      for(j=0; j<n && status==SUCCESSFUL; j++, v++)
+         status = encodeOCLCacheValue( (k<0) ? stnData->depthValue[j] :
+            stnData->varValue[k][j], &(scratch->mantissas[v]),
+            &(scratch->precisions[v]) );
+   if( status!=SUCCESSFUL ) {
+      fprintf(stderr, "writeOCLCache: stn#%ld has a value that can't be"
+         " kept exactly.\n", stn);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   /* ints, unless a mantissa doesn't fit in one */
+   row->mantissaSize = (long int)sizeof(int);
+   for(v=0; v<numValues; v++) {
+      if( scratch->mantissas[v]<INT_MIN || scratch->mantissas[v]>INT_MAX )
+         row->mantissaSize = (long int)sizeof(long int);
+      scratch->narrow[v] = (int)scratch->mantissas[v];
+   }
+   mantissas = (row->mantissaSize==(long int)sizeof(int)) ?
+      (const void *)scratch->narrow : (const void *)scratch->mantissas;
+
+   if( (long int)fwrite(mantissas, (size_t)row->mantissaSize,
+          (size_t)numValues, fp) != numValues ||
+       (long int)fwrite(scratch->codes, sizeof(short), (size_t)ns, fp) != ns ||
+       (long int)fwrite(scratch->precisions, 1, (size_t)numValues, fp)
+          != numValues ||
+       (long int)fwrite(stnData->errCodeForDepthValue, 1, (size_t)n, fp) != n )
+      return UNSPECIFIED_PROBLEM;
+   for(k=0; k<stnData->numberOfVarCodes; k++)
+      if( (long int)fwrite(stnData->errCodeForVarValue[k], 1, (size_t)n, fp)
+          != n )
+         return UNSPECIFIED_PROBLEM;
+   padBytes = sizeOfOCLCacheProfile(row) - numValues*(row->mantissaSize+1) -
+      ns*(long int)sizeof(short) - (numValues-ns);
+   if( (long int)fwrite(padding, 1, (size_t)padBytes, fp) != padBytes )
+      return UNSPECIFIED_PROBLEM;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Write OCL cache" - decode every station in src from its current position
+   to the end and write them to a cache file.  The station index is built
+   first so the header table's size is known, then the profile columns are
+   written after where the table goes, and the table itself last. */
+int writeOCLCache(char *filename, OCLSourceType *src) {
+   static OCLStationType stnData;  /* (static, so its arena gets reused) */
+   OCLCacheScratchType scratch;
+   OCLIndexType idx;
+   OCLCacheStationType *table, *row;
+   FILE *fp;
+   char magic[8];
+   long int i, k, n, rowSize=(long int)sizeof(OCLCacheStationType);
+   long int profileOffset=0;
+   int status=SUCCESSFUL, fits;
+
+   memset(&scratch, 0, sizeof(scratch));
+
+   if( buildOCLIndex(src, &idx) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+   if( idx.numStations>0 && seekOCLStation(src, &idx, 0) != SUCCESSFUL ) {
+      fprintf(stderr, "writeOCLCache: input must be a file that can be"
+         " seeked.\n");
+      freeOCLIndex(&idx);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   table = (OCLCacheStationType *)calloc((size_t)idx.numStations+1,
+      sizeof(OCLCacheStationType));
+   if( table==NULL ) {
+      fprintf(stderr, "writeOCLCache: out of memory.\n");
+      freeOCLIndex(&idx);
+      return UNSPECIFIED_PROBLEM;
+   }
+   if( (fp=fopen(filename,"wb")) == NULL ) {
+      fprintf(stderr, "Unable to open cache file %s for writing.\n", filename);
+      free(table);
+      freeOCLIndex(&idx);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   /* profile columns go after the header table, which is written last */
+   if( fseek(fp, OCL_CACHE_HDR_SIZE+idx.numStations*rowSize, SEEK_SET) != 0 )
+      status=UNSPECIFIED_PROBLEM;
+
+   for(i=0; i<idx.numStations && status==SUCCESSFUL; i++) {
+
+      /* whole station, no filters */
+      if( getOCLStationDataSrc( src, i, &stnData, 1, 0, 0, 0, NULL, 0, 0, 0,
+             0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, NULL ) != SUCCESSFUL ) {
+         fprintf(stderr, "writeOCLCache: failure reading stn#%ld.\n", i);
+         status=UNSPECIFIED_PROBLEM;
+         break;
+      }
+
+      row = &(table[i]);
+      row->oclStationNumber = stnData.oclStationNumber;
+      fits =
+         narrowOCLCacheField(stnData.bytesInStation, &(row->bytesInStation)) &&
+         narrowOCLCacheField(stnData.bytesLeftInStation,
+            &(row->bytesLeftInStation)) &&
+         narrowOCLCacheField(stnData.countryCode, &(row->countryCode)) &&
+         narrowOCLCacheField(stnData.cruiseNumber, &(row->cruiseNumber)) &&
+         narrowOCLCacheField(stnData.year, &(row->year)) &&
+         narrowOCLCacheField(stnData.month, &(row->month)) &&
+         narrowOCLCacheField(stnData.day, &(row->day)) &&
+         narrowOCLCacheField(stnData.numberOfLevels, &(row->numberOfLevels)) &&
+         narrowOCLCacheField(stnData.stationType, &(row->stationType)) &&
+         narrowOCLCacheField(stnData.numberOfVarCodes,
+            &(row->numberOfVarCodes)) &&
+         narrowOCLCacheField(stnData.bytesInCharPI, &(row->bytesInCharPI)) &&
+         narrowOCLCacheField(stnData.bytesInSecHdr, &(row->bytesInSecHdr)) &&
+         narrowOCLCacheField(stnData.numberOfSecHdrEntries,
+            &(row->numberOfSecHdrEntries)) &&
+         narrowOCLCacheField(stnData.bytesInBioHdr, &(row->bytesInBioHdr));
+      for(k=0; k<MAX_VARS; k++)
+         fits = fits &&
+            narrowOCLCacheField(stnData.varCode[k], &(row->varCode[k])) &&
+            narrowOCLCacheField(stnData.errCodeForVarCode[k],
+               &(row->errCodeForVarCode[k]));
+      if( !fits ) {
+         fprintf(stderr, "writeOCLCache: stn#%ld has a header field too big"
+            " for a cache row.\n", i);
+         status=UNSPECIFIED_PROBLEM;
+         break;
+      }
+      row->time = stnData.time;
+      row->lat = stnData.lat;
+      row->lon = stnData.lon;
+      row->bottomDepth = getOCLBottomDepth( &stnData );
+      row->bottomDepthSource = stnData.bottomDepthSource;
+
+      n = stnData.numberOfLevels;
+      if( n<0 ) n=0;
+      row->numProfileLevels = n;
+      row->profileOffset = profileOffset;
+
+      /* the secondary header entries, then the columns: depths, each var's
+         values, then all their error codes (single digits, a byte each, as
+         they're kept in stnData) */
+      status = writeOCLCacheProfile( fp, i, &stnData, row, &scratch );
+
+      profileOffset += sizeOfOCLCacheProfile(row);
+   }
+
+   /* and now the header and header table at the front */
+   memset(magic, 0, sizeof(magic));
+   strcpy(magic, OCL_CACHE_MAGIC);
+   if( status!=SUCCESSFUL || fseek(fp, 0L, SEEK_SET) != 0 ||
+       fwrite(magic, sizeof(magic), 1, fp) != 1 ||
+       fwrite(&(idx.key.fileSize), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(idx.numStations), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&rowSize, sizeof(long int), 1, fp) != 1 ||
+       (long int)fwrite(table, sizeof(OCLCacheStationType),
+          (size_t)idx.numStations, fp) != idx.numStations ) {
+      fprintf(stderr, "Error writing cache file %s.\n", filename);
+      status=UNSPECIFIED_PROBLEM;
+   }
+
+   if( fclose(fp) != 0 ) status=UNSPECIFIED_PROBLEM;
+   free(scratch.mantissas);
+   free(scratch.narrow);
+   free(scratch.precisions);
+   free(scratch.codes);
+   free(table);
+   freeOCLIndex(&idx);
+   return status;
+}
+
+
+
+
+/* "Is OCL cache file" - true if the file starts with the cache magic, of
+   this or an older version (which openOCLCache() then turns down, rather
+   than the file being taken for OCL data) */
+int isOCLCacheFile(char *filename) {
+   FILE *fp;
+   char magic[8];
+   int isCache;
+
+   if( (fp=fopen(filename,"rb")) == NULL ) return 0;
+   isCache = fread(magic, sizeof(magic), 1, fp) == 1 &&
+      !strncmp(magic, OCL_CACHE_MAGIC, OCL_CACHE_MAGIC_LEN);
+   fclose(fp);
+   return isCache;
+}
+
+
+
+
+/* "Open OCL cache" - map a cache file as a source for getOCLStationDataSrc(),
+   positioned at its first station.  closeOCLSource() unmaps it. */
+int openOCLCache(OCLSourceType *src, char *filename) {
+   long int hdr[3];   /* OCL file size, number of stations, row size */
+
+   if( mapOCLSource(src, filename) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+
+   if( src->len >= OCL_CACHE_HDR_SIZE ) memcpy(hdr, src->base+8, sizeof(hdr));
+   if( src->len < OCL_CACHE_HDR_SIZE ||
+       strncmp(src->base, OCL_CACHE_MAGIC, 8) ||
+       hdr[2] != (long int)sizeof(OCLCacheStationType) ) {
+      fprintf(stderr, "%s is not an OCL cache file made on this kind of"
+         " machine by this makeOCLCache.\n", filename);
+      closeOCLSource(src);
+      return UNSPECIFIED_PROBLEM;
+   }
+   if( hdr[1] < 0 || hdr[1] > (src->len-OCL_CACHE_HDR_SIZE)/hdr[2] ) {
+      fprintf(stderr, "OCL cache file %s is truncated.\n", filename);
+      closeOCLSource(src);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   src->cacheProfiles = src->base + OCL_CACHE_HDR_SIZE + hdr[1]*hdr[2];
+   return seekOCLSource(src, OCL_CACHE_HDR_SIZE);
+}
+
+
+
+
+/* "Get OCL cache row" - the next row in a cache source's header table,
+   stepping past it */
+static const OCLCacheStationType *getOCLCacheRow( OCLSourceType *src ) {
+   const OCLCacheStationType *row;
+
+   if( src->base+src->pos >= src->cacheProfiles ) {
+      fprintf(stderr,"%%oclfilt: unexpected EOF - empty or truncated input file?\n");
+      exit(1);
+   }
+   row = (const OCLCacheStationType *)(src->base + src->pos);
+   seekOCLSource(src, src->pos + (long int)sizeof(OCLCacheStationType));
+   return row;
+}
+
+
+
+
+/* "Copy OCL cache header" - a station's header fields and secondary header
+   entries out of its row (and the entries from ahead of its columns) */
+static int copyOCLCacheHeader( OCLSourceType *src, long int stn,
+   const OCLCacheStationType *row, OCLStationType *stnData ) {
+
+   OCLCacheProfileType profile;
+   long int j, ns;
+
+   stnData->bytesInStation = widenOCLCacheField(row->bytesInStation);
+   stnData->oclStationNumber = row->oclStationNumber;
+   stnData->bytesLeftInStation = widenOCLCacheField(row->bytesLeftInStation);
+   stnData->countryCode = widenOCLCacheField(row->countryCode);
+   stnData->cruiseNumber = widenOCLCacheField(row->cruiseNumber);
+   stnData->year = widenOCLCacheField(row->year);
+   stnData->month = widenOCLCacheField(row->month);
+   stnData->day = widenOCLCacheField(row->day);
+   stnData->time = row->time;
+   stnData->lat = row->lat;
+   stnData->lon = row->lon;
+   stnData->numberOfLevels = widenOCLCacheField(row->numberOfLevels);
+   stnData->stationType = widenOCLCacheField(row->stationType);
+   stnData->numberOfVarCodes = widenOCLCacheField(row->numberOfVarCodes);
+   for(j=0; j<MAX_VARS; j++) {
+      stnData->varCode[j] = widenOCLCacheField(row->varCode[j]);
+      stnData->errCodeForVarCode[j] =
+         widenOCLCacheField(row->errCodeForVarCode[j]);
+   }
+   stnData->bytesInCharPI = widenOCLCacheField(row->bytesInCharPI);
+   stnData->bytesInSecHdr = widenOCLCacheField(row->bytesInSecHdr);
+   stnData->numberOfSecHdrEntries = ns = row->numberOfSecHdrEntries;
+   if( allocOCLStationSecHdr( stnData, ns ) != SUCCESSFUL ) {
+      fprintf(stderr, "%% getOCLStationData: error: not enough memory for"
+         " stn %ld's %ld secondary header entries.\n", stn, ns);
+      return UNSPECIFIED_PROBLEM;
+   }
+   getOCLCacheProfile( src, row, &profile );
+   getOCLCacheValues( profile.mantissas, row->mantissaSize,
+      profile.precisions, 0, ns, stnData->secHdrValue );
+   for(j=0; j<ns; j++) stnData->secHdrCode[j] = profile.secHdrCodes[j];
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Get OCL cache station data" - getOCLStationDataSrc() for a cache source:
+   the same args (but with the filters gathered up by setOCLStationFilters()),
+   and the same station data and filtering results as reading the OCL file
+   the cache was made from, but copied out of the station's header row and
+   (only if the filters pass) its profile columns. */
+int getOCLCacheStationData( OCLSourceType *src, long int stn,
+   OCLStationType *stnData,
+   int wantProfileFlag, int skipFlag, long int stnToSkipTo,
+   int dbBathyFlag, FILE *fp_dbBathy, OCLStationFiltersType *filters ) {
+
+   const OCLCacheStationType *row;
+   OCLCacheProfileType profile;
+   long int k, n, ns;
+
+   row = getOCLCacheRow( src );
+
+   stnData->bytesInStation = widenOCLCacheField(row->bytesInStation);
+   stnData->oclStationNumber = row->oclStationNumber;
+
+   if( skipFlag && stn<stnToSkipTo ) {
+     /* if using bathy file, skip past line in there, too */
+     skipOCLBathyLine( stnData, dbBathyFlag, fp_dbBathy );
+     return SKIPPED;
+   }
+
+   if( copyOCLCacheHeader( src, stn, row, stnData ) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+
+   setOCLBottomDepth( stnData, stn, dbBathyFlag, fp_dbBathy );
+
+   if( checkOCLStationFilters( stnData, wantProfileFlag, filters ) ) {
+
+      stnData->bytesInBioHdr = widenOCLCacheField(row->bytesInBioHdr);
+
+      n = row->numProfileLevels;
+      if( allocOCLStationProfile( stnData, n, row->numberOfVarCodes )
+          != SUCCESSFUL ) {
+         fprintf(stderr, "%% getOCLStationData: error: not enough memory for"
+            " stn %ld's %ld levels.\n", stn, n);
+         return UNSPECIFIED_PROBLEM;
+      }
+      getOCLCacheProfile( src, row, &profile );
+      ns = row->numberOfSecHdrEntries;
+      getOCLCacheValues( profile.mantissas, row->mantissaSize,
+         profile.precisions, ns, n, stnData->depthValue );
+      memcpy(stnData->errCodeForDepthValue, profile.errCodes, (size_t)n);
+      for(k=0; k<row->numberOfVarCodes; k++) {
+         if( !(stnData->decodedVars & OCL_VAR_BIT(k)) ) continue;
+         getOCLCacheValues( profile.mantissas, row->mantissaSize,
+            profile.precisions, ns+(k+1)*n, n, stnData->varValue[k] );
+         memcpy(stnData->errCodeForVarValue[k], profile.errCodes+(k+1)*n,
+            (size_t)n);
+      }
+      setOCLLevelFlags( stnData );
+
+      checkOCLBottomDepth( stnData, dbBathyFlag );
+   }
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Get OCL cache station header" - getOCLStationHeader() for a cache
+   source, with cursor set up to copy the profile out of the station's
+   columns a level at a time */
+int getOCLCacheStationHeader( OCLSourceType *src, long int stn,
+   OCLStationType *stnData, OCLProfileCursorType *cursor ) {
+
+   const OCLCacheStationType *row = getOCLCacheRow( src );
+   OCLCacheProfileType profile;
+   long int n = row->numProfileLevels, ns = row->numberOfSecHdrEntries;
+
+   if( copyOCLCacheHeader( src, stn, row, stnData ) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+   setOCLBottomDepth( stnData, stn, 0, NULL );
+   stnData->bytesInBioHdr = widenOCLCacheField(row->bytesInBioHdr);
+
+   if( allocOCLStationProfile( stnData, n, row->numberOfVarCodes )
+       != SUCCESSFUL ) {
+      fprintf(stderr, "%% getOCLStationData: error: not enough memory for"
+         " stn %ld's %ld levels.\n", stn, n);
+      return UNSPECIFIED_PROBLEM;
+   }
+   stnData->anyLevelFlagged = 0;
+
+   cursor->src = src;
+   cursor->stnData = stnData;
+   cursor->level = 0;
+   cursor->numLevels = n;
+   /* (the mantissas and precisions from the depths on, so the columns
+      start at 0) */
+   getOCLCacheProfile( src, row, &profile );
+   cursor->cacheMantissas = profile.mantissas + ns*row->mantissaSize;
+   cursor->cacheMantissaSize = row->mantissaSize;
+   cursor->cachePrecisions = profile.precisions + ns;
+   cursor->cacheErrCodes = profile.errCodes;
+   return SUCCESSFUL;
+}
@@ -0,0 +1,429 @@
+/* oclExpr.c -
+ *             Filter expressions, for picking out stations by more than the
+ *             single ranges of oclfilt's -l, -y, -m and -v options (which all
+ *             have to pass at once).  An expression combines tests on the
+ *             station header with and, or, not and parentheses, eg
+ *                (region 115/125/35/45 or region 130/140/30/40)
+ *                   and month 12,2 and year 1980, and vars 1,2
+ *             for two regions' winter stations since 1980 with temperature
+ *             and salinity - one pass over the data, where the single-range
+ *             options would take one pass per region.
+ *
+ *             The tests are:
+ *                year <range>      year in range
+ *                month <range>     month in range (11,2 wraps the new year)
+ *                day <range>       day of year in range (335,59 wraps too)
+ *                region <w/e/s/n>  lat/lon in the box, as for -l
+ *                vars <list>       has all these variables, none of them
+ *                                  flagged as a whole, as for -v
+ *                country <list>    country code one of these
+ *                cruise <list>     cruise number one of these
+ *                levels <range>    number of profile levels in range
+ *             where a <range> is lo,hi inclusive, or just one value, or lo,
+ *             or ,hi to leave the other end open, and a <list> is values
+ *             separated by commas.  The operators are and (or &), or (or |)
+ *             and not (or !), with not binding tightest and or loosest.
+ *
+ *             compileOCLExpr() parses the expression just once, into a short
+ *             program of the tests and operators in postfix order, which
+ *             evalOCLExpr() then runs on each station's header with a small
+ *             stack of true/false values.  The compiled expression also
+ *             notes the last header field its tests need, so that
+ *             getOCLStationData() checks it (see OCL_FILTER_EXPR in ocl.h) as
+ *             soon as that field is read, and skips the rest of a station
+ *             that fails it like any of the other filters.
+ *
+ * other required sources/files: ocl.h, getOCLStationData.c
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             OCLExprType expr;
+ *             if( compileOCLExpr( "year 1980, and not region 0/20/0/20",
+ *                 &expr ) != SUCCESSFUL ) exit(1);
+ *             initOCLStation( &stnData );
+ *             stnData.filterExpr = &expr;
+ *             ...getOCLStationDataSrc() as usual, then stnData.exprPasses
+ *                says whether the station satisfied it...
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "ocl.h"
+
+#define OCL_EXPR_TOKEN_LEN 256
+
+/* compileOCLExpr()'s place in the expression text */
+typedef struct OCLExprParser {
+      char *text;              /* the whole expression, for error messages */
+      char *next;              /* where the next token starts */
+      OCLExprType *expr;       /* the program being compiled */
+      int depth;               /* not's and parentheses we're inside */
+}  OCLExprParserType;
+
+static int parseOCLExprOr( OCLExprParserType *parser );
+
+
+
+
+/* "OCL expr error" - complain about the expression from where the parser's
+   got to, and return the status for it */
+static int oclExprError( OCLExprParserType *parser, char *what ) {
+   while( isspace((unsigned char)*(parser->next)) ) parser->next++;
+   if( *(parser->next)=='\0' )
+      fprintf(stderr, "compileOCLExpr: %s at the end of filter expression "
+         "\"%s\".\n", what, parser->text);
+   else
+      fprintf(stderr, "compileOCLExpr: %s at \"%.40s\" in filter expression "
+         "\"%s\".\n", what, parser->next, parser->text);
+   return UNSPECIFIED_PROBLEM;
+}
+
+
+
+
+/* "Read OCL expr token" - copy the next token into token and return its
+   length (0 at the end of the expression), without moving the parser on
+   past it (see below).  A token is a parenthesis, one of the operator
+   characters &|!, or else a run of anything but space & parentheses.
+   Returns -1 for a run too long for token (which is left holding as much
+   as fits). */
+static long int readOCLExprToken( OCLExprParserType *parser, char *token ) {
+   char *p = parser->next;
+   long int n=0;
+
+   while( isspace((unsigned char)*p) ) p++;
+   parser->next = p;
+   if( strchr("()&|!", *p)!=NULL && *p!='\0' )
+      token[n++] = *p;
+   else
+      while( *p!='\0' && !isspace((unsigned char)*p) && strchr("()", *p)==NULL
+             && n<OCL_EXPR_TOKEN_LEN-1 )
+         token[n++] = *p++;
+   token[n] = '\0';
+   if( *p!='\0' && !isspace((unsigned char)*p) && strchr("()", *p)==NULL )
+      return -1;
+   return n;
+}
+
+
+
+
+/* "Take OCL expr token" - move the parser on past the token just read */
+static void takeOCLExprToken( OCLExprParserType *parser, char *token ) {
+   parser->next += strlen(token);
+}
+
+
+
+
+/* "Emit OCL expr op" - append an instruction to the program */
+static int emitOCLExprOp( OCLExprParserType *parser, OCLExprOpType *op ) {
+   if( parser->expr->numOps>=OCL_EXPR_MAX_OPS )
+      return oclExprError( parser, "too many tests and operators" );
+   parser->expr->op[parser->expr->numOps++] = *op;
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Parse OCL expr long" - the number from s up to end (which must all be
+   digits, with an optional sign) */
+static int parseOCLExprLong( char *s, char *end, long int *value ) {
+   char *stop;
+   if( s==end ) return UNSPECIFIED_PROBLEM;
+   *value = strtol(s, &stop, 10);
+   return (stop==end) ? SUCCESSFUL : UNSPECIFIED_PROBLEM;
+}
+
+
+
+
+/* "Parse OCL expr range" - lo,hi or a single value or lo, or ,hi into the
+   op's two values, with defLo & defHi for an open end */
+static int parseOCLExprRange( char *token, long int defLo, long int defHi,
+   OCLExprOpType *op ) {
+
+   char *comma = strchr(token, ',');
+   char *end = token+strlen(token);
+
+   op->numValues = 2;
+   if( comma==NULL ) {
+      if( parseOCLExprLong(token, end, &(op->value[0])) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+      op->value[1] = op->value[0];
+      return SUCCESSFUL;
+   }
+   if( comma==token && comma+1==end ) return UNSPECIFIED_PROBLEM;
+   if( comma==token ) op->value[0] = defLo;
+   else if( parseOCLExprLong(token, comma, &(op->value[0])) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+   if( comma+1==end ) op->value[1] = defHi;
+   else if( parseOCLExprLong(comma+1, end, &(op->value[1])) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Parse OCL expr list" - comma-separated values into the op's values */
+static int parseOCLExprList( char *token, OCLExprOpType *op ) {
+   char *comma;
+
+   op->numValues = 0;
+   do {
+      if( op->numValues>=OCL_EXPR_MAX_VALUES ) return UNSPECIFIED_PROBLEM;
+      comma = strchr(token, ',');
+      if( comma==NULL ) comma = token+strlen(token);
+      if( parseOCLExprLong(token, comma, &(op->value[op->numValues++]))
+          != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+      token = comma+1;
+   } while( *comma!='\0' );
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Parse OCL expr test" - one test and its value, eg year 1980,1990 */
+static int parseOCLExprTest( OCLExprParserType *parser ) {
+
+   static char *name[] = { "year", "month", "day", "region", "vars",
+      "country", "cruise", "levels", NULL };
+   static int code[] = { OCL_EXPR_YEAR, OCL_EXPR_MONTH, OCL_EXPR_DAY,
+      OCL_EXPR_REGION, OCL_EXPR_VARS, OCL_EXPR_COUNTRY, OCL_EXPR_CRUISE,
+      OCL_EXPR_LEVELS };
+   static int stage[] = { OCL_FILTER_YEAR, OCL_FILTER_MONTH, OCL_FILTER_MONTH,
+      OCL_FILTER_LATLON, OCL_FILTER_VAR_LIST, OCL_FILTER_YEAR,
+      OCL_FILTER_YEAR, OCL_FILTER_MIN_LEVELS };
+   char token[OCL_EXPR_TOKEN_LEN], extra;
+   OCLExprOpType op;
+   long int n;
+   int i, status;
+
+   if( (n=readOCLExprToken( parser, token ))==0 )
+      return oclExprError( parser, "expected a test" );
+   if( n<0 ) return oclExprError( parser, "test name too long" );
+   for(i=0; name[i]!=NULL && strcmp(name[i], token)!=0; i++);
+   if( name[i]==NULL )
+      return oclExprError( parser, "unknown test" );
+   takeOCLExprToken( parser, token );
+   op.code = code[i];
+   op.numValues = 0;
+
+   if( (n=readOCLExprToken( parser, token ))==0 ||
+       strchr("()&|!", token[0]) )
+      return oclExprError( parser, "expected a value for the test" );
+   if( n<0 ) return oclExprError( parser, "value too long for the test" );
+   switch( op.code ) {
+      case OCL_EXPR_YEAR:
+         status = parseOCLExprRange( token, 0, 9999, &op );
+         break;
+      case OCL_EXPR_MONTH:
+         status = parseOCLExprRange( token, 1, 12, &op );
+         break;
+      case OCL_EXPR_DAY:
+         status = parseOCLExprRange( token, 1, 366, &op );
+         break;
+      case OCL_EXPR_LEVELS:
+         status = parseOCLExprRange( token, 0, 999999999L, &op );
+         break;
+      case OCL_EXPR_REGION:
+         status = ( sscanf(token, "%lf/%lf/%lf/%lf%c", &op.region[0],
+            &op.region[1], &op.region[2], &op.region[3], &extra) == 4 ) ?
+            SUCCESSFUL : UNSPECIFIED_PROBLEM;
+         break;
+      default:
+         status = parseOCLExprList( token, &op );
+         break;
+   }
+   if( status!=SUCCESSFUL )
+      return oclExprError( parser, "bad value for the test" );
+   takeOCLExprToken( parser, token );
+
+   if( stage[i] > parser->expr->readyStage )
+      parser->expr->readyStage = stage[i];
+   return emitOCLExprOp( parser, &op );
+}
+
+
+
+
+/* "Parse OCL expr not" - not's, then a test or a parenthesized expression.
+   Each not or ( goes a level deeper, and more than OCL_EXPR_MAX_OPS levels
+   couldn't fit in the program anyway, so that's an error rather than a
+   recursion as deep as the expression is long. */
+static int parseOCLExprNot( OCLExprParserType *parser ) {
+   char token[OCL_EXPR_TOKEN_LEN];
+   OCLExprOpType op;
+   int status;
+
+   readOCLExprToken( parser, token );
+   if( (!strcmp(token, "not") || !strcmp(token, "!") || !strcmp(token, "("))
+       && parser->depth>=OCL_EXPR_MAX_OPS )
+      return oclExprError( parser, "too many nested not's and parentheses" );
+   if( !strcmp(token, "not") || !strcmp(token, "!") ) {
+      takeOCLExprToken( parser, token );
+      parser->depth++;
+      status = parseOCLExprNot( parser );
+      parser->depth--;
+      if( status != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+      op.code = OCL_EXPR_NOT;
+      op.numValues = 0;
+      return emitOCLExprOp( parser, &op );
+   }
+   if( !strcmp(token, "(") ) {
+      takeOCLExprToken( parser, token );
+      parser->depth++;
+      status = parseOCLExprOr( parser );
+      parser->depth--;
+      if( status != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+      readOCLExprToken( parser, token );
+      if( strcmp(token, ")") )
+         return oclExprError( parser, "expected a )" );
+      takeOCLExprToken( parser, token );
+      return SUCCESSFUL;
+   }
+   return parseOCLExprTest( parser );
+}
+
+
+
+
+/* "Parse OCL expr and" - not-terms joined by and's */
+static int parseOCLExprAnd( OCLExprParserType *parser ) {
+   char token[OCL_EXPR_TOKEN_LEN];
+   OCLExprOpType op;
+
+   if( parseOCLExprNot( parser ) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+   op.code = OCL_EXPR_AND;
+   op.numValues = 0;
+   while( readOCLExprToken( parser, token ),
+          !strcmp(token, "and") || !strcmp(token, "&") ) {
+      takeOCLExprToken( parser, token );
+      if( parseOCLExprNot( parser ) != SUCCESSFUL ||
+          emitOCLExprOp( parser, &op ) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Parse OCL expr or" - and-terms joined by or's */
+static int parseOCLExprOr( OCLExprParserType *parser ) {
+   char token[OCL_EXPR_TOKEN_LEN];
+   OCLExprOpType op;
+
+   if( parseOCLExprAnd( parser ) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+   op.code = OCL_EXPR_OR;
+   op.numValues = 0;
+   while( readOCLExprToken( parser, token ),
+          !strcmp(token, "or") || !strcmp(token, "|") ) {
+      takeOCLExprToken( parser, token );
+      if( parseOCLExprAnd( parser ) != SUCCESSFUL ||
+          emitOCLExprOp( parser, &op ) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Compile OCL expr" - parse the filter expression in text into expr's
+   postfix program.  On a syntax error, says what and where on stderr and
+   returns UNSPECIFIED_PROBLEM. */
+int compileOCLExpr( char *text, OCLExprType *expr ) {
+   OCLExprParserType parser;
+   char token[OCL_EXPR_TOKEN_LEN];
+
+   parser.text = text;
+   parser.next = text;
+   parser.expr = expr;
+   parser.depth = 0;
+   expr->numOps = 0;
+   expr->readyStage = OCL_FILTER_YEAR;
+
+   if( parseOCLExprOr( &parser ) != SUCCESSFUL ) return UNSPECIFIED_PROBLEM;
+   if( readOCLExprToken( &parser, token ) != 0 )
+      return oclExprError( &parser, "expected and/or" );
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "In OCL expr list" - true if value is one of the op's values */
+static int inOCLExprList( OCLExprOpType *op, long int value ) {
+   long int i;
+   for(i=0; i<op->numValues; i++)
+      if( op->value[i]==value ) return 1;
+   return 0;
+}
+
+
+
+
+/* "Eval OCL expr" - run the compiled expression on the station's header
+   and return true if the station satisfies it */
+int evalOCLExpr( OCLExprType *expr, OCLStationType *stnData ) {
+   char stack[OCL_EXPR_MAX_OPS];
+   long int i, sp=0;
+   OCLExprOpType *op;
+
+   for(i=0; i<expr->numOps; i++) {
+      op = &(expr->op[i]);
+      switch( op->code ) {
+         case OCL_EXPR_AND:
+            sp--;
+            stack[sp-1] = stack[sp-1] && stack[sp];
+            break;
+         case OCL_EXPR_OR:
+            sp--;
+            stack[sp-1] = stack[sp-1] || stack[sp];
+            break;
+         case OCL_EXPR_NOT:
+            stack[sp-1] = !stack[sp-1];
+            break;
+         case OCL_EXPR_YEAR:
+            stack[sp++] = stnData->year>=op->value[0] &&
+               stnData->year<=op->value[1];
+            break;
+         case OCL_EXPR_MONTH:
+            stack[sp++] = inOCLCyclicRange( stnData->month, op->value );
+            break;
+         case OCL_EXPR_DAY:
+            stack[sp++] = inOCLCyclicRange( oclDayOfYear(stnData->year,
+               stnData->month, stnData->day), op->value );
+            break;
+         case OCL_EXPR_REGION:
+            stack[sp++] = !( stnData->lon < op->region[0] ||
+                             stnData->lon > op->region[1] ||
+                             stnData->lat < op->region[2] ||
+                             stnData->lat > op->region[3] );
+            break;
+         case OCL_EXPR_VARS:
+            stack[sp++] = checkVarsInclAndNoErrors( op->value,
+               stnData->varCode, stnData->errCodeForVarCode, op->numValues,
+               stnData->numberOfVarCodes );
+            break;
+         case OCL_EXPR_COUNTRY:
+            stack[sp++] = inOCLExprList( op, stnData->countryCode );
+            break;
+         case OCL_EXPR_CRUISE:
+            stack[sp++] = inOCLExprList( op, stnData->cruiseNumber );
+            break;
+         case OCL_EXPR_LEVELS:
+            stack[sp++] = stnData->numberOfLevels>=op->value[0] &&
+               stnData->numberOfLevels<=op->value[1];
+            break;
+      }
+   }
+   return (sp>0) ? stack[sp-1] : 1;
+}
@@ -0,0 +1,158 @@
+/* oclFormat.c -
+ *             Fast formatting of the numbers in oclfilt's (and sspcomp's)
+ *             output lines.  Writing out a profile is mostly a matter of
+ *             turning doubles into "%.4f", "%.3f" etc text, and printf's
+ *             general machinery does that much more slowly than the
+ *             decoder reads them in.  So a whole output line is put
+ *             together in a char buffer with the functions here, and then
+ *             written out with one fputs().
+ *
+ *             formatOCLFixed() gives exactly the same characters as
+ *             sprintf()'s "%*.*f": the value is scaled up by 10^decimals
+ *             (exactly, for the few decimals used here) and rounded to an
+ *             integer whose digits are written out with the decimal point
+ *             put back in.  The one place the two could differ is a value
+ *             whose scaled-up fraction is within rounding error of a half,
+ *             where the way printf rounds the exact binary value decides
+ *             it - those values, and NaNs, infinities and ones too big for
+ *             an unsigned long once scaled, are just handed to sprintf().
+ *
+ *             setOCLOutputBuffer() gives an output stream a big stdio
+ *             buffer (OCL_OUTPUT_BUFSIZE), so the lines go out in a few
+ *             large writes - unless it's a terminal, which is left as is.
+ *
+ * other required sources/files: ocl.h
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             char line[OCL_MAX_OUTPUT_LINE], *p=line;
+ *             setOCLOutputBuffer( fp_out );
+ *             ...
+ *             p = formatOCLFixed( p, "", lat, 0, 4 );     (ie "%.4f")
+ *             p = formatOCLLong( p, "  ", year, 4 );     (ie "  %4ld")
+ *             p = formatOCLString( p, "\n", 0 );
+ *             fputs( line, fp_out );
+ */
+
+#define _POSIX_C_SOURCE 200112L  /* for isatty() with -ansi */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "ocl.h"
+
+/* scaled-up values from here on are left to sprintf (it's under the
+   smallest ULONG_MAX ANSI allows, and small enough that the scaling is
+   good to much better than OCL_FORMAT_TIE_WINDOW) */
+#define OCL_FORMAT_MAX_SCALED 4.0e9
+
+/* scaled-up fractions this close to a half are left to sprintf too */
+#define OCL_FORMAT_TIE_WINDOW 1.0e-6
+
+#define OCL_FORMAT_MAX_DECIMALS 6
+
+static const double oclFormatScale[OCL_FORMAT_MAX_DECIMALS+1] =
+   { 1., 10., 100., 1000., 10000., 100000., 1000000. };
+
+
+
+
+/* "Format OCL fixed" - write prefix and then x at p, as sprintf(p,
+   "%s%*.*f",prefix,width,decimals,x) would (so x is right-justified in width
+   characters, or not padded for 0), and return the new end of the string */
+char *formatOCLFixed( char *p, const char *prefix, double x, int width,
+   int decimals ) {
+
+   char digits[32];
+   double scaled, whole, frac;
+   unsigned long int n;
+   int k=0, len, neg;
+
+   while( *prefix!='\0' ) *p++ = *prefix++;
+   if( decimals<0 || decimals>OCL_FORMAT_MAX_DECIMALS ||
+       !(x > -OCL_FORMAT_MAX_SCALED && x < OCL_FORMAT_MAX_SCALED) )
+      return p + sprintf( p, "%*.*f", width, decimals, x );
+
+   /* (printf gives -0 a minus sign, and anything that rounds to it) */
+   neg = x<0. || ( x==0. && 1./x<0. );
+   scaled = (neg ? -x : x) * oclFormatScale[decimals];
+   whole = floor(scaled);
+   frac = scaled - whole;
+   if( scaled >= OCL_FORMAT_MAX_SCALED ||
+       ( frac > 0.5-OCL_FORMAT_TIE_WINDOW &&
+         frac < 0.5+OCL_FORMAT_TIE_WINDOW ) )
+      return p + sprintf( p, "%*.*f", width, decimals, x );
+   n = (unsigned long int)whole + ( frac>0.5 );
+
+   /* the digits, least significant first - at least one before the point */
+   do {
+      digits[k++] = (char)('0' + n%10);
+      n /= 10;
+   } while( n>0 || k<=decimals );
+
+   for(len = k + (decimals>0) + neg; len<width; len++) *p++ = ' ';
+   if( neg ) *p++ = '-';
+   while( k>0 ) {
+      *p++ = digits[--k];
+      if( k==decimals && k>0 ) *p++ = '.';
+   }
+   *p = '\0';
+   return p;
+}
+
+
+
+
+/* "Format OCL long" - write prefix and then v at p, as sprintf(p,
+   "%s%*ld",prefix,width,v) would, and return the new end of the string */
+char *formatOCLLong( char *p, const char *prefix, long int v, int width ) {
+
+   char digits[32];
+   unsigned long int n;
+   int k=0, len;
+
+   while( *prefix!='\0' ) *p++ = *prefix++;
+   if( v<0 ) return p + sprintf( p, "%*ld", width, v );
+
+   n = (unsigned long int)v;
+   do {
+      digits[k++] = (char)('0' + n%10);
+      n /= 10;
+   } while( n>0 );
+
+   for(len=k; len<width; len++) *p++ = ' ';
+   while( k>0 ) *p++ = digits[--k];
+   *p = '\0';
+   return p;
+}
+
+
+
+
+/* "Format OCL string" - write s at p padded out to width characters as
+   sprintf(p,"%*s",width,s) would (so a negative width left-justifies it),
+   and return the new end of the string at p */
+char *formatOCLString( char *p, const char *s, int width ) {
+
+   int len = (int)strlen(s), pad;
+
+   pad = (width<0 ? -width : width) - len;
+   if( width>0 ) for(; pad>0; pad--) *p++ = ' ';
+   memcpy( p, s, (size_t)len );
+   p += len;
+   for(; pad>0; pad--) *p++ = ' ';
+   *p = '\0';
+   return p;
+}
+
+
+
+
+/* "Set OCL output buffer" - give the output stream fp a big buffer, before
+   anything's been written to it, unless it's a terminal */
+void setOCLOutputBuffer( FILE *fp ) {
+   if( !isatty(fileno(fp)) )
+      setvbuf( fp, NULL, _IOFBF, OCL_OUTPUT_BUFSIZE );
+}
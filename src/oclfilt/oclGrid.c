@@ -0,0 +1,513 @@
+/* oclGrid.c -
+ *             Spatial index ("grid") of station positions over any number of
+ *             OCL files - eg every file on a WOD98 CD.  The stations are
+ *             binned by position into 1x1 degree cells, and each one is
+ *             listed with its file, station number, byte offset and lat/lon.
+ *             With that, a -l region query only has to decode the stations
+ *             that are actually in the region (found by looking in just the
+ *             cells that overlap it), rather than the header of every station
+ *             in every file, and doesn't need to know beforehand which WMO
+ *             squares or files the region takes in.
+ *
+ *             Each entry also has the station's year, month and day of year,
+ *             and each cell a bitmap of the months of its stations.  A query
+ *             with -y, -m and/or -D turns those ranges into bitmaps over the
+ *             possible years, months and days (wrapping around the end of
+ *             the year if need be), skips the cells with none of the months
+ *             wanted, and drops the entries whose dates aren't wanted, all
+ *             before any station bytes are read.  So a one-month climatology
+ *             over decades of data only decodes that month's stations.
+ *
+ *             Grids are made once with makeOCLGrid (a single pass over the
+ *             files) and saved to a file, which oclfilt -G reads.  Like the
+ *             station index, the grid records the size of each file, so a
+ *             file that's changed since gets caught rather than misread.
+ *             The file names are kept as given to makeOCLGrid, so give it
+ *             full paths if the grid will be used from another directory.
+ *
+ *             Lats of -90 to 90 and lons of -180 to 360 (so either lon style
+ *             in the data is fine) are binned; any station outside of that
+ *             (eg NaN for a missing position) goes in one extra "off grid"
+ *             cell that every query checks, so a query finds exactly the
+ *             stations that the -l filter would let thru.
+ *
+ *             Grid file layout (native byte order, as written by fwrite):
+ *               8 bytes         magic "OCLGRD2" + '\0'
+ *               long int        number of files
+ *               long int        number of stations (entries)
+ *               numFiles x      OCLGridFileType (name, size, stations, bytes)
+ *               OCL_GRID_CELLS+1 long ints - cellStart[], where cell c's
+ *                               entries are entry[cellStart[c]] on up to
+ *                               entry[cellStart[c+1]-1]
+ *               OCL_GRID_CELLS unsigned long ints - cellMonths[], each
+ *                               cell's month bitmap
+ *               numEntries x    OCLGridEntryType (file, stn, offset, lat, lon,
+ *                               year, dayOfYear, month)
+ *                               by cell, and in file & station order within
+ *                               each cell
+ *
+ * other required sources/files: ocl.h, oclSource.c, oclCache.c, oclIndex.c,
+ *                               getOCLStationData.c
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             OCLGridType grid;
+ *             OCLGridEntryType *hit;
+ *             double region[4] = { -130, -120, 30, 40 };
+ *             readOCLGrid( "wod98.grid", &grid );
+ *             long int months[2] = { 11, 2 };
+ *             n = queryOCLGrid( &grid, 1, region, 0, NULL, 1, months, 0, NULL,
+ *                &hit );
+ *             ...for each of the n hits, open grid.file[hit[i].file].name,
+ *                seekOCLSource() to hit[i].offset and read station
+ *                hit[i].stn with getOCLStationDataSrc()...
+ *             free( hit );
+ *             freeOCLGrid( &grid );
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "ocl.h"
+
+#define OCL_GRID_MAGIC "OCLGRD2"   /* (plus its '\0' makes 8 bytes) */
+#define OCL_GRID_NLAT 180          /* 1 degree rows, lat -90 to 90 */
+#define OCL_GRID_NLON 540          /* 1 degree columns, lon -180 to 360 */
+#define OCL_GRID_OFF (OCL_GRID_NLAT*OCL_GRID_NLON)   /* the off-grid cell */
+#define OCL_GRID_CELLS (OCL_GRID_OFF+1)
+#define OCL_GRID_YEARS 10000       /* query bitmaps' sizes, covering all the */
+#define OCL_GRID_MONTHS 100        /* values of the 4 & 2 digit year & month */
+#define OCL_GRID_DAYS 367          /* fields, and day of year 0-366 */
+
+#define OCL_GRID_MONTH_BIT(m) (1UL << ((m)<31 ? (m) : 31))
+#define OCL_GRID_BIT(bits,i) ((bits)[(i)>>3] & (1 << ((i)&7)))
+
+/* Bitmaps of the dates a query wants (a set bit means that year, month or
+   day of year passes the filters), built by setOCLGridTimeMask() */
+typedef struct OCLGridTimeMask {
+   unsigned char year[(OCL_GRID_YEARS+7)/8];
+   unsigned char month[(OCL_GRID_MONTHS+7)/8];
+   unsigned char dayOfYear[(OCL_GRID_DAYS+7)/8];
+   unsigned long int cellMonths;  /* in the same form as grid->cellMonths */
+   int yearRangeFlag, monthRangeFlag;  /* (the ranges themselves, for any */
+   long int yearRange[2], monthRange[2];  /* value outside the bitmaps) */
+}  OCLGridTimeMaskType;
+
+
+
+
+/* "OCL grid row" and "OCL grid column" - which row/column a lat/lon in the
+   grid's range is binned in (the north and east edges go in the last one) */
+static long int oclGridRow(double lat) {
+   return (lat>=90.) ? OCL_GRID_NLAT-1 : (long int)floor(lat+90.);
+}
+
+static long int oclGridCol(double lon) {
+   return (lon>=360.) ? OCL_GRID_NLON-1 : (long int)floor(lon+180.);
+}
+
+
+
+
+/* "OCL grid cell" - the cell a station at lat/lon goes in */
+static long int oclGridCell(double lat, double lon) {
+   if( lat>=-90. && lat<=90. && lon>=-180. && lon<=360. )
+      return oclGridRow(lat)*OCL_GRID_NLON + oclGridCol(lon);
+   else return OCL_GRID_OFF;   /* (NaN's end up here too) */
+}
+
+
+
+
+/* "Init OCL grid" - start an empty grid to add files to */
+void initOCLGrid(OCLGridType *grid) {
+   grid->numFiles = 0;
+   grid->file = NULL;
+   grid->numEntries = 0;
+   grid->entry = NULL;
+   grid->cellStart = NULL;
+   grid->cellMonths = NULL;
+   grid->allocatedFiles = 0;
+   grid->allocatedEntries = 0;
+}
+
+
+
+
+/* "Add OCL grid file" - read the headers of all the stations in an OCL file
+   (plain, gzipped, or an OCL cache file) and add their positions and dates
+   to the grid.  The entries are left in file order until finishOCLGrid(). */
+int addOCLGridFile(OCLGridType *grid, char *filename) {
+   static OCLStationType stnData;  /* (static, so its buffer gets reused) */
+   OCLSourceType src;
+   OCLGridFileType *gf;
+   OCLGridEntryType *entry;
+   long int i, offset;
+
+   if( isGzipFile(filename) ) {
+      if( loadOCLGzSource(&src, filename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else if( isOCLCacheFile(filename) ) {
+      if( openOCLCache(&src, filename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else if( mapOCLSource(&src, filename) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+
+   if( grid->numFiles==grid->allocatedFiles ) {
+      grid->allocatedFiles = (grid->numFiles==0) ? 64 : 2*grid->numFiles;
+      gf = (OCLGridFileType *)realloc(grid->file,
+         grid->allocatedFiles*sizeof(OCLGridFileType));
+      if( gf==NULL ) {
+         fprintf(stderr, "addOCLGridFile: out of memory.\n");
+         closeOCLSource(&src);
+         return UNSPECIFIED_PROBLEM;
+      }
+      grid->file = gf;
+   }
+   gf = &(grid->file[grid->numFiles]);
+   memset(gf, 0, sizeof(*gf));
+   sprintf(gf->name, "%.255s", filename);
+   gf->fileSize = sizeOfOCLSource(&src);
+
+   /* just the headers (no filters), to get each station's lat/lon & date */
+   for(i=0; !endOfOCLSource(&src); i++) {
+      if( grid->numEntries==grid->allocatedEntries ) {
+         grid->allocatedEntries = (grid->numEntries==0) ? 4096 :
+            2*grid->numEntries;
+         entry = (OCLGridEntryType *)realloc(grid->entry,
+            grid->allocatedEntries*sizeof(OCLGridEntryType));
+         if( entry==NULL ) {
+            fprintf(stderr, "addOCLGridFile: out of memory.\n");
+            closeOCLSource(&src);
+            return UNSPECIFIED_PROBLEM;
+         }
+         grid->entry = entry;
+      }
+
+      offset = tellOCLSource(&src);
+      if( getOCLStationDataSrc( &src, i, &stnData, 0, 0, 0, 0, NULL, 0, 0, 0,
+             0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, NULL ) != SUCCESSFUL ) {
+         fprintf(stderr, "addOCLGridFile: failure reading stn#%ld of %s.\n",
+            i, filename);
+         closeOCLSource(&src);
+         return UNSPECIFIED_PROBLEM;
+      }
+
+      entry = &(grid->entry[grid->numEntries++]);
+      entry->file = grid->numFiles;
+      entry->stn = i;
+      entry->offset = offset;
+      entry->lat = stnData.lat;
+      entry->lon = stnData.lon;
+      entry->year = (short int)stnData.year;
+      entry->dayOfYear = (short int)oclDayOfYear(stnData.year, stnData.month,
+         stnData.day);
+      entry->month = (unsigned char)stnData.month;
+      gf->totalBytes += stnData.bytesInStation;
+   }
+   gf->numStations = i;
+   grid->numFiles++;
+
+   closeOCLSource(&src);
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Finish OCL grid" - bin the entries added so far into their cells (a
+   counting sort, so within each cell they stay in file & station order),
+   and make each cell's month bitmap */
+int finishOCLGrid(OCLGridType *grid) {
+   OCLGridEntryType *sorted;
+   long int *next, c, i;
+
+   free(grid->cellStart);
+   free(grid->cellMonths);
+   grid->cellStart = (long int *)calloc(OCL_GRID_CELLS+1, sizeof(long int));
+   grid->cellMonths = (unsigned long int *)calloc(OCL_GRID_CELLS,
+      sizeof(unsigned long int));
+   next = (long int *)malloc(OCL_GRID_CELLS*sizeof(long int));
+   sorted = (OCLGridEntryType *)malloc(
+      (grid->numEntries+1)*sizeof(OCLGridEntryType));
+   if( grid->cellStart==NULL || grid->cellMonths==NULL || next==NULL ||
+       sorted==NULL ) {
+      fprintf(stderr, "finishOCLGrid: out of memory.\n");
+      free(next);
+      free(sorted);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   for(i=0; i<grid->numEntries; i++)
+      grid->cellStart[oclGridCell(grid->entry[i].lat, grid->entry[i].lon)+1]++;
+   for(c=0; c<OCL_GRID_CELLS; c++) {
+      grid->cellStart[c+1] += grid->cellStart[c];
+      next[c] = grid->cellStart[c];
+   }
+   for(i=0; i<grid->numEntries; i++) {
+      c = oclGridCell(grid->entry[i].lat, grid->entry[i].lon);
+      sorted[next[c]++] = grid->entry[i];
+      grid->cellMonths[c] |= OCL_GRID_MONTH_BIT(grid->entry[i].month);
+   }
+
+   free(grid->entry);
+   grid->entry = sorted;
+   grid->allocatedEntries = grid->numEntries+1;
+   free(next);
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Write OCL grid" - save a finished grid to a file */
+int writeOCLGrid(char *filename, OCLGridType *grid) {
+   FILE *fp;
+   char magic[8];
+   int status=SUCCESSFUL;
+
+   if( (fp=fopen(filename,"wb")) == NULL ) {
+      fprintf(stderr, "Unable to open grid file %s for writing.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   memset(magic, 0, sizeof(magic));
+   strcpy(magic, OCL_GRID_MAGIC);
+   if( fwrite(magic, sizeof(magic), 1, fp) != 1 ||
+       fwrite(&(grid->numFiles), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(grid->numEntries), sizeof(long int), 1, fp) != 1 ||
+       (long int)fwrite(grid->file, sizeof(OCLGridFileType),
+          (size_t)grid->numFiles, fp) != grid->numFiles ||
+       fwrite(grid->cellStart, sizeof(long int), OCL_GRID_CELLS+1, fp) !=
+          OCL_GRID_CELLS+1 ||
+       fwrite(grid->cellMonths, sizeof(unsigned long int), OCL_GRID_CELLS,
+          fp) != OCL_GRID_CELLS ||
+       (long int)fwrite(grid->entry, sizeof(OCLGridEntryType),
+          (size_t)grid->numEntries, fp) != grid->numEntries ) {
+      fprintf(stderr, "Error writing grid file %s.\n", filename);
+      status=UNSPECIFIED_PROBLEM;
+   }
+
+   if( fclose(fp) != 0 ) status=UNSPECIFIED_PROBLEM;
+   return status;
+}
+
+
+
+
+/* "Read OCL grid" - load a grid from a file made by writeOCLGrid() */
+int readOCLGrid(char *filename, OCLGridType *grid) {
+   FILE *fp;
+   char magic[8];
+
+   initOCLGrid(grid);
+
+   if( (fp=fopen(filename,"rb")) == NULL ) {
+      fprintf(stderr, "Unable to open grid file %s.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   if( fread(magic, sizeof(magic), 1, fp) != 1 ||
+       strncmp(magic, OCL_GRID_MAGIC, sizeof(magic)) ||
+       fread(&(grid->numFiles), sizeof(long int), 1, fp) != 1 ||
+       fread(&(grid->numEntries), sizeof(long int), 1, fp) != 1 ||
+       grid->numFiles < 0 || grid->numEntries < 0 ) {
+      fprintf(stderr, "%s is not an OCL grid file.\n", filename);
+      fclose(fp);
+      initOCLGrid(grid);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   grid->file = (OCLGridFileType *)malloc(
+      (grid->numFiles+1)*sizeof(OCLGridFileType));
+   grid->cellStart = (long int *)malloc((OCL_GRID_CELLS+1)*sizeof(long int));
+   grid->cellMonths = (unsigned long int *)malloc(
+      OCL_GRID_CELLS*sizeof(unsigned long int));
+   grid->entry = (OCLGridEntryType *)malloc(
+      (grid->numEntries+1)*sizeof(OCLGridEntryType));
+   if( grid->file==NULL || grid->cellStart==NULL || grid->cellMonths==NULL ||
+       grid->entry==NULL ||
+       (long int)fread(grid->file, sizeof(OCLGridFileType),
+          (size_t)grid->numFiles, fp) != grid->numFiles ||
+       fread(grid->cellStart, sizeof(long int), OCL_GRID_CELLS+1, fp) !=
+          OCL_GRID_CELLS+1 ||
+       fread(grid->cellMonths, sizeof(unsigned long int), OCL_GRID_CELLS,
+          fp) != OCL_GRID_CELLS ||
+       (long int)fread(grid->entry, sizeof(OCLGridEntryType),
+          (size_t)grid->numEntries, fp) != grid->numEntries ) {
+      fprintf(stderr, "OCL grid file %s is truncated.\n", filename);
+      fclose(fp);
+      freeOCLGrid(grid);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   fclose(fp);
+   grid->allocatedFiles = grid->numFiles+1;
+   grid->allocatedEntries = grid->numEntries+1;
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Free OCL grid" */
+void freeOCLGrid(OCLGridType *grid) {
+   free(grid->file);
+   free(grid->entry);
+   free(grid->cellStart);
+   free(grid->cellMonths);
+   initOCLGrid(grid);
+}
+
+
+
+
+/* (qsort comparison - file & station order) */
+static int compareOCLGridEntries(const void *a, const void *b) {
+   const OCLGridEntryType *ea=(const OCLGridEntryType *)a,
+      *eb=(const OCLGridEntryType *)b;
+
+   if( ea->file!=eb->file ) return (ea->file < eb->file) ? -1 : 1;
+   if( ea->stn!=eb->stn ) return (ea->stn < eb->stn) ? -1 : 1;
+   return 0;
+}
+
+
+
+
+/* "Set OCL grid time mask" - make the query bitmaps for the -y, -m and -D
+   ranges (all bits set for any that aren't given), using the same tests as
+   the filters in getOCLStationData() and oclfilt so exactly the same
+   stations pass */
+static void setOCLGridTimeMask(OCLGridTimeMaskType *mask,
+   int yearRangeFlag, long int *yearRange, int monthRangeFlag,
+   long int *monthRange, int dayRangeFlag, long int *dayRange) {
+
+   long int i;
+
+   memset(mask, 0, sizeof(*mask));
+   mask->yearRangeFlag = yearRangeFlag;
+   if( yearRangeFlag ) memcpy(mask->yearRange, yearRange, 2*sizeof(long int));
+   mask->monthRangeFlag = monthRangeFlag;
+   if( monthRangeFlag )
+      memcpy(mask->monthRange, monthRange, 2*sizeof(long int));
+   for(i=0; i<OCL_GRID_YEARS; i++)
+      if( !yearRangeFlag || (i>=yearRange[0] && i<=yearRange[1]) )
+         mask->year[i>>3] |= 1 << (i&7);
+   for(i=0; i<OCL_GRID_MONTHS; i++)
+      if( !monthRangeFlag || inOCLCyclicRange(i, monthRange) ) {
+         mask->month[i>>3] |= 1 << (i&7);
+         mask->cellMonths |= OCL_GRID_MONTH_BIT(i);
+      }
+   for(i=0; i<OCL_GRID_DAYS; i++)
+      if( !dayRangeFlag || inOCLCyclicRange(i, dayRange) )
+         mask->dayOfYear[i>>3] |= 1 << (i&7);
+}
+
+
+
+
+/* "OCL grid time okay" - true if an entry's date is in the time mask */
+static int oclGridTimeOK(OCLGridTimeMaskType *mask,
+   const OCLGridEntryType *e) {
+
+   if( e->year>=0 && e->year<OCL_GRID_YEARS ) {
+      if( !OCL_GRID_BIT(mask->year, e->year) ) return 0;
+   }
+   else if( mask->yearRangeFlag &&
+       (e->year < mask->yearRange[0] || e->year > mask->yearRange[1]) )
+      return 0;
+
+   if( e->month<OCL_GRID_MONTHS ) {
+      if( !OCL_GRID_BIT(mask->month, e->month) ) return 0;
+   }
+   else if( mask->monthRangeFlag &&
+       !inOCLCyclicRange(e->month, mask->monthRange) )
+      return 0;
+
+   return OCL_GRID_BIT(mask->dayOfYear, e->dayOfYear) != 0;
+}
+
+
+
+
+/* "Add OCL grid cell hits" - append the entries of one cell that are in the
+   region (if latlonRegionFlag) and whose dates are in the time mask to
+   hit[], using the same test as the -l filter in getOCLStationData() so
+   exactly the same stations pass */
+static long int addOCLGridCellHits(OCLGridType *grid, long int cell,
+   int latlonRegionFlag, double *latlonRegion, OCLGridTimeMaskType *mask,
+   OCLGridEntryType *hit, long int n) {
+
+   const OCLGridEntryType *e;
+   long int i;
+
+   /* whole cell out if none of its months are wanted */
+   if( !(grid->cellMonths[cell] & mask->cellMonths) ) return n;
+
+   for(i=grid->cellStart[cell]; i<grid->cellStart[cell+1]; i++) {
+      e = &(grid->entry[i]);
+      if( latlonRegionFlag &&
+          (e->lon < latlonRegion[0] || e->lon > latlonRegion[1] ||
+           e->lat < latlonRegion[2] || e->lat > latlonRegion[3]) )
+         continue;
+      if( oclGridTimeOK(mask, e) ) hit[n++] = *e;
+   }
+   return n;
+}
+
+
+
+
+/* "Query OCL grid" - find the stations in the grid that the -l, -y, -m and
+   -D filters would pass for latlonRegion (w/e/s/n, as in getOCLStationData),
+   yearRange, monthRange and dayRange (day of year), each only if its flag is
+   true.  *hit is set to a malloc'ed list of them in file & station order
+   (for the caller to free), and the number of them is returned, or -1 if
+   out of memory. */
+long int queryOCLGrid(OCLGridType *grid, int latlonRegionFlag,
+   double *latlonRegion, int yearRangeFlag, long int *yearRange,
+   int monthRangeFlag, long int *monthRange, int dayRangeFlag,
+   long int *dayRange, OCLGridEntryType **hit) {
+
+   static OCLGridTimeMaskType mask;
+   long int n=0, r, r0, r1, c, c0, c1;
+
+   *hit = (OCLGridEntryType *)malloc(
+      (grid->numEntries+1)*sizeof(OCLGridEntryType));
+   if( *hit==NULL ) return -1;
+
+   setOCLGridTimeMask(&mask, yearRangeFlag, yearRange, monthRangeFlag,
+      monthRange, dayRangeFlag, dayRange);
+
+   if( !latlonRegionFlag ) {
+      for(c=0; c<OCL_GRID_CELLS; c++)
+         n = addOCLGridCellHits(grid, c, 0, NULL, &mask, *hit, n);
+   }
+   else {
+      /* just the cells overlapping the region (none if it misses the
+         grid's range altogether), and the off-grid cell */
+      if( latlonRegion[2]<=90. && latlonRegion[3]>=-90. &&
+          latlonRegion[0]<=360. && latlonRegion[1]>=-180. ) {
+         r0 = (latlonRegion[2]<=-90.) ? 0 : oclGridRow(latlonRegion[2]);
+         r1 = (latlonRegion[3]>=90.) ? OCL_GRID_NLAT-1 :
+            oclGridRow(latlonRegion[3]);
+         c0 = (latlonRegion[0]<=-180.) ? 0 : oclGridCol(latlonRegion[0]);
+         c1 = (latlonRegion[1]>=360.) ? OCL_GRID_NLON-1 :
+            oclGridCol(latlonRegion[1]);
+         for(r=r0; r<=r1; r++)
+            for(c=c0; c<=c1; c++)
+               n = addOCLGridCellHits(grid, r*OCL_GRID_NLON+c, 1,
+                  latlonRegion, &mask, *hit, n);
+      }
+      n = addOCLGridCellHits(grid, OCL_GRID_OFF, 1, latlonRegion, &mask,
+         *hit, n);
+   }
+
+   qsort(*hit, (size_t)n, sizeof(OCLGridEntryType), compareOCLGridEntries);
+   return n;
+}
@@ -0,0 +1,291 @@
+/* oclIndex.c -
+ *             Station offset index for OCL files.  An index lists, for each
+ *             station in an OCL file, the byte offset where the station
+ *             starts, its length in bytes (up to where the next station
+ *             starts), and its OCL station number.  With that, a reader can
+ *             go straight to station N (or to a given oclStationNumber) with
+ *             one seek, instead of decoding the bytesInStation and
+ *             oclStationNumber fields of every earlier station and skipping
+ *             over their bytes.
+ *
+ *             Indexes are normally kept as small binary "sidecar" files next
+ *             to the OCL file (<oclfile>.idx), made once with makeOCLIndex.
+ *             The sidecar records the key of the OCL file it was made from
+ *             (its size and a checksum of its first and last few KB, see
+ *             getOCLSourceKey() in oclSource.c), and matchOCLIndex() checks
+ *             that and where the last station starts, so a stale sidecar or
+ *             one for another file gets caught rather than used.  On every
+ *             seek, seekOCLStation() checks that the station there has the
+ *             OCL station number the index has for it, too.
+ *
+ *             Sidecar layout (native byte order, as written by fwrite):
+ *               8 bytes         magic "OCLIDX2" + '\0'
+ *               long int        size in bytes of the indexed OCL file
+ *               unsigned long   checksum of its first and last few KB
+ *               long int        number of stations
+ *               numStations x   OCLIndexEntryType (offset, length, oclStnNum)
+ *
+ *             An index can be made of an OCL cache file (see oclCache.c) too,
+ *             its "stations" then being the rows of the cache's header table.
+ *
+ * other required sources/files: ocl.h, oclSource.c, getOCLStationData.c,
+ *                               oclCache.c
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             OCLIndexType idx;
+ *             if( readOCLIndex( "ncts1311.idx", &idx ) == SUCCESSFUL &&
+ *                 matchOCLIndex( &src, &idx ) == SUCCESSFUL ) {
+ *                stn = findOCLIndexStation( &idx, 1234567 );
+ *                seekOCLStation( &src, &idx, stn );
+ *                ...read from station stn on with getOCLStationDataSrc()...
+ *             }
+ *             freeOCLIndex( &idx );
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+#define OCL_INDEX_MAGIC "OCLIDX2"   /* (plus its '\0' makes 8 bytes) */
+
+
+
+
+/* "Read OCL index fields" - the OCL station number of the station starting
+   at src's position (-1 if it's blank), leaving src after the fields read.
+   Sets bytesLeftInStation for skipping the rest of the station (-1 for an
+   OCL cache, whose header rows are all there is to step over). */
+static void readOCLIndexFields(OCLSourceType *src, long int *oclStationNumber,
+   long int *bytesLeftInStation) {
+   const OCLCacheStationType *row;
+   long int start=tellOCLSource(src), bytesInStation;
+
+   if( src->cacheProfiles!=NULL ) {
+      row = (const OCLCacheStationType *)(src->base + start);
+      *oclStationNumber = row->oclStationNumber;
+      *bytesLeftInStation = -1;
+      seekOCLSource(src, start + (long int)sizeof(*row));
+      return;
+   }
+
+   *bytesLeftInStation = -1;  /* (first field sets it, as in getOCLStnData)*/
+   if( getVarlenIntFieldSrc(src, &bytesInStation, bytesLeftInStation)
+      == ZERO_LENGTH_FIELD )
+      bytesInStation=0;
+   if( getVarlenIntFieldSrc(src, oclStationNumber, bytesLeftInStation)
+      == ZERO_LENGTH_FIELD )
+      *oclStationNumber=-1;
+}
+
+
+
+
+/* "Build OCL index" - scan the stations in src from its current position to
+   the end, recording where each one starts.  Only the bytesInStation and
+   oclStationNumber fields of each station are decoded. */
+int buildOCLIndex(OCLSourceType *src, OCLIndexType *idx) {
+   long int allocated=1024, start, bytesLeftInStation;
+   OCLIndexEntryType *entry;
+
+   idx->numStations = 0;
+   if( getOCLSourceKey(src, &(idx->key)) != SUCCESSFUL ) {
+      fprintf(stderr, "buildOCLIndex: can only index a file.\n");
+      idx->entry = NULL;
+      return UNSPECIFIED_PROBLEM;
+   }
+   idx->entry = (OCLIndexEntryType *)malloc(allocated*sizeof(*idx->entry));
+   if( idx->entry==NULL ) {
+      fprintf(stderr, "buildOCLIndex: out of memory.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   while( !endOfOCLSource(src) ) {
+      if( idx->numStations==allocated ) {
+         allocated *= 2;
+         entry = (OCLIndexEntryType *)realloc(idx->entry,
+            allocated*sizeof(*idx->entry));
+         if( entry==NULL ) {
+            fprintf(stderr, "buildOCLIndex: out of memory.\n");
+            freeOCLIndex(idx);
+            return UNSPECIFIED_PROBLEM;
+         }
+         idx->entry = entry;
+      }
+      entry = &(idx->entry[idx->numStations]);
+
+      start = tellOCLSource(src);
+      entry->offset = start;
+      readOCLIndexFields(src, &(entry->oclStationNumber), &bytesLeftInStation);
+
+      /* an OCL cache's stations are the rows of its header table - for
+         length take the row plus the station's profile columns, which are
+         elsewhere in the file */
+      if( src->cacheProfiles!=NULL )
+         entry->length = (long int)sizeof(OCLCacheStationType) +
+            sizeOfOCLCacheProfile(
+               (const OCLCacheStationType *)(src->base + start));
+      else {
+         skipToNextStationSrc(src, bytesLeftInStation);
+         entry->length = tellOCLSource(src) - start;
+      }
+      idx->numStations++;
+   }
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Write OCL index" - save index to a sidecar file */
+int writeOCLIndex(char *filename, OCLIndexType *idx) {
+   FILE *fp;
+   char magic[8];
+   int status=SUCCESSFUL;
+
+   if( (fp=fopen(filename,"wb")) == NULL ) {
+      fprintf(stderr, "Unable to open index file %s for writing.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   memset(magic, 0, sizeof(magic));
+   strcpy(magic, OCL_INDEX_MAGIC);
+   if( fwrite(magic, sizeof(magic), 1, fp) != 1 ||
+       fwrite(&(idx->key.fileSize), sizeof(long int), 1, fp) != 1 ||
+       fwrite(&(idx->key.checksum), sizeof(unsigned long int), 1, fp) != 1 ||
+       fwrite(&(idx->numStations), sizeof(long int), 1, fp) != 1 ||
+       (long int)fwrite(idx->entry, sizeof(OCLIndexEntryType),
+          (size_t)idx->numStations, fp) != idx->numStations ) {
+      fprintf(stderr, "Error writing index file %s.\n", filename);
+      status=UNSPECIFIED_PROBLEM;
+   }
+
+   if( fclose(fp) != 0 ) status=UNSPECIFIED_PROBLEM;
+   return status;
+}
+
+
+
+
+/* "Read OCL index" - load an index from a sidecar file.  Quietly returns
+   UNSPECIFIED_PROBLEM if the file isn't there, so callers can just try it.
+   (Whether it's the index of the file at hand is for matchOCLIndex().) */
+int readOCLIndex(char *filename, OCLIndexType *idx) {
+   FILE *fp;
+   char magic[8];
+
+   idx->numStations = 0;
+   idx->entry = NULL;
+
+   if( (fp=fopen(filename,"rb")) == NULL ) return UNSPECIFIED_PROBLEM;
+
+   if( fread(magic, sizeof(magic), 1, fp) != 1 ||
+       strncmp(magic, OCL_INDEX_MAGIC, sizeof(magic)) ||
+       fread(&(idx->key.fileSize), sizeof(long int), 1, fp) != 1 ||
+       fread(&(idx->key.checksum), sizeof(unsigned long int), 1, fp) != 1 ||
+       fread(&(idx->numStations), sizeof(long int), 1, fp) != 1 ||
+       idx->numStations < 0 ) {
+      fprintf(stderr, "%% %s is not an OCL index file.\n", filename);
+      fclose(fp);
+      idx->numStations = 0;
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   idx->entry = (OCLIndexEntryType *)malloc(
+      (idx->numStations+1)*sizeof(OCLIndexEntryType));
+   if( idx->entry==NULL ||
+       (long int)fread(idx->entry, sizeof(OCLIndexEntryType),
+          (size_t)idx->numStations, fp) != idx->numStations ) {
+      fprintf(stderr, "%% index file %s is truncated.\n", filename);
+      fclose(fp);
+      freeOCLIndex(idx);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   fclose(fp);
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Free OCL index" */
+void freeOCLIndex(OCLIndexType *idx) {
+   free(idx->entry);
+   idx->entry = NULL;
+   idx->numStations = 0;
+}
+
+
+
+
+/* "Find OCL index station" - returns the station number (count from 0 in
+   the file, like the stn arg of getOCLStationData) of the first station with
+   the given OCL station number, or -1 if there isn't one. */
+long int findOCLIndexStation(OCLIndexType *idx, long int oclStationNumber) {
+   long int i;
+
+   for(i=0; i<idx->numStations; i++)
+      if( idx->entry[i].oclStationNumber == oclStationNumber ) return i;
+
+   return -1;
+}
+
+
+
+
+/* "Check OCL index station" - true if station stn starts where the index
+   says, with the OCL station number it says.  Moves src. */
+static int checkOCLIndexStation(OCLSourceType *src, OCLIndexType *idx,
+   long int stn) {
+   long int oclStationNumber, bytesLeftInStation;
+
+   if( seekOCLSource(src, idx->entry[stn].offset) != SUCCESSFUL ||
+       endOfOCLSource(src) )
+      return 0;
+   readOCLIndexFields(src, &oclStationNumber, &bytesLeftInStation);
+   return oclStationNumber == idx->entry[stn].oclStationNumber;
+}
+
+
+
+
+/* "Seek OCL station" - position src at the start of station stn, so the next
+   getOCLStationDataSrc() call reads that station.  A stn past the last
+   station leaves src at its end.  Returns UNSPECIFIED_PROBLEM (saying so) if
+   the station there isn't the one the index has, ie the index isn't this
+   file's. */
+int seekOCLStation(OCLSourceType *src, OCLIndexType *idx, long int stn) {
+   if( stn<0 ) return UNSPECIFIED_PROBLEM;
+   if( stn>=idx->numStations ) return seekOCLSource(src, idx->key.fileSize);
+   if( !checkOCLIndexStation(src, idx, stn) ) {
+      fprintf(stderr, "seekOCLStation: station %ld isn't where the index has"
+         " it.\n", stn);
+      return UNSPECIFIED_PROBLEM;
+   }
+   return seekOCLSource(src, idx->entry[stn].offset);
+}
+
+
+
+
+/* "Match OCL index" - SUCCESSFUL if idx is the index of src: made from a
+   file with the same key, and with its last station where src has one.
+   Leaves src where it was. */
+int matchOCLIndex(OCLSourceType *src, OCLIndexType *idx) {
+   OCLSourceKeyType key;
+   long int pos=tellOCLSource(src);
+   int status=SUCCESSFUL;
+
+   if( getOCLSourceKey(src, &key) != SUCCESSFUL ||
+       !sameOCLSourceKey(&key, &(idx->key)) )
+      return UNSPECIFIED_PROBLEM;
+   if( idx->numStations>0 &&
+       !checkOCLIndexStation(src, idx, idx->numStations-1) )
+      status = UNSPECIFIED_PROBLEM;
+   if( seekOCLSource(src, pos) != SUCCESSFUL ) status = UNSPECIFIED_PROBLEM;
+   return status;
+}
@@ -0,0 +1,212 @@
+/* oclRecord.c -
+ *             Binary "record stream" output of oclfilt (-B), for programs
+ *             downstream of it in a pipe, like sspcomp.  The usual output
+ *             is text columns, which a program reading them then has to
+ *             parse right back into numbers with sscanf - so every value
+ *             gets converted twice on its way down the pipe.  A record
+ *             stream carries the decoded doubles themselves instead, along
+ *             with what each column is, so the reading end needs no
+ *             parsing or knowledge of the text layout.
+ *
+ *             The stream holds exactly what the text output would (the same
+ *             stations, and on each just the levels and variables that
+ *             would be printed - so -v, -V, -r etc all apply as usual), but
+ *             no -e/-q summary or title lines.  Each input file's output
+ *             starts with a stream header, so the streams from several
+ *             input files (or -j workers) just follow one after another.
+ *
+ *             Record stream layout (native byte order and sizes, as written
+ *             by fwrite - so it's meant for a pipe or a file read on the
+ *             kind of machine that made it, which the station record size
+ *             in the header checks for):
+ *               stream header:
+ *                  8 bytes       magic "OCLREC1" + '\0'
+ *                  long int      sizeof(OCLRecordStationType)
+ *                  long int      flags (OCL_RECORD_TITLES if oclfilt would
+ *                                have printed the title lines, ie no -t)
+ *               then for each station that passed the filters:
+ *                  OCLRecordStationType   station header, starting with
+ *                                "OCLRSTN" + '\0', with the codes, labels
+ *                                and units of its nv = numVars output
+ *                                variables (see oclRecord.h)
+ *                  numLevels x   level record of
+ *                     double        value[1+nv]    depth, then variables
+ *                     unsigned char errCode[1+nv]  their error codes
+ *                     padding out to a multiple of 8 bytes
+ *
+ * other required sources/files: ocl.h, oclRecord.h
+ *
+ * language:   ANSI C
+ *
+ * Usage:
+ *             writeOCLRecordHeader( fp_out, OCL_RECORD_TITLES );
+ *             for each station:
+ *                writeOCLRecordStation( fp_out, &rec );
+ *                for(j=0; j<rec.numLevels; j++)
+ *                   writeOCLRecordLevel( fp_out, rec.numVars, value,
+ *                      errCode );
+ *
+ *             if( isOCLRecordStream( fp_in ) )
+ *                while( readOCLRecordStation( fp_in, &rec, &flags ) ==
+ *                       SUCCESSFUL )
+ *                   for(j=0; j<rec.numLevels; j++)
+ *                      readOCLRecordLevel( fp_in, rec.numVars, value,
+ *                         errCode );
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ocl.h"
+
+#define OCL_RECORD_MAGIC "OCLREC1"     /* (plus its '\0' makes 8 bytes) */
+#define OCL_RECORD_STATION_TAG "OCLRSTN"
+
+
+
+
+/* "Size of OCL record level" - bytes in a level record for a station with
+   numVars variables, padding included */
+long int sizeOfOCLRecordLevel(long int numVars) {
+   return ( (1+numVars)*(long int)(sizeof(double)+1) + 7 ) / 8 * 8;
+}
+
+
+
+
+/* "Write OCL record header" - start a record stream on fp */
+int writeOCLRecordHeader(FILE *fp, long int flags) {
+
+   char magic[8];
+   long int stationSize = (long int)sizeof(OCLRecordStationType);
+
+   memset(magic, 0, sizeof(magic));
+   strcpy(magic, OCL_RECORD_MAGIC);
+   if( fwrite(magic, 1, sizeof(magic), fp) != sizeof(magic) ||
+       fwrite(&stationSize, sizeof(long int), 1, fp) != 1 ||
+       fwrite(&flags, sizeof(long int), 1, fp) != 1 )
+      return UNSPECIFIED_PROBLEM;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Write OCL record station" - write a station's header record (its tag is
+   filled in here), to be followed by its rec->numLevels level records */
+int writeOCLRecordStation(FILE *fp, OCLRecordStationType *rec) {
+
+   memset(rec->tag, 0, sizeof(rec->tag));
+   strcpy(rec->tag, OCL_RECORD_STATION_TAG);
+   if( fwrite(rec, sizeof(OCLRecordStationType), 1, fp) != 1 )
+      return UNSPECIFIED_PROBLEM;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Write OCL record level" - write one level record: value[0] is the
+   depth and value[1..numVars] the variables, with their error codes in
+   errCode[] */
+int writeOCLRecordLevel(FILE *fp, long int numVars, const double *value,
+   const unsigned char *errCode) {
+
+   double level[OCL_RECORD_MAX_VARS+3];  /* (room for the error codes and padding) */
+   long int size = sizeOfOCLRecordLevel(numVars);
+
+   memset(level, 0, (size_t)size);
+   memcpy(level, value, (size_t)(1+numVars)*sizeof(double));
+   memcpy(level+1+numVars, errCode, (size_t)(1+numVars));
+   if( fwrite(level, 1, (size_t)size, fp) != (size_t)size )
+      return UNSPECIFIED_PROBLEM;
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Is OCL record stream" - true if fp (not yet read from) holds a record
+   stream rather than text, going by its first character - the magic's 'O',
+   which no line of oclfilt's text output starts with.  The character is
+   put back, so reading starts from the beginning either way. */
+int isOCLRecordStream(FILE *fp) {
+
+   int c = getc(fp);
+
+   if( c==EOF ) return 0;
+   ungetc(c, fp);
+   return c==OCL_RECORD_MAGIC[0];
+}
+
+
+
+
+/* "Read OCL record station" - read the next station header record from fp
+   into rec, reading past any stream headers on the way (keeping the last
+   one's flags in *flags).  Returns OCL_RECORD_END at the end of the
+   stream, or UNSPECIFIED_PROBLEM if it's not a record stream, was made on
+   a different kind of machine, or is cut short. */
+int readOCLRecordStation(FILE *fp, OCLRecordStationType *rec,
+   long int *flags) {
+
+   char tag[8];
+   long int stationSize;
+   size_t n;
+
+   while( (n=fread(tag, 1, sizeof(tag), fp)) == sizeof(tag) ) {
+
+      if( !memcmp(tag, OCL_RECORD_STATION_TAG, sizeof(tag)) ) {
+         memcpy(rec->tag, tag, sizeof(tag));
+         if( fread((char *)rec+sizeof(tag), sizeof(OCLRecordStationType)-
+               sizeof(tag), 1, fp) != 1 )
+            break;
+         if( rec->numVars<0 || rec->numVars>OCL_RECORD_MAX_VARS || rec->numLevels<0 ) {
+            fprintf(stderr, "readOCLRecordStation: bad station record.\n");
+            return UNSPECIFIED_PROBLEM;
+         }
+         return SUCCESSFUL;
+      }
+
+      if( memcmp(tag, OCL_RECORD_MAGIC, sizeof(tag)) ) {
+         fprintf(stderr, "readOCLRecordStation: not an OCL record stream.\n");
+         return UNSPECIFIED_PROBLEM;
+      }
+      if( fread(&stationSize, sizeof(long int), 1, fp) != 1 ||
+          fread(flags, sizeof(long int), 1, fp) != 1 )
+         break;
+      if( stationSize != (long int)sizeof(OCLRecordStationType) ) {
+         fprintf(stderr, "readOCLRecordStation: record stream was made on a"
+            " different kind of machine.\n");
+         return UNSPECIFIED_PROBLEM;
+      }
+   }
+
+   if( n==0 && feof(fp) ) return OCL_RECORD_END;
+   fprintf(stderr, "readOCLRecordStation: record stream cut short.\n");
+   return UNSPECIFIED_PROBLEM;
+}
+
+
+
+
+/* "Read OCL record level" - read the next level record of the current
+   station (which has numVars variables) into value[] and errCode[], as for
+   writeOCLRecordLevel() */
+int readOCLRecordLevel(FILE *fp, long int numVars, double *value,
+   unsigned char *errCode) {
+
+   double level[OCL_RECORD_MAX_VARS+3];
+   long int size = sizeOfOCLRecordLevel(numVars);
+
+   if( fread(level, 1, (size_t)size, fp) != (size_t)size ) {
+      fprintf(stderr, "readOCLRecordLevel: record stream cut short.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+   memcpy(value, level, (size_t)(1+numVars)*sizeof(double));
+   memcpy(errCode, level+1+numVars, (size_t)(1+numVars));
+
+   return SUCCESSFUL;
+}
@@ -0,0 +1,51 @@
+/* Include file for oclfilt's binary record streams (-B), shared with
+   sspcomp which reads them - see oclRecord.c.  (Included by ocl.h.)       */
+
+/* Constants */
+#define OCL_RECORD_MAX_VARS 10     /* (same as MAX_VARS in ocl.h) */
+#define OCL_RECORD_NAME_LEN 12     /* var label/units string size */
+
+/* Stream header flags */
+#define OCL_RECORD_TITLES 1L       /* the text output would have had titles */
+
+/* readOCLRecordStation() status at the end of the stream (otherwise it's
+   SUCCESSFUL or UNSPECIFIED_PROBLEM, as in ocl.h) */
+#define OCL_RECORD_END (-1)
+
+
+/* One station's header record in an oclfilt -B record stream, followed by
+   its numLevels level records of depth and numVars values.  Fixed width, so
+   it's read and written whole.  See oclRecord.c */
+typedef struct OCLRecordStation {
+      char tag[8];             /* "OCLRSTN", to check the stream's in step */
+      long int stationNumber;  /* (in its input file, as in %Station lines) */
+      long int year;
+      long int month;
+      long int day;
+      double time;
+      double lat;
+      double lon;
+      double bottomDepth;      /* bottom depth, or NaN if there's none */
+      long int bottomDepthSource;  /* 'h', 'p', 'd', or '-' for none, as in
+                                      OCLStationType */
+      long int stationType;
+      long int numLevels;      /* level records that follow */
+      long int numVars;        /* variables output, ie values on each level
+                                  after the depth */
+      long int varCode[OCL_RECORD_MAX_VARS];
+      char varLabel[OCL_RECORD_MAX_VARS][OCL_RECORD_NAME_LEN]; /* eg "Temp", */
+      char varUnits[OCL_RECORD_MAX_VARS][OCL_RECORD_NAME_LEN]; /* "deg C" */
+}  OCLRecordStationType;
+
+
+/* Function prototypes */
+long int sizeOfOCLRecordLevel(long int numVars);
+int writeOCLRecordHeader(FILE *fp, long int flags);
+int writeOCLRecordStation(FILE *fp, OCLRecordStationType *rec);
+int writeOCLRecordLevel(FILE *fp, long int numVars, const double *value,
+   const unsigned char *errCode);
+int isOCLRecordStream(FILE *fp);
+int readOCLRecordStation(FILE *fp, OCLRecordStationType *rec,
+   long int *flags);
+int readOCLRecordLevel(FILE *fp, long int numVars, double *value,
+   unsigned char *errCode);
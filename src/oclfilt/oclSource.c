@@ -0,0 +1,468 @@
+/* oclSource.c -
+ *             Byte sources for getOCLStationDataSrc().  An OCLSourceType is
+ *             either a plain stdio stream (same as what getOCLStationData()
+ *             always read from), or a "span" - the whole OCL file sitting in
+ *             memory, either memory-mapped straight from disk or a buffer the
+ *             caller already filled (eg decompressed data).
+ *
+ *             Reading a span is done by moving a cursor (src->pos) along the
+ *             bytes and converting the digit fields right where they sit, so
+ *             there's no fgetc() per byte, no copying into a temporary
+ *             string, and no sscanf() per field.  On a full WOD98 sweep that
+ *             per-byte stdio overhead was the dominant CPU cost.
+ *
+ *             The field decoders themselves (getIntDigits() and the rest)
+ *             are written once in oclSourcePolicy.h and compiled for each
+ *             kind of source, stdio or span, with that source's byte access
+ *             inlined - same newline/CR skipping, same fgets()-style skip to
+ *             the end of the station's last line, same eof behavior - so the
+ *             output is byte-for-byte the same either way.
+ *
+ *             WOD98 files are written as fixed-width lines (80 chars plus
+ *             the newline, padded with blanks), and the station byte counts
+ *             don't include the newlines.  So once the first line's width is
+ *             known (checkOCLLineGeometry), jumpToNextStation() can work out
+ *             where the next station starts from bytesLeftInStation and go
+ *             there with one seek, rather than reading every byte in between.
+ *             The landing spot is checked (newline before it, a digit or eof
+ *             at it) and if a file turns out not to be fixed-width the jump
+ *             is turned off for it and the byte-by-byte skip is used instead.
+ *             Only works on seekable input - from a pipe it's never tried.
+ *
+ *             The WOD98 CDs have the data files gzipped, with DOS \r\n line
+ *             ends.  loadOCLGzSource() inflates such a file with zlib right
+ *             into a span, dropping the \r's in the same pass, so there's no
+ *             need for the old  gunzip -c file.gz | tr -d '\r' | prog  pipe
+ *             (two extra processes and two extra copies of every byte).
+ *
+ *             A span can also be an OCL cache file (see oclCache.c), in which
+ *             case the cursor steps along its table of station headers, one
+ *             fixed-width row per station, rather than along OCL text.
+ *
+ * other required sources/files: ocl.h, getOCLStationData.c,
+ *                               oclSourcePolicy.h
+ *
+ * language:   ANSI C, plus POSIX mmap() for mapOCLSource() and zlib for
+ *             loadOCLGzSource() (link with -lz)
+ *
+ * Usage:
+ *             OCLSourceType src;
+ *             if( mapOCLSource( &src, "ncts1311" ) != SUCCESSFUL ) exit(1);
+ *             for( i=0; !endOfOCLSource(&src); i++ )
+ *                getOCLStationDataSrc( &src, i, &stnData, ...same args as
+ *                                      getOCLStationData() after stn... );
+ *             closeOCLSource( &src );
+ */
+
+#define _POSIX_C_SOURCE 200112L  /* for mmap() etc with -ansi */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <zlib.h>
+#include "ocl.h"
+
+#define GZ_CHUNK 262144L  /* bytes inflated per gzread() in loadOCLGzSource */
+
+
+
+
+/* "Set OCL source file" - read from an already-opened stdio stream */
+void setOCLSourceFile(OCLSourceType *src, FILE *fp) {
+   src->fp = fp;
+   src->base = NULL;
+   src->len = 0;
+   src->pos = 0;
+   src->atEOF = 0;
+   src->isMapped = 0;
+   src->isOwned = 0;
+   src->lineGeometry = 0;
+   src->lineLen = 0;
+   src->lineWidth = 0;
+   src->cacheProfiles = NULL;
+}
+
+
+
+
+/* "Set OCL source buffer" - read from a span of bytes the caller owns (eg a
+   decompressed file).  Buffer must stay around till done reading it. */
+void setOCLSourceBuffer(OCLSourceType *src, const char *buf, long int len) {
+   setOCLSourceFile(src, NULL);
+   src->base = buf;
+   src->len = len;
+}
+
+
+
+
+/* "Map OCL source" - memory-map a whole OCL file read-only for reading */
+int mapOCLSource(OCLSourceType *src, char *filename) {
+   int fd;
+   struct stat st;
+   void *p;
+
+   setOCLSourceFile(src, NULL);
+
+   if( (fd=open(filename, O_RDONLY)) < 0 ) {
+      fprintf(stderr, "Unable to open file %s.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+   if( fstat(fd, &st) != 0 ) {
+      fprintf(stderr, "Unable to stat file %s.\n", filename);
+      close(fd);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   /* (mmap won't map zero bytes - leave an empty span, which then gives the
+      same "unexpected EOF" as the stdio reader does on an empty file) */
+   if( st.st_size > 0 ) {
+      p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if( p == MAP_FAILED ) {
+         fprintf(stderr, "Unable to memory-map file %s.\n", filename);
+         close(fd);
+         return UNSPECIFIED_PROBLEM;
+      }
+      /* we read front to back, so tell the kernel to read ahead hard */
+      posix_madvise(p, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+      src->base = (const char *)p;
+      src->len = (long int)st.st_size;
+      src->isMapped = 1;
+   }
+
+   close(fd);  /* (mapping stays valid after close) */
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Is gzip file" - true if the file starts with the gzip magic bytes */
+int isGzipFile(char *filename) {
+   FILE *fp;
+   int c1, c2;
+
+   if( (fp=fopen(filename,"rb")) == NULL ) return 0;
+   c1=fgetc(fp);
+   c2=fgetc(fp);
+   fclose(fp);
+   return c1==0x1f && c2==0x8b;
+}
+
+
+
+
+/* "Load OCL gz source" - inflate a gzipped OCL file into a malloc'ed span,
+   stripping \r's as each chunk comes out of zlib.  The span is freed by
+   closeOCLSource(). */
+int loadOCLGzSource(OCLSourceType *src, char *filename) {
+   gzFile gz;
+   struct stat st;
+   char *buf, *newbuf, *p, *q, *end;
+   long int allocated, len=0;
+   int n;
+
+   setOCLSourceFile(src, NULL);
+
+   if( (gz=gzopen(filename, "rb")) == NULL ) {
+      fprintf(stderr, "Unable to open file %s.\n", filename);
+      return UNSPECIFIED_PROBLEM;
+   }
+   gzbuffer(gz, (unsigned)GZ_CHUNK);
+
+   /* WOD98 text compresses roughly 4-5x, so start near the right size */
+   allocated = 4*GZ_CHUNK;
+   if( stat(filename, &st)==0 && 5*(long int)st.st_size > allocated )
+      allocated = 5*(long int)st.st_size;
+   if( (buf=(char *)malloc((size_t)allocated)) == NULL ) {
+      fprintf(stderr, "loadOCLGzSource: out of memory.\n");
+      gzclose(gz);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   for(;;) {
+      if( allocated-len < GZ_CHUNK ) {
+         allocated *= 2;
+         if( (newbuf=(char *)realloc(buf, (size_t)allocated)) == NULL ) {
+            fprintf(stderr, "loadOCLGzSource: out of memory.\n");
+            free(buf);
+            gzclose(gz);
+            return UNSPECIFIED_PROBLEM;
+         }
+         buf = newbuf;
+      }
+      if( (n=gzread(gz, buf+len, (unsigned)GZ_CHUNK)) <= 0 ) break;
+
+      /* squeeze the \r's out of the chunk just inflated, in place */
+      end = buf+len+n;
+      for(p=q=buf+len; p<end; p++)
+         if( *p!='\r' ) *q++ = *p;
+      len = q-buf;
+   }
+
+   if( n<0 ) {
+      fprintf(stderr, "Error decompressing file %s: %s\n", filename,
+         gzerror(gz, &n));
+      free(buf);
+      gzclose(gz);
+      return UNSPECIFIED_PROBLEM;
+   }
+   gzclose(gz);
+
+   setOCLSourceBuffer(src, buf, len);
+   src->isOwned = 1;
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Close OCL source" - unmap or free span if we mapped/loaded it (stdio
+   streams and caller buffers are left to the caller to close/free) */
+void closeOCLSource(OCLSourceType *src) {
+   if( src->isMapped )
+      munmap((void *)src->base, (size_t)src->len);
+   if( src->isOwned )
+      free((void *)src->base);
+   src->base = NULL;
+   src->len = 0;
+   src->pos = 0;
+   src->isMapped = 0;
+   src->isOwned = 0;
+   src->cacheProfiles = NULL;
+}
+
+
+
+
+/* "End of OCL source" - the feof() of an OCLSourceType, for station loops */
+int endOfOCLSource(OCLSourceType *src) {
+   if( src->fp!=NULL ) return feof(src->fp);
+   else return src->atEOF;
+}
+
+
+
+
+/* "Tell OCL source" - byte offset of the next byte to be read (-1 if the
+   source can't tell, eg a pipe) */
+long int tellOCLSource(OCLSourceType *src) {
+   if( src->fp!=NULL ) return ftell(src->fp);
+   else return src->pos;
+}
+
+
+
+
+/* "Seek OCL source" - move to byte offset in the source (eg the start of a
+   station found in an OCL index).  Like skipToNextStation(), leaves eof set
+   if there's nothing left to read there. */
+int seekOCLSource(OCLSourceType *src, long int offset) {
+   int nextch;
+
+   if( src->fp!=NULL ) {
+      if( fseek(src->fp, offset, SEEK_SET) != 0 ) return UNSPECIFIED_PROBLEM;
+      nextch=fgetc(src->fp); if (nextch!=EOF) ungetc(nextch, src->fp);
+   }
+   else {
+      if( offset<0 || offset>src->len ) return UNSPECIFIED_PROBLEM;
+      src->pos = offset;
+      /* (an OCL cache's stations end where its header table does) */
+      if( src->cacheProfiles!=NULL )
+         src->atEOF = (src->base+src->pos >= src->cacheProfiles);
+      else src->atEOF = (src->pos >= src->len);
+   }
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Size of OCL source" - total bytes in the source, or -1 if not known (eg
+   reading a pipe) */
+long int sizeOfOCLSource(OCLSourceType *src) {
+   struct stat st;
+
+   if( src->fp==NULL ) return src->len;
+   if( fstat(fileno(src->fp), &st)!=0 || !S_ISREG(st.st_mode) ) return -1;
+   return (long int)st.st_size;
+}
+
+
+
+
+/* "Add OCL key bytes" - run n more bytes through the key's checksum (32-bit
+   FNV-1a, the same whatever the size of an unsigned long) */
+static unsigned long int addOCLKeyBytes(unsigned long int sum,
+   const char *p, long int n) {
+   long int i;
+
+   for(i=0; i<n; i++)
+      sum = ((sum ^ (unsigned char)p[i]) * 16777619UL) & 0xffffffffUL;
+   return sum;
+}
+
+
+
+
+/* "Get OCL source key" - the size of the source and a checksum of its first
+   and last OCL_SOURCE_KEY_BYTES bytes, which a sidecar made for it records
+   (see OCLSourceKeyType).  Reading a stdio stream for it leaves the stream
+   where it was.  Returns UNSPECIFIED_PROBLEM if the source can't be keyed,
+   eg a pipe. */
+int getOCLSourceKey(OCLSourceType *src, OCLSourceKeyType *key) {
+   char buf[OCL_SOURCE_KEY_BYTES];
+   long int n, tail, pos;
+   int status=SUCCESSFUL;
+
+   key->fileSize = sizeOfOCLSource(src);
+   key->checksum = 2166136261UL;
+   if( key->fileSize<0 ) return UNSPECIFIED_PROBLEM;
+   n = (key->fileSize < OCL_SOURCE_KEY_BYTES) ?
+      key->fileSize : OCL_SOURCE_KEY_BYTES;
+   tail = key->fileSize - n;
+
+   if( src->fp==NULL ) {
+      key->checksum = addOCLKeyBytes(key->checksum, src->base, n);
+      key->checksum = addOCLKeyBytes(key->checksum, src->base + tail, n);
+      return SUCCESSFUL;
+   }
+
+   if( (pos=ftell(src->fp)) < 0 ) return UNSPECIFIED_PROBLEM;
+   if( fseek(src->fp, 0L, SEEK_SET) != 0 ||
+       (long int)fread(buf, 1, (size_t)n, src->fp) != n )
+      status = UNSPECIFIED_PROBLEM;
+   else key->checksum = addOCLKeyBytes(key->checksum, buf, n);
+   if( status!=SUCCESSFUL || fseek(src->fp, tail, SEEK_SET) != 0 ||
+       (long int)fread(buf, 1, (size_t)n, src->fp) != n )
+      status = UNSPECIFIED_PROBLEM;
+   else key->checksum = addOCLKeyBytes(key->checksum, buf, n);
+   clearerr(src->fp);
+   if( seekOCLSource(src, pos) != SUCCESSFUL ) status = UNSPECIFIED_PROBLEM;
+   return status;
+}
+
+
+
+
+/* "Same OCL source key" - true if two keys are the same file's */
+int sameOCLSourceKey(const OCLSourceKeyType *a, const OCLSourceKeyType *b) {
+   return a->fileSize==b->fileSize && a->checksum==b->checksum;
+}
+
+
+
+
+/* "Check OCL line geometry" - OCL files are written in fixed-width lines
+   (80 chars plus \n, or \r\n if still in DOS format), each station starting
+   on a new line and its last line padded out with blanks.  Measure the first
+   line to get the line width, so that jumpToNextStation() can work out where
+   the next station starts from the number of bytes left in this one.  Sets
+   src->lineGeometry to 1 if that's possible, -1 if not (eg reading a pipe). */
+int checkOCLLineGeometry(OCLSourceType *src) {
+   long int pos, n=0;
+   int nextch=0, prevch=0;
+
+   src->lineGeometry = -1;
+
+   if( src->fp!=NULL ) {
+      if( (pos=ftell(src->fp))<0 || fseek(src->fp, 0L, SEEK_SET)!=0 )
+         return src->lineGeometry;
+      while( n<1024 && (nextch=fgetc(src->fp))!=EOF && nextch!='\n' ) {
+         prevch=nextch;
+         n++;
+      }
+      if( fseek(src->fp, pos, SEEK_SET)!=0 ) {
+         fprintf(stderr,"%%oclfilt: lost place in input file.\n");
+         exit(1);
+      }
+   }
+   else {
+      while( n<1024 && n<src->len && (nextch=src->base[n])!='\n' ) {
+         prevch=nextch;
+         n++;
+      }
+      if( n>=src->len ) nextch=EOF;
+   }
+
+   if( nextch=='\n' ) {
+      src->lineWidth = n+1;
+      src->lineLen = (prevch=='\r') ? n-1 : n;
+      if( src->lineLen>0 ) src->lineGeometry = 1;
+   }
+
+   return src->lineGeometry;
+}
+
+
+
+
+/* "Jump to next station" - go straight to the start of the next station by
+   working out its offset from the line geometry, instead of reading through
+   the station's remaining bytes.  The result is the same place that
+   skipToNextStation() would end up at.  Returns UNSPECIFIED_PROBLEM without
+   moving if that's not possible, in which case the caller should fall back
+   to skipping byte by byte.  If the landing spot doesn't look like a station
+   start (ie the lines aren't actually fixed-width) src->lineGeometry is set
+   to -1 so we don't bother trying again. */
+int jumpToNextStation(OCLSourceType *src, long int bytesLeftInStation) {
+   long int pos, col, rows, target;
+   int nextch, ok;
+
+   if( src->lineGeometry==0 ) checkOCLLineGeometry(src);
+   if( src->lineGeometry<0 || (pos=tellOCLSource(src))<0 )
+      return UNSPECIFIED_PROBLEM;
+
+   /* col = chars already read on the current line.  Only worth jumping if
+      the station's remaining bytes run past the end of this line. */
+   col = pos % src->lineWidth;
+   if( col<1 || col>src->lineLen || bytesLeftInStation<=src->lineLen-col )
+      return UNSPECIFIED_PROBLEM;
+
+   /* number of lines after this one that the station still runs onto - the
+      next station then starts on the line after the last of those */
+   rows = (bytesLeftInStation-(src->lineLen-col) + src->lineLen-1)/src->lineLen;
+   target = pos - col + (rows+1)*src->lineWidth;
+
+   /* Current line has to end where the geometry says, and the landing spot
+      has to follow a newline and be either the end of the input or a digit
+      (the first byte of every station is a digit count) */
+   if( src->fp!=NULL ) {
+      ok = fseek(src->fp, pos-col+src->lineLen, SEEK_SET)==0 &&
+         ((nextch=fgetc(src->fp))=='\n' || nextch=='\r');
+      ok = ok && fseek(src->fp, target-1, SEEK_SET)==0 &&
+         fgetc(src->fp)=='\n';
+      if( ok ) {
+         /* (same peek-at-next-char as skipToNextStation, which sets eof) */
+         nextch=fgetc(src->fp);
+         if( nextch!=EOF ) {
+            ungetc(nextch, src->fp);
+            ok = isdigit(nextch);
+         }
+      }
+   }
+   else {
+      nextch = (pos-col+src->lineLen < src->len) ?
+         src->base[pos-col+src->lineLen] : EOF;
+      ok = (nextch=='\n' || nextch=='\r') &&
+         target<=src->len && src->base[target-1]=='\n' &&
+         (target==src->len || isdigit((unsigned char)src->base[target]));
+      if( ok ) {
+         src->pos = target;
+         src->atEOF = (target>=src->len);
+      }
+   }
+
+   if( !ok ) {
+      src->lineGeometry = -1;
+      seekOCLSource(src, pos);
+      return UNSPECIFIED_PROBLEM;
+   }
+   return SUCCESSFUL;
+}
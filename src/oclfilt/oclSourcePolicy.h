@@ -0,0 +1,466 @@
+/* oclSourcePolicy.h -
+ *             The OCL field decoders - getIntDigits(), getVarlenIntField(),
+ *             getVarlenFloatField(), their skipping versions,
+ *             skipToNextStation(), and the profile level loops built on
+ *             them - written once, and compiled once for each kind of byte
+ *             source ("policy") that an OCLSourceType can be.  The source is
+ *             only looked at once per call from outside (eg once per
+ *             readOCLProfileLevels()), and inside, every byte is read with
+ *             the policy's own macro, so each source's hot loop is compiled
+ *             with nothing but plain code and its own byte access inlined:
+ *
+ *               Stdio - a stdio stream, read with getc_unlocked() (a macro
+ *                       over the stream's buffer, where POSIX has it - the
+ *                       stream belongs to the one source reading it, so its
+ *                       lock isn't needed for each byte), else getc().
+ *               Span  - the whole file in memory (mapped, decompressed, or a
+ *                       caller's buffer - see oclSource.c), read by moving a
+ *                       cursor along it, plus fast paths for the usual
+ *                       all-digit fields that convert or step over a whole
+ *                       field in place.
+ *
+ *             Both give exactly the same values: digit fields are converted
+ *             with one state machine that follows what sscanf("%ld") does
+ *             with the same chars (what getIntDigits() always used), and
+ *             newlines and CRs inside a field are skipped either way.
+ *
+ *             This is included only by getOCLStationData.c - once at the top
+ *             for the shared parts, then once per policy with these defined
+ *             (and undefined again at the end):
+ *                OCL_POLICY(name)          the function name for the policy,
+ *                                          eg name##Span
+ *                OCL_POLICY_GETC(src)      next byte, or EOF
+ *                OCL_POLICY_SET_EOF(src)   peek past the end of a station,
+ *                                          to set eof if nothing's left
+ *             and optionally, for fast paths:
+ *                OCL_POLICY_DIGIT_RUN(src,numDigits,value)   true if it
+ *                                          converted an all-digit field
+ *                OCL_POLICY_SKIP_FIELD(src,bytesLeftInStation)  true if it
+ *                                          stepped over a profile value
+ *
+ * other required sources/files: ocl.h
+ *
+ * language:   ANSI C (with SSE2 intrinsics where the compiler has them)
+ */
+
+
+#ifndef OCL_SOURCE_POLICY_H
+#define OCL_SOURCE_POLICY_H
+
+#include <ctype.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* stdio policy */
+#if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE>=199506L
+#define OCL_STDIO_GETC(src) getc_unlocked((src)->fp)
+#else
+#define OCL_STDIO_GETC(src) getc((src)->fp)
+#endif
+#define OCL_STDIO_SET_EOF(src) \
+   { int c_=getc((src)->fp); if( c_!=EOF ) ungetc(c_, (src)->fp); }
+
+/* span policy */
+#define OCL_SPAN_GETC(src) ( (src)->pos<(src)->len ? \
+   (int)(unsigned char)(src)->base[(src)->pos++] : EOF )
+#define OCL_SPAN_SET_EOF(src) \
+   { if( (src)->pos>=(src)->len ) (src)->atEOF = 1; }
+
+
+
+
+/* "Span digit run" - fast path for the span policy's getIntDigits(): if the
+   numDigits (1 to 9) bytes at the cursor are all digits - by far the usual
+   case in the profile data - put their value in *value, move the cursor past
+   them and return 1.  Otherwise return 0 and leave it to the general code
+   (blanks, signs, newlines, eof).
+   With SSE2 the run is checked and converted in one 16-byte register: the
+   run is loaded right-aligned, lanes before it zeroed, and the digits summed
+   pairwise by 10, 100, 10000 with madd.  (9 digits fit in one register with
+   room to spare, so wider AVX2 registers wouldn't buy anything here.) */
+static int spanDigitRun(OCLSourceType *src, int numDigits, long int *value) {
+
+   if( numDigits<1 || numDigits>9 || src->pos+numDigits>src->len )
+      return 0;
+
+#ifdef __SSE2__
+   {
+      __m128i d, x, zero=_mm_setzero_si128();
+
+      /* (the 16-byte load ends at the run's last byte, so it has to start in
+         the span - near the front of the span just use the scalar loop) */
+      if( src->pos+numDigits >= 16 ) {
+         d = _mm_loadu_si128((const __m128i *)(src->base+src->pos+
+            numDigits-16));
+         d = _mm_sub_epi8(d, _mm_set1_epi8('0'));
+         d = _mm_and_si128(d, _mm_cmpgt_epi8(
+            _mm_setr_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15),
+            _mm_set1_epi8((char)(15-numDigits))));
+         /* any byte that wasn't '0'-'9' is now >9 unsigned */
+         if( _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(d,
+            _mm_set1_epi8(9)), zero)) != 0xFFFF )
+            return 0;
+
+         x = _mm_unpackhi_epi8(d, zero);                     /* lanes 8-15 */
+         x = _mm_madd_epi16(x, _mm_setr_epi16(10,1,10,1,10,1,10,1));
+         x = _mm_packs_epi32(x, x);
+         x = _mm_madd_epi16(x, _mm_setr_epi16(100,1,100,1,100,1,100,1));
+         x = _mm_packs_epi32(x, x);
+         x = _mm_madd_epi16(x,
+            _mm_setr_epi16(10000,1,10000,1,10000,1,10000,1));
+         *value = (long int)_mm_cvtsi128_si32(x) +
+            100000000L*(long int)(_mm_extract_epi16(d, 3) >> 8);  /* lane 7 */
+         src->pos += numDigits;
+         return 1;
+      }
+   }
+#endif
+   {
+      const char *p = src->base + src->pos;
+      long int acc=0;
+      int i;
+
+      for(i=0; i<numDigits; i++) {
+         if( !isdigit((unsigned char)p[i]) ) return 0;
+         acc = acc*10 + (p[i]-'0');
+      }
+      *value = acc;
+      src->pos += numDigits;
+      return 1;
+   }
+}
+
+
+
+
+/* "Span skip varlen float field" - fast path for the span policy's
+   skipVarlenFloatField(), for the usual case of a value that's all digits
+   and all on the current line along with its error code: steps right over
+   it.  Returns 0, having read nothing, for anything else (eg a missing value
+   or a line break in the middle), to be skipped the slow way instead. */
+static int spanSkipField(OCLSourceType *src, long int *bytesLeftInStation) {
+   const char *p = src->base + src->pos;
+   long int numBytes;
+
+   if( src->pos+3 > src->len || !isdigit((unsigned char)p[0]) ||
+       !isdigit((unsigned char)p[1]) || !isdigit((unsigned char)p[2]) )
+      return 0;
+   numBytes = 3 + (p[1]-'0') + 1;  /* counts, digits, error code */
+   if( src->pos+numBytes > src->len || memchr(p, '\n', numBytes) != NULL ||
+       memchr(p, '\r', numBytes) != NULL )
+      return 0;
+
+   src->pos += numBytes;
+   *bytesLeftInStation -= numBytes;
+   return 1;
+}
+
+#endif  /* OCL_SOURCE_POLICY_H */
+
+
+
+
+#ifdef OCL_POLICY
+
+/* "Get integer digits" - convert the next numDigits chars (not counting
+   newlines/CRs) to a long int, as sscanf("%ld") would.  Returns
+   ZERO_LENGTH_FIELD (with *value NaN) for an empty field, ie no digits or a
+   lone '-', and UNSPECIFIED_PROBLEM if the last char isn't a digit. */
+static int OCL_POLICY(getIntDigits)(OCLSourceType *src, int numDigits,
+   long int *value) {
+
+   int nextch=0, i, state=0, neg=0, status;
+   long int acc=0;
+
+#ifdef OCL_POLICY_DIGIT_RUN
+   if( OCL_POLICY_DIGIT_RUN(src, numDigits, value) ) return SUCCESSFUL;
+#endif
+
+   /* state: 0=leading blanks, 1=after sign, 2=in digits, 3=done, 4=no number
+      (this follows what sscanf("%ld") would do with the same chars) */
+   for(i=0; i<numDigits; i++) {
+      if( (nextch=OCL_POLICY_GETC(src))==EOF ) {
+         fprintf(stderr,"%%oclfilt: unexpected EOF - empty or truncated input file?\n");
+         exit(1);
+      }
+      if(nextch=='\n' || nextch=='\r') { i--; continue; } /* skip newlines */
+
+      if( state<=1 && isdigit(nextch) ) {
+         acc = nextch-'0';
+         state = 2;
+      }
+      else if( state==2 ) {
+         if( isdigit(nextch) ) acc = acc*10 + (nextch-'0');
+         else state = 3;
+      }
+      else if( state==0 ) {
+         if( nextch=='-' || nextch=='+' ) { neg = (nextch=='-'); state = 1; }
+         else if( !isspace(nextch) ) state = 4;
+      }
+      else if( state==1 ) state = 4;
+   }
+
+   /*check if at least rightmost char is a digit (the others may be spaces)*/
+   if(numDigits>0 && isdigit(nextch) ) {
+      if( state==2 || state==3 ) *value = neg ? -acc : acc;
+      status=SUCCESSFUL;
+   }
+   else if(numDigits==0 || (numDigits==1 && nextch=='-') ) {
+      *value=(long int)nan();  /* assigning NaN */
+      status=ZERO_LENGTH_FIELD;
+   }
+   else {
+      status=UNSPECIFIED_PROBLEM;
+   }
+
+   return status;
+}
+
+
+
+
+/* "Get variable-length integer field" - a digit count and then that many
+   digits.  At the start of a station (*bytesLeftInStation<0) this is the
+   station's byte count, and sets *bytesLeftInStation from it. */
+static int OCL_POLICY(getVarlenIntField)(OCLSourceType *src, long int *value,
+   long int *bytesLeftInStation) {
+
+   int status;
+   long int bytesInNextField;
+
+   status=OCL_POLICY(getIntDigits)(src,1, &bytesInNextField);
+   *bytesLeftInStation-=1;
+
+   /* note 'value' is set inside the if statement here */
+   if( OCL_POLICY(getIntDigits)(src, bytesInNextField, value) ==
+       ZERO_LENGTH_FIELD ) {
+      *value=(long int)nan();  /* assigning NaN */
+      status=ZERO_LENGTH_FIELD;
+   }
+   else {
+     /* if bytesLeftInStation not set yet (ie beginning of station), set it */
+     if(*bytesLeftInStation<0)
+        *bytesLeftInStation=*value-(long int)bytesInNextField-1;
+     /* otherwise decrement the actual number of bytesLeftInStation */
+     else *bytesLeftInStation-=(long int)bytesInNextField;
+     status=SUCCESSFUL;
+   }
+
+   return status;
+}
+
+
+
+
+/* "Get variable-length floating-point field" - significant digits, total
+   digits and precision counts, then the digits (data type is double) */
+static int OCL_POLICY(getVarlenFloatField)(OCLSourceType *src, double *value,
+   long int *bytesLeftInStation) {
+
+   int status;
+   long int sigDigits, totalDigits, precision, intvalue;
+
+
+   status = OCL_POLICY(getIntDigits)(src,1, &sigDigits);
+   *bytesLeftInStation-=1;
+
+   if (status==SUCCESSFUL) {
+      status = OCL_POLICY(getIntDigits)(src,1, &totalDigits);
+      *bytesLeftInStation-=1;
+
+      status = OCL_POLICY(getIntDigits)(src,1, &precision);
+      *bytesLeftInStation-=1;
+
+      status = OCL_POLICY(getIntDigits)(src, totalDigits, &intvalue);
+      *bytesLeftInStation-=totalDigits;
+
+      if( precision>=0 && precision<=9 )
+         *value=(double)intvalue/oclPowersOfTen[precision];
+      else *value=(double)intvalue/pow(10.,(double)precision);
+      status=SUCCESSFUL;
+   }
+
+   else if (status==ZERO_LENGTH_FIELD) {
+      *value=nan();  /* assigning NaN */
+      status=ZERO_LENGTH_FIELD;
+   }
+
+   return status;
+}
+
+
+
+
+/* "Skip bytes" - step over numBytes chars of station data (not counting
+   newlines or CRs, same as getIntDigits()) without converting them */
+static int OCL_POLICY(skipBytes)(OCLSourceType *src, long int numBytes) {
+   long int i;
+   int nextch;
+
+   for(i=0; i<numBytes; i++) {
+      if( (nextch=OCL_POLICY_GETC(src))==EOF ) {
+         fprintf(stderr,"%%oclfilt: unexpected EOF - empty or truncated input file?\n");
+         exit(1);
+      }
+      if(nextch=='\n' || nextch=='\r') i--;  /*don't inc i for newlines or CRs*/
+   }
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Skip variable-length floating-point field" - step over a profile value
+   and its error code (if it's not a missing value, which has none) without
+   converting them, keeping bytesLeftInStation up to date the same as
+   getVarlenFloatField() and the error code read would */
+static int OCL_POLICY(skipVarlenFloatField)(OCLSourceType *src,
+   long int *bytesLeftInStation) {
+
+   int status;
+   long int sigDigits, totalDigits=0, precision;
+
+#ifdef OCL_POLICY_SKIP_FIELD
+   if( OCL_POLICY_SKIP_FIELD(src, bytesLeftInStation) ) return SUCCESSFUL;
+#endif
+
+   status = OCL_POLICY(getIntDigits)(src,1, &sigDigits);
+   *bytesLeftInStation-=1;
+
+   if (status==SUCCESSFUL) {
+      OCL_POLICY(getIntDigits)(src,1, &totalDigits);
+      OCL_POLICY(getIntDigits)(src,1, &precision);
+      if( totalDigits<0 ) totalDigits=0;
+      OCL_POLICY(skipBytes)(src, totalDigits);
+      *bytesLeftInStation-=2+totalDigits;
+   }
+
+   /* then the error code, which a missing value doesn't have */
+   if (status!=ZERO_LENGTH_FIELD) {
+      OCL_POLICY(skipBytes)(src, 1);
+      *bytesLeftInStation-=1;
+   }
+
+   return status;
+}
+
+
+
+
+/* "Skip to next station" - skip over the remaining bytes left in the station
+   (which are kept track of in the conversion process) to get to next
+   station */
+static int OCL_POLICY(skipToNextStation)(OCLSourceType *src,
+   long int bytesLeftInStation) {
+
+   long int i;
+   int nextch, n;
+
+   /* if we're not done with station bytes yet, skip over those */
+   for(i=0; i<bytesLeftInStation; i++) {
+      if( (nextch=OCL_POLICY_GETC(src))==EOF ) break;
+      if(nextch=='\n' || nextch=='\r') i--; /*don't inc i for newlines or CRs*/
+   }
+
+   /* skip past blank space and newline to new station (or eof) - as
+      fgets(dummy,80,fp) would: at most 79 chars, up to and including the
+      newline */
+   for(n=0; n<79; n++)
+      if( (nextch=OCL_POLICY_GETC(src))==EOF || nextch=='\n' ) break;
+
+   /* and peek at the next char, to expose eof so the next loop stops on it */
+   OCL_POLICY_SET_EOF(src);
+
+   return SUCCESSFUL;
+}
+
+
+
+
+/* "Read profile levels" - decode levels cursor->level to endLevel-1 of
+   the profile from the source into the station's profile arrays */
+static void OCL_POLICY(readProfileLevels)(OCLProfileCursorType *cursor,
+   long int endLevel) {
+
+   OCLSourceType *src = cursor->src;
+   OCLStationType *stnData = cursor->stnData;
+   long int j, k, errCode=0;
+   int status;
+
+   /* loop over profile levels */
+   for(j=cursor->level; j<endLevel; j++) {
+
+      /* depth values */
+      if( stnData->stationType==0 /*observed level*/ ) {
+         status = OCL_POLICY(getVarlenFloatField)( src,
+            &(stnData->depthValue[j]), &(stnData->bytesLeftInStation) );
+         if( status != ZERO_LENGTH_FIELD ) {
+            OCL_POLICY(getIntDigits)( src, 1, &errCode );
+            stnData->bytesLeftInStation-=1;
+         }
+         /* (a missing value has no error code after it, so call it 0
+            rather than leave whatever the last station had there) */
+         else errCode=0;
+      }
+      else {
+         stnData->depthValue[j] = (j<numStdLevels) ? stdLevelDepth[j] :
+            nan();
+         errCode=0;
+      }
+      stnData->errCodeForDepthValue[j] = OCL_ERR_CODE(errCode);
+
+      /* the values for each varCode (temp, sal, etc) - those outside
+         the projection just get stepped over */
+      for(k=0; k<stnData->numberOfVarCodes; k++) {
+         if( !(stnData->decodedVars & OCL_VAR_BIT(k)) ) {
+            OCL_POLICY(skipVarlenFloatField)( src,
+               &(stnData->bytesLeftInStation) );
+            continue;
+         }
+         status = OCL_POLICY(getVarlenFloatField)( src,
+            &(stnData->varValue[k][j]), &(stnData->bytesLeftInStation) );
+         if( status != ZERO_LENGTH_FIELD ) {
+            OCL_POLICY(getIntDigits)( src, 1, &errCode );
+            stnData->bytesLeftInStation-=1;
+         }
+         else errCode=0;
+         stnData->errCodeForVarValue[k][j] = OCL_ERR_CODE(errCode);
+      }
+
+      setOCLLevelFlagsAt( stnData, j );
+   }
+}
+
+
+
+
+/* "Skip profile levels" - step over levels cursor->level to endLevel-1 of
+   the profile without decoding them - just their digit counts are read, to
+   know how many digits to step over */
+static void OCL_POLICY(skipProfileLevels)(OCLProfileCursorType *cursor,
+   long int endLevel) {
+
+   OCLSourceType *src = cursor->src;
+   OCLStationType *stnData = cursor->stnData;
+   long int j, k;
+
+   for(j=cursor->level; j<endLevel; j++) {
+      if( stnData->stationType==0 /*observed level*/ )
+         OCL_POLICY(skipVarlenFloatField)( src,
+            &(stnData->bytesLeftInStation) );
+      for(k=0; k<stnData->numberOfVarCodes; k++)
+         OCL_POLICY(skipVarlenFloatField)( src,
+            &(stnData->bytesLeftInStation) );
+   }
+}
+
+
+#undef OCL_POLICY
+#undef OCL_POLICY_GETC
+#undef OCL_POLICY_SET_EOF
+#undef OCL_POLICY_DIGIT_RUN
+#undef OCL_POLICY_SKIP_FIELD
+
+#endif  /* OCL_POLICY */
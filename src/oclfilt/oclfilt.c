@@ -5,21 +5,28 @@
  *
  *             ("ocl" is a data format created by the NODC Ocean Climate Lab)
  *             Assumes input files have \r's stripped (ie., UNIX not DOS text
- *             format)
+ *             format), except gzipped ones which get stripped as they're read
  * 
- * required sources/libs: getOCLStationData.c, ocl.h, Makefile;
+ * required sources/libs: getOCLStationData.c, oclSource.c, oclIndex.c,
+ *                        oclCache.c, oclGrid.c, oclBathy.c, oclArena.c,
+ *                        oclExpr.c, oclFormat.c, oclRecord.c, ocl.h, Makefile,
+ *                        ../sspcomp/sspcm2.c; zlib (-lz)
  *
  * required input files for use: NODC/OCL-formatted data as input files (I'm
  *                              using files from NODC/OCL WOD98).
  *
- *                              If using "bathy database" option, requires a
+ *                              If using "bathy database" option, requires
+ *                              either a bathy grid made with makeOCLBathy
+ *                              (see oclBathy.c), a bathy sidecar for the
+ *                              input file made with makeOCLBathySidecar, or
+ *                              a
  *                              3-column ASCII file of lat lon depth (depth
  *                              is negative in this file).  Lat-lons must
  *                              match up with lat-lons in OCL input data file.
  *                              I create mine like:
  *                                 set badPoint = ( 70, 30 )  # land location
- *                                 gunzip -c ncts1206.gz | tr -d '\r' | \
- *                                 outputAllLatsLons 1206 $badPoint | \
+ *                                 outputAllLatsLons 1206 $badPoint \
+ *                                    ncts1206.gz | \
  *                                 grdtrack -Gtopo.nind.grd >! my.bathyfile,
  *                              which extracts subsets of the Sandwell
  *                              bathymetry database (see
@@ -52,10 +59,29 @@
  *             The latter is of course what this program does (you don't get
  *             much data otherwise).
  * 
- * usage:      oclfilt [ optional params -bdefhilmnopqrstvwy]
+ * usage:      oclfilt [optional params -BbcDdefGhIijklMmnOopqrSstVvwXxy]
+ *                [infiles...]
  *             (so note that its default is to use stdin and stdout)
  *
+ *             Any number of input files can be given after the options (or
+ *             with -i), and wildcards are expanded even if quoted.  Each file
+ *             is filtered with the same options, and its output is just what
+ *             running oclfilt on that file alone would give (station numbers,
+ *             -s, -n, and -e/-q summary lines are all per file).  -I, and -d
+ *             with a lat-lon-depth file, go with one input file, so can't be
+ *             used with several.
+ *
  * where the optional parameters are:
+ *             -B
+ *                output the profile data as a binary record stream instead of
+ *                text, for a program downstream in a pipe to read without
+ *                parsing it back from text (sspcomp reads it that way).  It
+ *                has the same stations, levels and variables as the text
+ *                output, as the decoded values themselves, and each
+ *                station's record gives its variables' codes and units in
+ *                place of the title lines.  See oclRecord.c for the layout.
+ *                Can't be used with -e, -f or -q.
+ *                (default outputs text columns)
  *             -b <shallower_dlimit>,<deeper_dlimit>
  *                bottom depth filter : only output data for the stations
  *                with bottom depths between <shallower_dlimit>
@@ -66,10 +92,45 @@
  *                info, the station is reported if its deepest profile data
  *                depth is within that bottom depth range, but is flagged
  *                as such.  (default yields all stations)
+ *             -c
+ *                report the decoder's counts on stderr at the end (for each
+ *                worker with -j).  Its memory use: stations decode into an
+ *                arena that's reset between stations, and this gives its
+ *                counts of allocations and heap allocations, its peak size,
+ *                and the last station that needed a heap allocation - after
+ *                which decoding doesn't allocate any more memory (see
+ *                oclArena.c).  And its filters: -y, -m, -l, -w, -p and -v are
+ *                checked in that order as the station header is read, each
+ *                cutting a station as soon as the fields it needs are read
+ *                (-x, or -X's queries taken together, along with the last of
+ *                those its tests need), and this gives how many stations each
+ *                one checked and cut,
+ *                and the bytes of cut stations skipped over undecoded.
+ *             -D <minday>,<maxday>
+ *                specifies a range of days of the year (1-366, Jan 1 is 1)
+ *                to select data by, inclusive of both; eg. -D 152,243 is
+ *                June thru August (one day later in leap years).  If
+ *                <minday> is greater than <maxday> the range wraps around
+ *                the end of the year, eg. -D 335,59 for Dec thru Feb.
+ *                Stations with a missing month or day are not selected.
+ *                (default does not filter by day of year)
  *             -d <bathy-database filename>
  *                use the bathy values within the named lat-lon-depth file
  *                as the basis for the bottom depth filtering.  This file
  *                is generally created with shell script bathyForThisOCLfile.
+ *                Or the file can be a bathy grid made by makeOCLBathy (see
+ *                oclBathy.c), in which each station's bottom depth is
+ *                interpolated at its lat/lon - then there's no file to make
+ *                for each input file, and it goes with any number of input
+ *                files, -G, -j, -s etc.  Stations off the grid keep their
+ *                own bottom depths.
+ *                Or it can be a bathy sidecar for the input file, made by
+ *                makeOCLBathySidecar from either of those: each station's
+ *                value is read straight off it by station number, rather
+ *                than the lat-lon-depth file being read a line at a time
+ *                all thru the stations -s skips or the filters cut.  It has
+ *                to match the input file, like the station index (same
+ *                contents key and number of stations), or oclfilt quits.
  *                (default uses either the bottom depth from secndry header or
  *                from deepest profile depth if sec hdr value is missing/bad)
  *             -e
@@ -82,10 +143,51 @@
  *                input is listed.  Very lengthy and ugly; just meant for
  *                debugging or looking at example data during development.
  *                This option superceeds the formatted profile data output.
+ *             -G <gridfilename>
+ *                take the input files from a station grid made by makeOCLGrid
+ *                (see oclGrid.c), which lists the position of every station
+ *                in its files by 1 degree lat-lon cell, along with their
+ *                dates.  With -l, -y, -m and/or -D, only the stations in
+ *                cells overlapping the region and with dates in the ranges
+ *                are read, each with a single seek, and files with none
+ *                aren't opened at all.  Output is the same as giving those
+ *                files to oclfilt directly (a file changed since the grid
+ *                was made is just filtered in full, with a warning).
+ *                Can't be used with input files on the cmdline, or with -d
+ *                (but for a bathy grid), -I, -k, -n or -s.
+ *                (default reads every station of every input file)
  *             -h
  *                lists brief help/description screen
+ *             -I <indexfilename>
+ *                station index sidecar for the input file, as written by
+ *                makeOCLIndex, used by -s and -k to seek straight to the
+ *                station instead of reading through the ones before it.
+ *                An index made for some other file (or an older version of
+ *                this one) is an error - remake it with makeOCLIndex.
+ *                (default with -i is <infilename>.idx if it exists,
+ *                otherwise no index is used)
  *             -i <infilename>
- *                specifies filename of input (default uses stdin)
+ *                specifies filename of input (default uses stdin).  A gzipped
+ *                file (eg straight off the WOD98 CD) is decompressed in
+ *                memory and its \r's stripped as it's read, so there's no
+ *                need to run it thru gunzip and tr first.  And an OCL cache
+ *                file made by makeOCLCache (see oclCache.c) is read just like
+ *                the OCL file it was made from, with the same output, but
+ *                without parsing any text.
+ *             -j <numjobs>
+ *                with more than one input file, filter <numjobs> files at a
+ *                time in separate processes (0 means one per CPU).  With just
+ *                one input file, split its stations into <numjobs> ranges
+ *                instead and filter those at the same time (finding where the
+ *                stations start first, from the index sidecar or by a quick
+ *                pass over the file; not done with -n or stdin).  Either way
+ *                the output is put back together in order, the same as -j 1.
+ *                (default filters the input files one after another)
+ *             -k <oclstationnumber>
+ *                like -s, but skip to the station with the given OCL station
+ *                number (the number NODC gave it, as listed by -f).  Uses
+ *                the station index (see -I), or if there's no index file
+ *                indexes the input on the fly, so the input must be a file.
  *             -l <westbound>/<eastbound>/<southbound>/<northbound>
  *                specifies a lat-lon subregion of interest within the file to
  *                select from the rest.  bounds are in decimal degrees, using
@@ -93,15 +195,27 @@
  *                in the selected data.  Currently lon bounds don't wrap around
  *                the 0 and 360 marks, they must match the lon style of the
  *                data; this will be fixed at some point.
+ *             -M
+ *                with -i, memory-map the input file and decode the stations
+ *                straight from the mapped bytes rather than thru stdio.
+ *                Much less CPU per station; output is identical.
+ *                (default reads input thru stdio)
  *             -m <minmonth>,<maxmonth>
  *                specifies a month range to select data by; eg. -m 1,3
- *                filter is inclusive of both max and min months.
+ *                filter is inclusive of both max and min months.  If
+ *                <minmonth> is greater than <maxmonth> the range wraps
+ *                around the end of the year, eg. -m 11,2 for Nov thru Feb.
  *                (default does not filter by months - ie returns all months)
  *             -n <numberofstations>
  *                only output <numberofstations> stations:  if
  *                <numberofstations> is greater than number of stations in
  *                file, no error but of course will stop at end of file.
  *                (default does not limit number of stations in this way)
+ *             -O <outdir>
+ *                write each input file's output to its own file in directory
+ *                <outdir>, named after the input file (less any .gz), rather
+ *                than all to stdout or the -o file.
+ *                (default puts all output together)
  *             -o <outfilename>
  *                specifies filename of output (default uses stdout)
  *             -p <profilepts>
@@ -122,8 +236,23 @@
  *                in one of its vars that are in varlist.
  *                if no varlist specified, default outputs all profile levels
  *                for all vars)
+ *             -S
+ *                output sound speed profiles, computed right here from the
+ *                decoded temperatures and salinities, in place of the
+ *                profile data: the same lines oclfilt -v 1,2 | sspcomp would
+ *                give (sspcomp's default output, without its comparison or
+ *                depth binning options), ie
+ *                  lat, lon, year, month, day, time, depth, temp, sal, sndspd
+ *                using sspcm2() from ../sspcomp.  Stations without salinity
+ *                (eg XBT and MBT data) use 35ppt, sspcomp's worldwide
+ *                average, and say so in a comment line.  Only temperature
+ *                and salinity get decoded (and any -v variables), unless
+ *                -V says otherwise.  -t leaves out the title and station
+ *                lines.  Can't be used with -B, -e, -f or -q.
+ *                (default outputs the profile data itself)
  *             -s <stationnumber>
  *                skip to specified station number and start from there.
+ *                With a station index (see -I) this is a single seek.
  *                (default starts with first station in file)
  *             -t
  *                do *NOT* output title header that labels the station number, 
@@ -131,6 +260,17 @@
  *                which begin with a % character.
  *                This option only works with the usual profile data output.
  *                (default outputs that title header)
+ *             -V <var_list>
+ *                only decode and output the profile columns of the variables
+ *                in <var_list> (comma-separated variable code numbers, as
+ *                for -v), eg: -V 1,2 for just temp and sal.  The other
+ *                columns are stepped over without being converted, which
+ *                saves most of the work on stations with many variables.
+ *                It doesn't filter stations - a station with none of the
+ *                <var_list> variables still gets its depths output - so
+ *                use -v as well for that.  With -f, the columns not
+ *                decoded show as "--".
+ *                (default decodes and outputs all of a station's columns)
  *             -v <var_list>
  *                variables filter : only output profile data for variables
  *                included in <var_list>.  And if any variables in <var_list>
@@ -147,6 +287,39 @@
  *                generally parsed out of the OCL filenames...
  *                (default outputs station even if there are invalid zero
  *                values for lat & lon)
+ *             -x <expr>
+ *                filter expression: only output stations whose headers
+ *                satisfy <expr>, which combines tests with and, or, not and
+ *                parentheses (quote it for the shell), eg
+ *                  -x "(region 115/125/35/45 or region 130/140/30/40)
+ *                      and month 12,2 and year 1980, and vars 1,2"
+ *                for two regions' Dec-Feb stations since 1980 with temp and
+ *                sal, in one pass.  The tests are year, month, day (of year),
+ *                and levels (number of profile levels), each with a range
+ *                lo,hi (or one value, or lo, or ,hi for an open end; month
+ *                and day ranges can wrap the new year); region w/e/s/n as for
+ *                -l; and vars, country and cruise, each with a list of codes
+ *                separated by commas (vars as for -v, but without -v's
+ *                dropping of flagged levels).  &, | and ! can stand for
+ *                and, or and not.  It's checked along with the other
+ *                filters, which must pass too.  (see oclExpr.c)
+ *                (default doesn't filter by expression)
+ *             -X <queryfilename>
+ *                batch mode: filter for many queries in one pass, each with
+ *                its own output file.  Each line of <queryfilename> is an
+ *                output filename and then a filter expression as for -x, eg
+ *                  npac.out  region 115/125/35/45 and month 12,2
+ *                  natl.out  region -60/0/20/60 and month 6,8
+ *                (lines starting with % are comments).  Each station is read
+ *                and decoded just once, cut if it satisfies none of the
+ *                expressions, and otherwise written to the output file of
+ *                every query it satisfies, so the cost of reading the input
+ *                is paid once however many subsets come out of it.  The
+ *                other options apply to all the queries, and each output
+ *                file gets just what oclfilt -x with its expression would
+ *                output (-n and the -e/-q summary are per query).  Can't be
+ *                used with -G, -j, -O, -o or -x.
+ *                (default is the one output, filtered by -x if given)
  *             -y <minyear>,<maxyear>
  *                specifies a year range to select data by; eg. -y 1976,1980
  *                filter is inclusive of both max and min years.
@@ -171,113 +344,479 @@
  *                related default of not outputing profile levels that have
  *                errors in individual data within the columns specified by -v
  *     2/23/00-AG-added -p, -l, -m, & -y flags (see above for description)
+ *    10/16/26-agent-added -M flag to decode from a memory-mapped input file
+ *            -added -I & -k flags, station index sidecars for -s and -k
+ *            -read gzipped input files directly with -i
+ *            -take a list of input files, filtered in parallel with -j
+ *                and output in order or per file with -O
+ *            -with -j and one input file, split its stations among workers
+ *            -read OCL cache files made by makeOCLCache as input
+ *            -added -G, a station grid over many files for -l queries
+ *            -added -D, -m ranges that wrap the new year, and dates in the
+ *                -G grid for -y/-m/-D queries
+ *            -profiles sized to each station, so no more MAX_LEVELS limit
+ *            -profile error codes kept as bytes, with per-level bitmasks of
+ *                flagged/missing values for the -v good-data check
+ *            -stations decoded into an arena that's reset between stations,
+ *                with -c to report its allocation counts
+ *            -with -q, profiles skipped over but for the deepest level
+ *            -added -V, to decode and output only some variables' columns
+ *            -filters checked as the header's read, cutting stations early,
+ *                with -c counting the stations each one cut
+ *            -added -x, filter expressions with and/or/not of several regions,
+ *                date ranges, variables, countries and cruises
+ *            -added -X, a batch of -x queries filtered in one pass, each
+ *                into its own output file
+ *            -output lines put together with fast number formatting (same
+ *                output as printf, see oclFormat.c), and written out thru
+ *                big buffers
+ *            -added -B, binary record stream output for sspcomp etc
+ *            -added -S, sound speeds computed in-process as sspcomp does
+ *            -d takes a bathy grid from makeOCLBathy, looked up by position
+ *            -d takes a bathy sidecar from makeOCLBathySidecar, looked up by
+ *                station number
  */
 
 
+#define _POSIX_C_SOURCE 200112L  /* for fork(), glob() etc with -ansi */
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <glob.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include "ocl.h"
 
 
 
 int main (int argc, char **argv) {
 
-   /* these vars are set according to cmdline params, but defaults are here */
-   int botDepthFiltFlag=0, debugFlag=0, endStatsFlag=0, numStnsFlag=0;
-   int queryFlag=0, skipFlag=0, titlesFlag=1, varListFlag=0;
-   int databaseBathyFlag=0, zeroLatLonFlag=0;
-   char dbBathyFilename[256], wmoSquare[5];
-   int latlonRegionFlag=0, yearRangeFlag=0, monthRangeFlag=0, minLevelsFlag=0;
-   double latlonRegion[4];
-   long int yearRange[2], monthRange[2];
-   long int minLevels;
-   int wantProfileFlag, outputThisStation;
-   int includeErrorFlaggedData=0;
-   long int numVarsOnVarList=0, varList[MAX_VARS];
-   long int stnToSkipTo, numStnsToOutput;
-   double shallowerDLimit, deeperDLimit;
-   FILE *fp_in, *fp_out, *fp_dbBathy=NULL;
- 
-   /* other vars for just internal bookeeping in main() */
-   long int i, j, k, l, totalStationBytes=0, numLevelsWithErrorFlags=0;
-   long int stationOutputCount=0, totalStationOutputBytes=0;
-   char vars[150], botDepthStr[10], tmp[10];
-   int status, errorFlaggedDataExists=0;
- 
-   OCLStationType stnData;  /* (one station's worth of data in a big struct) */
+   OCLFiltOptionsType opt;  /* cmdline settings, shared by all input files */
+   FILE *fp_out;
+   long int f, q;
+   int status=SUCCESSFUL;
+
 
- 
- 
    /* Get values from the command line: */
-   if( parse_commandline( argc, argv, &fp_in, &fp_out, 
-      &botDepthFiltFlag, &shallowerDLimit, &deeperDLimit,
-      &varListFlag, &numVarsOnVarList, varList,
-      &debugFlag, &endStatsFlag, &titlesFlag, &queryFlag,
-      &databaseBathyFlag, dbBathyFilename,
-      &numStnsFlag, &numStnsToOutput,
-      &skipFlag, &stnToSkipTo,
-      &zeroLatLonFlag, wmoSquare,
-      &minLevelsFlag, &minLevels,
-      &latlonRegionFlag, latlonRegion,
-      &yearRangeFlag, yearRange, &monthRangeFlag, monthRange,
-      &includeErrorFlaggedData) != SUCCESSFUL )
+   if( parse_commandline( argc, argv, &opt ) != SUCCESSFUL ) exit(1);
+
+
+   /* With -G, the input files are the ones in the grid, and from each one
+      just the stations the grid finds in the -l region get read */
+   if( opt.gridFlag && loadOCLFiltGrid( &opt ) != SUCCESSFUL ) exit(1);
+
+   /* A -d bathy grid (or sidecar) is mapped once, for every input file (and
+      -j worker) to look its stations' depths up in */
+   if( opt.bathyKind &&
+       mapOCLBathy( opt.dbBathyFilename, &(opt.bathy) ) != SUCCESSFUL )
       exit(1);
 
-      /* Note above that by sending the _addresses_ of the filepointers I made
-      it so I can get the filepointers returned to main after they're set in
-      the function - that's the reason for the 'FILE **' declarations within
-      the parse_commandline function itself, rather than just 'FILE *'. */
 
+   /* assign stdout or open file depending on args */
+   if( opt.outFileFlag ) {
+      if ((fp_out = fopen(opt.outFilename,"w")) == NULL) {
+         fprintf(stderr, "Unable to open file %s.\n", opt.outFilename);
+         exit(1);
+      }
+   }
+   else {
+      fp_out = stdout;
+   }
+   setOCLOutputBuffer( fp_out );  /* (see oclFormat.c) */
 
-   /* If databaseBathy specified on cmdline, then open the bathy file */
-   if( databaseBathyFlag ) {
-      if ((fp_dbBathy = fopen(dbBathyFilename,"r")) == NULL) {
-         fprintf(stderr, "Unable to open bathy file %s.\n", dbBathyFilename);
+   /* -S's column titles go at the top of each output file, just the once
+      (as sspcomp would put them) however many input files go into it */
+   if( !opt.batchFlag && !opt.outDirFlag )
+      outputSoundSpeedHeader( &opt, fp_out );
+
+   /* with -X, each query has its own output file instead */
+   for(q=0; opt.batchFlag && q<opt.numQueries; q++) {
+      if ((opt.query[q].fp_out = fopen(opt.query[q].outFilename,"w"))==NULL) {
+         fprintf(stderr, "Unable to open file %s.\n", opt.query[q].outFilename);
          exit(1);
       }
+      setOCLOutputBuffer( opt.query[q].fp_out );
+      outputSoundSpeedHeader( &opt, opt.query[q].fp_out );
    }
 
- 
-   /* Set flag - we'll want the profile data if we specified the query or
-      formatted output mode (not endStats), or if we're in "spew-everything"
-      full output (ie debug) mode */
-   wantProfileFlag = !endStatsFlag || debugFlag;
+
+   /* Filter stdin, or each of the input files - in order, or spread over
+      worker processes with the output still put back in input file order */
+   if( opt.numInFiles==0 && !opt.gridFlag )
+      status = filterOCLFile( &opt, NULL, fp_out );
+   else if( opt.numJobs>1 && opt.numInFiles>1 )
+      status = runOCLFiltJobs( &opt, fp_out );
+   else {
+      for(f=0; f<opt.numInFiles; f++)
+         if( filterOCLInput( &opt, f, fp_out ) != SUCCESSFUL )
+            status=UNSPECIFIED_PROBLEM;
+   }
+
+   if( fclose(fp_out) != 0 ) status=UNSPECIFIED_PROBLEM;
+   for(q=0; opt.batchFlag && q<opt.numQueries; q++)
+      if( fclose(opt.query[q].fp_out) != 0 ) status=UNSPECIFIED_PROBLEM;
+   if( opt.batchFlag ) {
+      free(opt.query);
+      free(opt.queryExpr);
+      free(opt.queryMatches);
+   }
+   if( opt.bathyKind ) closeOCLBathy( &(opt.bathy) );
+
+   /* (with -j, the workers each report their own) */
+   if( opt.arenaStatsFlag && opt.arena.numResets>0 ) {
+      reportOCLArena( &(opt.arena), stderr, "oclfilt" );
+      reportOCLFilterCounts( &(opt.filterCounts), stderr, "oclfilt" );
+   }
+
+   return status;
+
+
+} /* end of main() */
+
+
+
+
+
+
+
+
+/* "Filter OCL file" - the guts of oclfilt: read each station of one input
+   file (or stdin if infilename is NULL), filter it as per the cmdline
+   settings in opt, and write out the stations that pass to fp_out.  Each
+   input file gets exactly the output that running oclfilt on it alone
+   would give, summary lines and all. */
+int filterOCLFile(OCLFiltOptionsType *opt, char *infilename, FILE *fp_out) {
+
+   int skipFlag=opt->skipFlag;    /* (-k sets these per file, so copies) */
+   long int stnToSkipTo=opt->stnToSkipTo;
+   char indexFilename[256];
+   FILE *fp_in=NULL, *fp_dbBathy=NULL;
+   OCLSourceType src;  /* where station bytes come from: fp_in, mapped file,
+                          or an OCL cache file */
+
+   /* other vars for just internal bookeeping */
+   long int i, q, firstStn=0, numIndexedStations=-1;
+   int status, haveIndex=0, splitFlag;
+   long int ld_dummy;
+   double lf_dummy;
+   OCLIndexType idx;
+   OCLFiltStatsType stats;
+
+
+   /* assign stdin or open (or map, or decompress) file depending on args */
+   if( openOCLInput(opt, infilename, &src, &fp_in) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+
+   /* default station index is the sidecar next to the input file */
+   if( strcmp(opt->indexFilename,"") ) strcpy(indexFilename,opt->indexFilename);
+   else if( infilename!=NULL ) sprintf(indexFilename,"%.251s.idx",infilename);
+   else strcpy(indexFilename,"");
+
+
+   /* If databaseBathy specified on cmdline, then open the bathy file (unless
+      it's a bathy grid or sidecar, which main() has mapped) */
+   if( opt->databaseBathyFlag && !opt->bathyKind ) {
+      if ((fp_dbBathy = fopen(opt->dbBathyFilename,"r")) == NULL) {
+         fprintf(stderr, "Unable to open bathy file %s.\n",
+            opt->dbBathyFilename);
+         exit(1);
+      }
+   }
+
+
+   /* With -j and just the one input file, split the file's stations among
+      the workers - for which we need the station index.  (Not with -n, as
+      we'd only know where to stop after the fact.) */
+   splitFlag = opt->numJobs>1 && opt->numInFiles==1 && !opt->numStnsFlag &&
+      tellOCLSource(&src)>=0;
+
+
+   /* If skipping ahead (-s or -k), seek straight to the station using the
+      input's station index, if there is one - which has to be this input
+      file's, not a stale one or another file's. */
+   if( skipFlag || opt->oclStnFlag || splitFlag ) {
+      if( strcmp(indexFilename,"") &&
+          readOCLIndex(indexFilename, &idx) == SUCCESSFUL ) {
+         if( matchOCLIndex(&src, &idx) != SUCCESSFUL ) {
+            fprintf(stderr, "oclfilt: index %s doesn't match input file (remake"
+               " it with makeOCLIndex).\n", indexFilename);
+            exit(1);
+         }
+         haveIndex=1;
+      }
+      /* no index file, so index the input now (needs a seekable file) */
+      if( (opt->oclStnFlag || splitFlag) && !haveIndex ) {
+         if( tellOCLSource(&src)<0 ||
+             buildOCLIndex(&src, &idx) != SUCCESSFUL ) {
+            fprintf(stderr, "oclfilt: -k needs a station index or an input"
+               " file that can be seeked.\n");
+            exit(1);
+         }
+         haveIndex=1;
+      }
+      if( opt->oclStnFlag ) {
+         stnToSkipTo = findOCLIndexStation(&idx, opt->oclStnToSkipTo);
+         if( stnToSkipTo<0 ) {
+            fprintf(stderr, "%% oclfilt: no station with OCL station number"
+               " %ld in input.\n", opt->oclStnToSkipTo);
+            stnToSkipTo = idx.numStations;
+         }
+         skipFlag=1;
+      }
+      if( haveIndex ) {
+         if( !skipFlag ) stnToSkipTo = 0;
+         if( stnToSkipTo > idx.numStations ) stnToSkipTo = idx.numStations;
+         /* (src may be at the end from indexing it, hence the 2nd case) */
+         if( stnToSkipTo > 0 || tellOCLSource(&src) != 0 ) {
+            if( seekOCLStation(&src, &idx, stnToSkipTo) != SUCCESSFUL ) {
+               fprintf(stderr, "oclfilt: index %s doesn't match input file"
+                  " (remake it with makeOCLIndex).\n", indexFilename);
+               exit(1);
+            }
+            firstStn = stnToSkipTo;
+            /* bathy file has a line per station, so skip those too */
+            for(i=0; fp_dbBathy!=NULL && i<firstStn; i++)
+               fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
+                  &ld_dummy, &lf_dummy );
+         }
+         numIndexedStations = idx.numStations;
+         if( !splitFlag ) freeOCLIndex(&idx);
+      }
+   }
+
+
+   /* A bathy sidecar only goes with the file it was made for, like the
+      station index - same key, same number of stations (from the index if
+      we've read one, else counted) */
+   if( opt->bathyKind==OCL_BATHY_SIDECAR &&
+       matchOCLBathySidecar(&(opt->bathy), &src, numIndexedStations)
+          != SUCCESSFUL ) {
+      fprintf(stderr, "oclfilt: bathy sidecar %s doesn't match input file"
+         " (remake it with makeOCLBathySidecar).\n", opt->dbBathyFilename);
+      exit(1);
+   }
 
 
    /* Need to output file header before loop if using query mode (& want hdr)*/
-   if(queryFlag && titlesFlag) {
+   if( opt->batchFlag )
+      for(q=0; q<opt->numQueries; q++)
+         outputQueryHeader( opt, opt->query[q].fp_out );
+   else outputQueryHeader( opt, fp_out );
+
+
+   /* filter the stations - straight through, or with -j split up among
+      worker processes */
+   if( splitFlag )
+      status = runOCLFiltStationJobs( opt, infilename, &src, &idx, firstStn,
+         skipFlag, stnToSkipTo, fp_out, &stats );
+   else
+      status = filterOCLStations( opt, &src, fp_dbBathy, firstStn, -1,
+         skipFlag, stnToSkipTo, fp_out, &stats );
+   if( splitFlag ) freeOCLIndex(&idx);
+
+
+   /* Output the final statistics if needed (with -X, each query's own) */
+   if( status==SUCCESSFUL && opt->batchFlag )
+      for(q=0; q<opt->numQueries; q++)
+         outputSummary( opt, &(opt->query[q].stats), opt->query[q].fp_out );
+   else if( status==SUCCESSFUL ) outputSummary( opt, &stats, fp_out );
+
+   closeOCLSource(&src);
+   if( fp_in!=NULL && fp_in!=stdin ) fclose(fp_in);
+   if( fp_dbBathy!=NULL ) fclose(fp_dbBathy);
+
+   return status;
+
+
+} /* end of filterOCLFile() */
+
+
+
+
+
+
+/* "Open OCL input" - set up src to read the input file (or stdin if
+   infilename is NULL): thru stdio, or for a gzipped file decompressed into
+   memory, for an OCL cache file mapped, or with -M mapped.  *fp_in is set to
+   the stdio stream if there is one (for the caller to close), else NULL. */
+int openOCLInput(OCLFiltOptionsType *opt, char *infilename,
+   OCLSourceType *src, FILE **fp_in) {
+
+   *fp_in = NULL;
+
+   if( infilename==NULL ) {
+      *fp_in = stdin;
+      setOCLSourceFile(src, *fp_in);
+   }
+   else if( isGzipFile(infilename) ) {
+      if( loadOCLGzSource(src, infilename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else if( isOCLCacheFile(infilename) ) {
+      if( openOCLCache(src, infilename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else if( opt->mapInputFlag ) {
+      if( mapOCLSource(src, infilename) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+   }
+   else {
+      if ((*fp_in = fopen(infilename,"r")) == NULL) {
+         fprintf(stderr, "Unable to open file %s.\n", infilename);
+         return UNSPECIFIED_PROBLEM;
+      }
+      setOCLSourceFile(src, *fp_in);
+   }
+
+   return SUCCESSFUL;
+}
+
+
+
+
+
+
+/* "Output query header" - column titles for -q output (unless -t), or with
+   -B the record stream's header */
+void outputQueryHeader(OCLFiltOptionsType *opt, FILE *fp_out) {
+   if( opt->recordFlag )
+      writeOCLRecordHeader( fp_out, opt->titlesFlag ? OCL_RECORD_TITLES : 0 );
+   if(opt->queryFlag && opt->titlesFlag) {
       fprintf(fp_out, "%%  stn year mo dy  time       lat       lon   bytes "
          "numlvls botdepth  vars\n");
       fprintf(fp_out, "%%----- ---- -- -- ----- --------- --------- ------- "
          "------- --------  ----------\n");
    }
+}
+
+
+
+
+
+
+
+/* "Output summary" - the -e/-q summary line for an input file */
+void outputSummary(OCLFiltOptionsType *opt, OCLFiltStatsType *stats,
+   FILE *fp_out) {
+   if( opt->endStatsFlag || opt->queryFlag ) {
+      fprintf(fp_out,"%% summary value units: #Stns / total#Stns, Bytes / totalBytes\n");
+      fprintf(fp_out,"%% summary:  %ld / %ld , %ld / %ld\n",
+              stats->stationOutputCount, stats->endStn,
+              stats->totalStationOutputBytes, stats->totalStationBytes);
+   }
+}
+
+
+
+
+
+
+
+
+/* "Filter OCL stations" - the guts of oclfilt: read stations firstStn on
+   from src (up to but not including endStn, or to the end if endStn<0),
+   filter each one as per the cmdline settings in opt, and write out the
+   stations that pass to fp_out.  The counts for the -e/-q summary are
+   returned in stats. */
+int filterOCLStations(OCLFiltOptionsType *opt, OCLSourceType *src,
+   FILE *fp_dbBathy, long int firstStn, long int endStn,
+   int skipFlag, long int stnToSkipTo, FILE *fp_out, OCLFiltStatsType *stats) {
+
+   int wantProfileFlag, outputThisStation;
+   long int i, k, l, q;
+   int status;
+   long int numDecodeVars=0, decodeVars[2*MAX_VARS];
+
+   static OCLStationType stnData;  /* (one station's worth of data, its
+                                      variable-length parts in opt->arena) */
+
+
+   stats->stationOutputCount = 0;
+   stats->totalStationOutputBytes = 0;
+   stats->totalStationBytes = 0;
+   for(q=0; opt->batchFlag && q<opt->numQueries; q++) {
+      opt->query[q].stats.stationOutputCount = 0;
+      opt->query[q].stats.totalStationOutputBytes = 0;
+      opt->query[q].stats.totalStationBytes = 0;
+      opt->query[q].done = 0;
+   }
+
+
+   /* Set flag - we'll want the profile data if we specified the query or
+      formatted output mode (not endStats), or if we're in "spew-everything"
+      full output (ie debug) mode.  Query mode only uses the profile for
+      its deepest depth, so all but that level get skipped over. */
+   wantProfileFlag = !opt->endStatsFlag || opt->debugFlag;
+   if( wantProfileFlag && opt->queryFlag && !opt->debugFlag )
+      wantProfileFlag = OCL_PROFILE_LAST_LEVEL;
+
+   stnData.arena = &(opt->arena);
+   stnData.filterCounts = &(opt->filterCounts);
+   stnData.bathy = opt->bathyKind ? &(opt->bathy) : NULL;
+   /* -x's expression - or -X's queries' all at once, for a station to pass
+      if it satisfies any of them, and with which ones it does set in
+      opt->queryMatches[] */
+   if( opt->batchFlag ) {
+      stnData.filterExpr = opt->queryExpr;
+      stnData.numFilterExprs = opt->numQueries;
+      stnData.filterExprMatches = opt->queryMatches;
+   }
+   else if( opt->exprFlag ) {
+      stnData.filterExpr = &(opt->expr);
+      stnData.numFilterExprs = 1;
+   }
+
+   /* With -V, only the -V variables' columns need decoding - plus any -v
+      ones, since their error codes decide which levels get output.  And
+      -S only needs temperature and salinity (and the -v ones). */
+   if( opt->projectionFlag ) {
+      for(l=0; l<opt->numProjectionVars; l++)
+         decodeVars[numDecodeVars++] = opt->projectionVars[l];
+   }
+   else if( opt->soundSpeedFlag ) {
+      decodeVars[numDecodeVars++] = 1;
+      decodeVars[numDecodeVars++] = 2;
+   }
+   if( opt->projectionFlag || opt->soundSpeedFlag ) {
+      for(l=0; opt->varListFlag && l<opt->numVarsOnVarList; l++) {
+         for(k=0; k<numDecodeVars; k++)
+            if( decodeVars[k]==opt->varList[l] ) break;
+         if( k==numDecodeVars ) decodeVars[numDecodeVars++] = opt->varList[l];
+      }
+   }
+   stnData.numProjectionVars = numDecodeVars;
+   stnData.projectionVars = decodeVars;
 
 
    /* loop over stations in this file */
-   for (i=0; !feof(fp_in); i++) {
+   for (i=firstStn; !endOfOCLSource(src) && (endStn<0 || i<endStn); i++) {
 
-     numLevelsWithErrorFlags=0; /* resetting for new profile */
+      resetOCLArena( &(opt->arena) );  /* (letting go of the last one) */
 
       /* read in one station of data */
-      status = getOCLStationData( fp_in, i, &stnData, wantProfileFlag,
-         skipFlag, stnToSkipTo, varListFlag, varList, numVarsOnVarList, 
-         minLevelsFlag, minLevels, latlonRegionFlag, latlonRegion,
-         yearRangeFlag, yearRange, monthRangeFlag, monthRange,
-         databaseBathyFlag, fp_dbBathy, zeroLatLonFlag, wmoSquare );
+      status = getOCLStationDataSrc( src, i, &stnData, wantProfileFlag,
+         skipFlag, stnToSkipTo, opt->varListFlag, opt->varList,
+         opt->numVarsOnVarList, opt->minLevelsFlag, opt->minLevels,
+         opt->latlonRegionFlag, opt->latlonRegion,
+         opt->yearRangeFlag, opt->yearRange,
+         opt->monthRangeFlag, opt->monthRange,
+         opt->databaseBathyFlag, fp_dbBathy, opt->zeroLatLonFlag,
+         opt->wmoSquare );
       if( status==SKIPPED ) continue;    /* skip to next i loop (station) */
       else if( status!=SUCCESSFUL ) {
-         fprintf(stderr, 
+         fprintf(stderr,
             "oclfilt: error: failure in getOCLStationData at stn#%ld.\n",i);
          exit(1);
       }
 
- 
+
       /* keep track of this to compare with totalStationOutputBytes later */
-      totalStationBytes += stnData.bytesInStation;
+      stats->totalStationBytes += stnData.bytesInStation;
+
 
- 
       /* Setting up output conditional :
          We want to output/count the data from this station UNLESS -
          1.) a bottomDepth filter was specified and this station was cut by it
@@ -290,151 +829,903 @@ int main (int argc, char **argv) {
          5.) yearRange was specified and this station was cut by it
          6.) monthRange was specified and this station was cut by it
          7.) minLevels was specified and this station was cut by it
+         8.) dayRange was specified and this station's day of year isn't
+             in it
+         9.) a filter expression was specified and this station doesn't
+             satisfy it (with -X, none of the queries' expressions)
          (sorry about using the convoluted "if" statement below, rather than
          logical ops, but it protects against referencing a null pointer...)
       */
       outputThisStation=0;
-      if( botDepthFiltFlag && stnData.bottomDepthPtr!=NULL ) {
-         if( *(stnData.bottomDepthPtr)>=shallowerDLimit &&
-             *(stnData.bottomDepthPtr)<=deeperDLimit ) outputThisStation=1;
+      if( opt->botDepthFiltFlag && stnData.bottomDepthPtr!=NULL ) {
+         if( *(stnData.bottomDepthPtr)>=opt->shallowerDLimit &&
+             *(stnData.bottomDepthPtr)<=opt->deeperDLimit ) outputThisStation=1;
          else outputThisStation=0;
-      }       
+      }
       else outputThisStation=1;
       /* Note below that the *= acts as an appending "and" operator */
-      outputThisStation*=( !varListFlag || stnData.varListChecksOut );
-      outputThisStation*=( !zeroLatLonFlag || !(stnData.badLatLon) );
-      outputThisStation*=( !latlonRegionFlag || stnData.latlonInRange );
-      outputThisStation*=( !yearRangeFlag || stnData.yearInRange );
-      outputThisStation*=( !monthRangeFlag || stnData.monthInRange );
-      outputThisStation*=( !minLevelsFlag || stnData.enoughProfileLevels );
+      outputThisStation*=( !opt->varListFlag || stnData.varListChecksOut );
+      outputThisStation*=( !opt->zeroLatLonFlag || !(stnData.badLatLon) );
+      outputThisStation*=( !opt->latlonRegionFlag || stnData.latlonInRange );
+      outputThisStation*=( !opt->yearRangeFlag || stnData.yearInRange );
+      outputThisStation*=( !opt->monthRangeFlag || stnData.monthInRange );
+      outputThisStation*=( !opt->minLevelsFlag || stnData.enoughProfileLevels);
+      outputThisStation*=( !(opt->exprFlag || opt->batchFlag) ||
+         stnData.exprPasses );
+      outputThisStation*=( !opt->dayRangeFlag || inOCLCyclicRange(
+         oclDayOfYear(stnData.year, stnData.month, stnData.day),
+         opt->dayRange) );
+
+
+
+      /* With -X, each query the station satisfies gets it (see
+         routeOCLStation()), and when they've all had their -n stations
+         there's no more to do */
+      if( opt->batchFlag ) {
+         if( routeOCLStation( opt, i, &stnData, outputThisStation ) ) break;
+         continue;
+      }
 
 
-  
       /* If we're going to output the station... */
       if( outputThisStation ) {
 
          /* need to keep track of these for stats later */
-         stationOutputCount++;
-         totalStationOutputBytes += stnData.bytesInStation;
-
-
-         /* full debugging (lengthy & sloppy) output */
-         if( debugFlag )
-            outputAllStationData( fp_out, i, &stnData );
-
-
-         /* Query output - one line summary from station's header */
-         else if( queryFlag ) {
-
-            /* set up depth string output */
-            if(stnData.bottomDepthPtr!=NULL)
-              sprintf(botDepthStr, "%6.1f %c", *(stnData.bottomDepthPtr),
-                      stnData.bottomDepthSource);
-            else
-              sprintf(botDepthStr, "   --  -");
-        
-            /* set up variables string output */
-            strcpy(vars,"");
-            for(j=0; j<stnData.numberOfVarCodes; j++) {
-              sprintf(tmp,"%ld",stnData.varCode[j]);
-              strcat(vars, tmp);
-              if(stnData.errCodeForVarCode[j]>0) strcat(vars, "*");
-              if(j<stnData.numberOfVarCodes-1) strcat(vars, ",");
-            }
-            if(!strcmp(vars,"")) strcpy(vars,"  --  ");
-        
-            fprintf(fp_out,
-               "%6ld %4ld %2ld %2ld %5.2f %9.4f %9.4f %7ld %7ld %8s  %-9s\n",
-               i, stnData.year, stnData.month, stnData.day, stnData.time,
-               stnData.lat, stnData.lon, stnData.bytesInStation,
-               stnData.numberOfLevels, botDepthStr, vars );
-         }
-   
-
-         /* Not doing the endStats (or one of the above possibilities) means
-            we want the regular formatted output of the profile data. */
-         else if( !endStatsFlag ) {
-            /* Output title header first if needed */
-            if( titlesFlag ) {
-               if(stnData.bottomDepthPtr!=NULL)
-                  sprintf(botDepthStr,"%.2f m", *(stnData.bottomDepthPtr));
-               else strcpy(botDepthStr,"[no data]");
-               fprintf(fp_out, "%%\n%%Station #%ld, bottom depth %9s (from %c),"
-                  "  %s level data\n",i, botDepthStr, stnData.bottomDepthSource,
-                  (stnData.stationType==0) ? "observed" : "standard" );
-               fprintf(fp_out, "%%Columns: Lat, Lon, Year, Month, Day, Time, "
-                  "Depth");
-               for(j=0; j<stnData.numberOfVarCodes; j++)
-                  fprintf(fp_out, ", %s", varCodeLabel(stnData.varCode[j]));
-               fprintf(fp_out, "\n");
-               fprintf(fp_out, "%%Units:   deg, deg, yyyy, mm, dd, hrs, m");
-               for(j=0; j<stnData.numberOfVarCodes; j++)
-                  fprintf(fp_out, ", %s", varCodeUnits(stnData.varCode[j]));
-               fprintf(fp_out, "\n");
-            }
-            /* Now output the profile data itself */
-            for(j=0; j<stnData.numberOfLevels; j++) { /* loop over prof lvls */
-
- 	       /* Conditionals to find whether 'errorFlaggedDataExists' on
-		  this profile level, in any of the variables specified as
-		  required for this profile (ie in varList) : */
- 	       if( varListFlag ) {
-		  errorFlaggedDataExists=0;
-		  for(k=0; k<stnData.numberOfVarCodes; k++) {
- 		     for(l=0; l<numVarsOnVarList; l++) {
-		        if( varList[l]==stnData.varCode[k] )
-			  if( stnData.errCodeForVarValue[k][j]!=0 /*bad data*/
-			      || 
-			      !(stnData.varValue[k][j]>0 ||
-			        stnData.varValue[k][j]<=0) /*=NaN,ie missing*/)
-			      errorFlaggedDataExists=1;
-		     }
-		  }
-	       }
-
-	       /* print out one line = one profile level of output */
- 	       if( !errorFlaggedDataExists || includeErrorFlaggedData ) {
-		 fprintf(fp_out, "%.4f  %.4f  %4ld %2ld %2ld %.2f  %.2f",
-			 stnData.lat, stnData.lon, stnData.year, stnData.month,
-			 stnData.day, stnData.time, stnData.depthValue[j] );
-		 /* if we want to include error codes in output, append this */
-		 if( includeErrorFlaggedData )
-		    fprintf(fp_out, " (%ld)", stnData.errCodeForDepthValue[j]);
-		 for(k=0; k<stnData.numberOfVarCodes; k++) {
-		    fprintf(fp_out, "  %.3f", stnData.varValue[k][j]);
-		    /* if we want to include error codes in output, append: */
-		    if( includeErrorFlaggedData ) fprintf(fp_out, " (%ld)",
-		       stnData.errCodeForVarValue[k][j]);
-		 }
-		 fprintf(fp_out, "\n");
-	       }
-	       if( errorFlaggedDataExists ) numLevelsWithErrorFlags++;
-            }
-         }
+         stats->stationOutputCount++;
+         stats->totalStationOutputBytes += stnData.bytesInStation;
+
+         outputOCLStation( opt, i, &stnData, fp_out );
       }
- 
- 
+
+
       /* if there was only a specified number of stations we were to output,
          and we've reached that number, break out of station loop to end of
          the program. */
-      if( numStnsFlag && stationOutputCount>=numStnsToOutput ) break;
- 
+      if( opt->numStnsFlag && stats->stationOutputCount>=opt->numStnsToOutput )
+         break;
+
    }  /* end of stations loop (i) */
- 
- 
-   /* Output the final statistics if needed */
-   if( endStatsFlag || queryFlag ) {
-      fprintf(fp_out,"%% summary value units: #Stns / total#Stns, Bytes / totalBytes\n");
-      fprintf(fp_out,"%% summary:  %ld / %ld , %ld / %ld\n", stationOutputCount,
-              i, totalStationOutputBytes, totalStationBytes);
+
+   stats->endStn = i;
+   for(q=0; opt->batchFlag && q<opt->numQueries; q++)
+      if( !opt->query[q].done ) opt->query[q].stats.endStn = i;
+
+   return SUCCESSFUL;
+
+
+} /* end of filterOCLStations() */
+
+
+
+
+
+
+
+
+/* "Output OCL station" - write station #i, which has passed the filters, to
+   fp_out in the form opt asks for: the -f full listing, the -q one-line
+   summary, or the profile data (or nothing at all for -e) */
+void outputOCLStation(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, FILE *fp_out) {
+
+   long int j, k, l;
+   char vars[150], botDepthStr[10], tmp[10];
+   char line[OCL_MAX_OUTPUT_LINE], *p;  /* (see oclFormat.c) */
+   int errorFlaggedDataExists=0;
+   unsigned int varListFlags;  /* (OCL_VAR_BIT()s, see levelFlags in ocl.h) */
+   unsigned int outputVars;
+
+
+   /* full debugging (lengthy & sloppy) output */
+   if( opt->debugFlag )
+      outputAllStationData( fp_out, i, stnData );
+
+
+   /* Query output - one line summary from station's header */
+   else if( opt->queryFlag ) {
+
+      /* set up depth string output */
+      if(stnData->bottomDepthPtr!=NULL)
+        sprintf(botDepthStr, "%6.1f %c", *(stnData->bottomDepthPtr),
+                stnData->bottomDepthSource);
+      else
+        sprintf(botDepthStr, "   --  -");
+
+      /* set up variables string output */
+      strcpy(vars,"");
+      for(j=0; j<stnData->numberOfVarCodes; j++) {
+        sprintf(tmp,"%ld",stnData->varCode[j]);
+        strcat(vars, tmp);
+        if(stnData->errCodeForVarCode[j]>0) strcat(vars, "*");
+        if(j<stnData->numberOfVarCodes-1) strcat(vars, ",");
+      }
+      if(!strcmp(vars,"")) strcpy(vars,"  --  ");
+
+      /* ie "%6ld %4ld %2ld %2ld %5.2f %9.4f %9.4f %7ld %7ld %8s  %-9s\n",
+         put together in line (see oclFormat.c) */
+      p = formatOCLLong( line, "", i, 6 );
+      p = formatOCLLong( p, " ", stnData->year, 4 );
+      p = formatOCLLong( p, " ", stnData->month, 2 );
+      p = formatOCLLong( p, " ", stnData->day, 2 );
+      p = formatOCLFixed( p, " ", stnData->time, 5, 2 );
+      p = formatOCLFixed( p, " ", stnData->lat, 9, 4 );
+      p = formatOCLFixed( p, " ", stnData->lon, 9, 4 );
+      p = formatOCLLong( p, " ", stnData->bytesInStation, 7 );
+      p = formatOCLLong( p, " ", stnData->numberOfLevels, 7 );
+      p = formatOCLString( p, " ", 0 );
+      p = formatOCLString( p, botDepthStr, 8 );
+      p = formatOCLString( p, "  ", 0 );
+      p = formatOCLString( p, vars, -9 );
+      formatOCLString( p, "\n", 0 );
+      fputs( line, fp_out );
+   }
+
+
+   /* Not doing the endStats (or one of the above possibilities) means
+      we want the regular formatted output of the profile data. */
+   else if( !opt->endStatsFlag ) {
+      /* Which of this station's variables get output - with -V, only
+         those on its list */
+      outputVars=0;
+      for(k=0; k<stnData->numberOfVarCodes; k++) {
+         for(l=0; l<opt->numProjectionVars; l++)
+            if( opt->projectionVars[l]==stnData->varCode[k] ) break;
+         if( !opt->projectionFlag || l<opt->numProjectionVars )
+            outputVars |= OCL_VAR_BIT(k);
+      }
+
+      /* Output title header first if needed (with -B, the station's
+         record has all that, and -S has its own) */
+      if( opt->titlesFlag && !opt->recordFlag && !opt->soundSpeedFlag ) {
+         if(stnData->bottomDepthPtr!=NULL)
+            sprintf(botDepthStr,"%.2f m", *(stnData->bottomDepthPtr));
+         else strcpy(botDepthStr,"[no data]");
+         fprintf(fp_out, "%%\n%%Station #%ld, bottom depth %9s (from %c),"
+            "  %s level data\n",i, botDepthStr, stnData->bottomDepthSource,
+            (stnData->stationType==0) ? "observed" : "standard" );
+         fprintf(fp_out, "%%Columns: Lat, Lon, Year, Month, Day, Time, "
+            "Depth");
+         for(j=0; j<stnData->numberOfVarCodes; j++)
+            if( outputVars & OCL_VAR_BIT(j) )
+               fprintf(fp_out, ", %s", varCodeLabel(stnData->varCode[j]));
+         fprintf(fp_out, "\n");
+         fprintf(fp_out, "%%Units:   deg, deg, yyyy, mm, dd, hrs, m");
+         for(j=0; j<stnData->numberOfVarCodes; j++)
+            if( outputVars & OCL_VAR_BIT(j) )
+               fprintf(fp_out, ", %s", varCodeUnits(stnData->varCode[j]));
+         fprintf(fp_out, "\n");
+      }
+      /* Which of this station's variables are required (ie in
+         varList) and have error-flagged or missing data on some
+         level - if none do, every level is good */
+      varListFlags=0;
+      if( opt->varListFlag ) {
+         for(k=0; k<stnData->numberOfVarCodes; k++)
+            for(l=0; l<opt->numVarsOnVarList; l++)
+               if( opt->varList[l]==stnData->varCode[k] )
+                  varListFlags |= OCL_VAR_BIT(k);
+         varListFlags &= stnData->anyLevelFlagged;
+      }
+
+      /* With -B, the profile goes out as binary records instead of text */
+      if( opt->recordFlag ) {
+         outputOCLStationRecord( opt, i, stnData, outputVars, varListFlags,
+            fp_out );
+         return;
+      }
+
+      /* With -S, the sound speed lines instead */
+      if( opt->soundSpeedFlag ) {
+         outputOCLStationSoundSpeeds( opt, i, stnData, outputVars,
+            varListFlags, fp_out );
+         return;
+      }
+
+      /* Now output the profile data itself */
+      for(j=0; j<stnData->numberOfLevels; j++) { /* loop over prof lvls */
+
+         /* 'errorFlaggedDataExists' on this profile level if any of
+            those variables is error-flagged or missing (NaN) here */
+         errorFlaggedDataExists =
+            ( varListFlags && (stnData->levelFlags[j] & varListFlags) );
+
+         /* print out one line = one profile level of output, ie
+            "%.4f  %.4f  %4ld %2ld %2ld %.2f  %.2f" and then "  %.3f" for
+            each variable, put together in line (see oclFormat.c) */
+         if( !errorFlaggedDataExists || opt->includeErrorFlaggedData ) {
+           p = formatOCLFixed( line, "", stnData->lat, 0, 4 );
+           p = formatOCLFixed( p, "  ", stnData->lon, 0, 4 );
+           p = formatOCLLong( p, "  ", stnData->year, 4 );
+           p = formatOCLLong( p, " ", stnData->month, 2 );
+           p = formatOCLLong( p, " ", stnData->day, 2 );
+           p = formatOCLFixed( p, " ", stnData->time, 0, 2 );
+           p = formatOCLFixed( p, "  ", stnData->depthValue[j], 0, 2 );
+           /* if we want to include error codes in output, append this */
+           if( opt->includeErrorFlaggedData ) {
+              p = formatOCLLong( p, " (", stnData->errCodeForDepthValue[j], 0);
+              p = formatOCLString( p, ")", 0 );
+           }
+           for(k=0; k<stnData->numberOfVarCodes; k++) {
+              if( !(outputVars & OCL_VAR_BIT(k)) ) continue;
+              p = formatOCLFixed( p, "  ", stnData->varValue[k][j], 0, 3 );
+              /* if we want to include error codes in output, append: */
+              if( opt->includeErrorFlaggedData ) {
+                 p = formatOCLLong( p, " (", stnData->errCodeForVarValue[k][j],
+                    0 );
+                 p = formatOCLString( p, ")", 0 );
+              }
+           }
+           formatOCLString( p, "\n", 0 );
+           fputs( line, fp_out );
+         }
+      }
+   }
+}
+
+
+
+
+
+
+
+
+/* "Output OCL station record" - with -B, write station #i to fp_out as a
+   station header record and level records (see oclRecord.c), with just the
+   levels and variables (outputVars) the text output would have: levels
+   with flagged or missing values in the varListFlags variables are left
+   out, unless -r. */
+void outputOCLStationRecord(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, unsigned int outputVars,
+   unsigned int varListFlags, FILE *fp_out) {
+
+   OCLRecordStationType rec;
+   double value[1+MAX_VARS];
+   unsigned char errCode[1+MAX_VARS];
+   long int j, k, n;
+
+   memset(&rec, 0, sizeof(rec));
+   rec.stationNumber = i;
+   rec.year = stnData->year;
+   rec.month = stnData->month;
+   rec.day = stnData->day;
+   rec.time = stnData->time;
+   rec.lat = stnData->lat;
+   rec.lon = stnData->lon;
+   rec.bottomDepth = getOCLBottomDepth( stnData );
+   rec.bottomDepthSource = stnData->bottomDepthSource;
+   rec.stationType = stnData->stationType;
+   for(k=0; k<stnData->numberOfVarCodes; k++) {
+      if( !(outputVars & OCL_VAR_BIT(k)) ) continue;
+      n = rec.numVars++;
+      rec.varCode[n] = stnData->varCode[k];
+      sprintf(rec.varLabel[n], "%.*s", OCL_RECORD_NAME_LEN-1,
+         varCodeLabel(stnData->varCode[k]));
+      sprintf(rec.varUnits[n], "%.*s", OCL_RECORD_NAME_LEN-1,
+         varCodeUnits(stnData->varCode[k]));
+   }
+
+   /* the levels that go out, as in outputOCLStation() */
+   for(j=0; j<stnData->numberOfLevels; j++)
+      if( !(varListFlags && (stnData->levelFlags[j] & varListFlags)) ||
+          opt->includeErrorFlaggedData )
+         rec.numLevels++;
+   writeOCLRecordStation( fp_out, &rec );
+
+   for(j=0; j<stnData->numberOfLevels; j++) {
+      if( varListFlags && (stnData->levelFlags[j] & varListFlags) &&
+          !opt->includeErrorFlaggedData )
+         continue;
+      value[0] = stnData->depthValue[j];
+      errCode[0] = stnData->errCodeForDepthValue[j];
+      for(k=0, n=1; k<stnData->numberOfVarCodes; k++) {
+         if( !(outputVars & OCL_VAR_BIT(k)) ) continue;
+         value[n] = stnData->varValue[k][j];
+         errCode[n++] = stnData->errCodeForVarValue[k][j];
+      }
+      writeOCLRecordLevel( fp_out, rec.numVars, value, errCode );
+   }
+}
+
+
+
+
+
+
+
+
+/* "Output sound speed header" - with -S (unless -t), the column titles of
+   sspcomp's output, for the start of an output file */
+void outputSoundSpeedHeader(OCLFiltOptionsType *opt, FILE *fp_out) {
+   if( opt->soundSpeedFlag && opt->titlesFlag ) {
+      fprintf(fp_out, "%%%7s %8s %4s %2s %2s %5s %8s %8s %8s %9s\n", "Lat  ",
+         "Lon  ", "Year", "Mo", "Dy", " Time", "Depth ", "Temp  ", "Saln ",
+         "Calcd_SSP" );
+      fprintf(fp_out, "%%%7s %8s %4s %2s %2s %5s %8s %8s %8s %9s\n", "deg  ",
+         "deg  ", "yyyy", "mm", "dd", "hrs", "meters ", "deg C ", "ppt ",
+         "m/s   ");
+      fprintf(fp_out, "%%--------------------------------------------------"
+         "----------------------\n");
+   }
+}
+
+
+
+
+
+
+
+
+/* "Output OCL station sound speeds" - with -S, write out station #i's
+   levels with the sound speed at each one, as sspcomp would for its text
+   output (ie oclfilt -v 1,2 | sspcomp): sspcm2() of the pressure at the
+   level's depth, the temperature, and the salinity - or 35ppt, the
+   worldwide average, for a station without salinity (or with it left out
+   by -V).  Levels are the ones the text output would have, as in
+   outputOCLStation(). */
+void outputOCLStationSoundSpeeds(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, unsigned int outputVars,
+   unsigned int varListFlags, FILE *fp_out) {
+
+   long int j, k, tempK=-1, salK=-1;
+   double temp, sal=35., ssp;
+   char botDepthStr[32];
+   char line[OCL_MAX_OUTPUT_LINE], *p;  /* (see oclFormat.c) */
+
+   /* temperature's and salinity's columns, by their var codes */
+   for(k=stnData->numberOfVarCodes-1; k>=0; k--) {
+      if( !(outputVars & OCL_VAR_BIT(k)) ) continue;
+      if( stnData->varCode[k]==1 ) tempK=k;
+      if( stnData->varCode[k]==2 ) salK=k;
+   }
+
+   /* sspcomp's station-info line, and its note on missing salinity */
+   if( opt->titlesFlag ) {
+      if(stnData->bottomDepthPtr!=NULL)
+         sprintf(botDepthStr,"%.2f m", *(stnData->bottomDepthPtr));
+      else strcpy(botDepthStr,"[no data]");
+      fprintf(fp_out, "%%Station #%ld, bottom depth %9s (from %c),"
+         "  %s level data\n",i, botDepthStr, stnData->bottomDepthSource,
+         (stnData->stationType==0) ? "observed" : "standard" );
+      if( salK<0 )
+         fprintf(fp_out, "%%(salinity data not present in input profile -"
+            " assuming 35ppt.)\n");
    }
 
-     
+   for(j=0; j<stnData->numberOfLevels; j++) {
+      if( varListFlags && (stnData->levelFlags[j] & varListFlags) &&
+          !opt->includeErrorFlaggedData )
+         continue;
+
+      temp = (tempK>=0) ? stnData->varValue[tempK][j] : nan();
+      if( salK>=0 ) sal = stnData->varValue[salK][j];
+      /* (out of sspcm2()'s range, or missing values, give sspcomp's NaN) */
+      if( sspcm2( depth2pres(stnData->depthValue[j]), temp, sal, &ssp ) != 0 ||
+          !(ssp>0 || ssp<=0) )
+         ssp = nan();
+
+      /* ie "%7.4f %7.4f %4ld %2ld %2ld %5.2f %8.3f %8.3f %8.3f %9.3f\n",
+         as sspcomp has it */
+      p = formatOCLFixed( line, "", stnData->lat, 7, 4 );
+      p = formatOCLFixed( p, " ", stnData->lon, 7, 4 );
+      p = formatOCLLong( p, " ", stnData->year, 4 );
+      p = formatOCLLong( p, " ", stnData->month, 2 );
+      p = formatOCLLong( p, " ", stnData->day, 2 );
+      p = formatOCLFixed( p, " ", stnData->time, 5, 2 );
+      p = formatOCLFixed( p, " ", stnData->depthValue[j], 8, 3 );
+      p = formatOCLFixed( p, " ", temp, 8, 3 );
+      p = formatOCLFixed( p, " ", sal, 8, 3 );
+      p = formatOCLFixed( p, " ", ssp, 9, 3 );
+      formatOCLString( p, "\n", 0 );
+      fputs( line, fp_out );
+   }
+}
+
+
+
+
+
+
+
+
+/* "Route OCL station" - with -X, send station #i to each query whose
+   expression it satisfies (if outputThisStation says it passed the other
+   filters), keeping each query's -e/-q summary counts and -n count just as
+   filterOCLStations() would with that expression as -x.  Returns true once
+   every query has had its -n stations. */
+int routeOCLStation(OCLFiltOptionsType *opt, long int i,
+   OCLStationType *stnData, int outputThisStation) {
+
+   long int q, numDone=0;
+   OCLFiltQueryType *query;
+
+   for(q=0; q<opt->numQueries; q++) {
+      query = &(opt->query[q]);
+      if( query->done ) {
+         numDone++;
+         continue;
+      }
+      query->stats.totalStationBytes += stnData->bytesInStation;
+      if( outputThisStation && opt->queryMatches[q] ) {
+         query->stats.stationOutputCount++;
+         query->stats.totalStationOutputBytes += stnData->bytesInStation;
+         outputOCLStation( opt, i, stnData, query->fp_out );
+      }
+      if( opt->numStnsFlag &&
+          query->stats.stationOutputCount>=opt->numStnsToOutput ) {
+         query->done = 1;
+         query->stats.endStn = i;
+         numDone++;
+      }
+   }
+
+   return numDone==opt->numQueries;
+}
+
+
+
+
+
+
+
+
+/* "Run oclfilt station jobs" - with -j and a single input file, split its
+   stations firstStn to the end into opt->numJobs contiguous ranges of about
+   the same number of bytes (found from the station index idx), and filter
+   each range in its own worker process into a temp file.  The temp files
+   are then copied to fp_out in station order, and the workers' summary
+   counts (sent back thru a pipe) added up, so the output is the same as
+   filtering the file straight through - station numbers included. */
+int runOCLFiltStationJobs(OCLFiltOptionsType *opt, char *infilename,
+   OCLSourceType *src, OCLIndexType *idx, long int firstStn,
+   int skipFlag, long int stnToSkipTo, FILE *fp_out, OCLFiltStatsType *stats) {
+
+   long int w, n=opt->numJobs, *rangeStart, bytesLeft, bytesPerRange, i, j;
+   pid_t *pid;
+   FILE **part, *fp_dbBathy=NULL;
+   int (*statsPipe)[2], ws, status=SUCCESSFUL;
+   OCLSourceType wsrc;
+   OCLFiltStatsType wstats;
+   char buf[BUFSIZ];
+   size_t nread;
+   long int ld_dummy;
+   double lf_dummy;
+
+   stats->stationOutputCount = 0;
+   stats->totalStationOutputBytes = 0;
+   stats->totalStationBytes = 0;
+   stats->endStn = idx->numStations;
+
+   pid = (pid_t *)malloc(n*sizeof(pid_t));
+   part = (FILE **)calloc(n, sizeof(FILE *));
+   rangeStart = (long int *)malloc((n+1)*sizeof(long int));
+   statsPipe = (int (*)[2])malloc(n*sizeof(*statsPipe));
+   if( pid==NULL || part==NULL || rangeStart==NULL || statsPipe==NULL ) {
+      fprintf(stderr, "oclfilt: out of memory.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   /* range w is stations rangeStart[w] to rangeStart[w+1]-1; cut the ranges
+      where the bytes so far pass each 1/n of the bytes to be read */
+   bytesLeft = 0;
+   for(i=firstStn; i<idx->numStations; i++) bytesLeft += idx->entry[i].length;
+   rangeStart[0] = firstStn;
+   for(w=1, i=firstStn; w<n; w++) {
+      bytesPerRange = bytesLeft/(n-w+1);
+      for(j=0; i<idx->numStations && j<bytesPerRange; i++)
+         j += idx->entry[i].length;
+      bytesLeft -= j;
+      rangeStart[w] = i;
+   }
+   rangeStart[n] = idx->numStations;
+
+   fflush(NULL);  /* (so nothing buffered gets written twice) */
+   for(w=0; w<n; w++) {
+      if( (part[w]=tmpfile()) == NULL || pipe(statsPipe[w]) != 0 ) {
+         fprintf(stderr, "oclfilt: unable to make temp file.\n");
+         exit(1);
+      }
+      setOCLOutputBuffer( part[w] );
+      if( (pid[w]=fork()) < 0 ) {
+         fprintf(stderr, "oclfilt: unable to start worker process.\n");
+         exit(1);
+      }
+      if( pid[w]==0 ) {  /* worker */
+
+         /* own file descriptors for the input & bathy files, since forked
+            ones share their file positions with the other workers */
+         wsrc = *src;
+         if( src->fp!=NULL ) {
+            if( (wsrc.fp=fopen(infilename,"r")) == NULL ) _exit(1);
+            setOCLSourceFile(&wsrc, wsrc.fp);
+         }
+         if( opt->databaseBathyFlag && !opt->bathyKind ) {
+            if( (fp_dbBathy=fopen(opt->dbBathyFilename,"r")) == NULL )
+               _exit(1);
+            for(i=0; i<rangeStart[w]; i++)
+               fscanf( fp_dbBathy, "%lf %lf %ld %lf\n", &lf_dummy, &lf_dummy,
+                  &ld_dummy, &lf_dummy );
+         }
+
+         if( seekOCLStation(&wsrc, idx, rangeStart[w]) != SUCCESSFUL )
+            _exit(1);
+         ws = filterOCLStations( opt, &wsrc, fp_dbBathy, rangeStart[w],
+            rangeStart[w+1], skipFlag, stnToSkipTo, part[w], &wstats );
+         if( opt->arenaStatsFlag ) {
+            sprintf(buf, "oclfilt worker for stns %ld-%ld", rangeStart[w],
+               rangeStart[w+1]-1);
+            reportOCLArena( &(opt->arena), stderr, buf );
+            reportOCLFilterCounts( &(opt->filterCounts), stderr, buf );
+         }
+         fflush(NULL);
+         if( write(statsPipe[w][1], &wstats, sizeof(wstats)) !=
+             (ssize_t)sizeof(wstats) ) ws=UNSPECIFIED_PROBLEM;
+         _exit( ws==SUCCESSFUL ? SUCCESSFUL : UNSPECIFIED_PROBLEM );
+      }
+      close(statsPipe[w][1]);
+   }
+
+   /* put the workers' output back together in order */
+   for(w=0; w<n; w++) {
+      if( read(statsPipe[w][0], &wstats, sizeof(wstats)) ==
+          (ssize_t)sizeof(wstats) ) {
+         stats->stationOutputCount += wstats.stationOutputCount;
+         stats->totalStationOutputBytes += wstats.totalStationOutputBytes;
+         stats->totalStationBytes += wstats.totalStationBytes;
+      }
+      close(statsPipe[w][0]);
+      if( waitpid(pid[w], &ws, 0) != pid[w] || !WIFEXITED(ws) ||
+          WEXITSTATUS(ws) != SUCCESSFUL )
+         status=UNSPECIFIED_PROBLEM;
+      rewind(part[w]);
+      while( (nread=fread(buf, 1, sizeof(buf), part[w])) > 0 )
+         fwrite(buf, 1, nread, fp_out);
+      fclose(part[w]);
+      /* (like a straight run, stop at the first station that failed) */
+      if( status!=SUCCESSFUL ) break;
+   }
+   for(w++; w<n; w++) {
+      close(statsPipe[w][0]);
+      waitpid(pid[w], &ws, 0);
+      fclose(part[w]);
+   }
+
+   free(pid);
+   free(part);
+   free(rangeStart);
+   free(statsPipe);
+
+   return status;
+}
+
+
+
+
+
+
+
+
+/* "Load oclfilt grid" - for -G, read the grid file, find its stations in
+   the -l region and -y/-m/-D dates, and make its files the input files */
+int loadOCLFiltGrid(OCLFiltOptionsType *opt) {
+
+   long int f, h, numHits;
+
+   if( readOCLGrid(opt->gridFilename, &(opt->grid)) != SUCCESSFUL )
+      return UNSPECIFIED_PROBLEM;
+
+   numHits = queryOCLGrid(&(opt->grid), opt->latlonRegionFlag,
+      opt->latlonRegion, opt->yearRangeFlag, opt->yearRange,
+      opt->monthRangeFlag, opt->monthRange, opt->dayRangeFlag, opt->dayRange,
+      &(opt->gridHit));
+   opt->numInFiles = opt->grid.numFiles;
+   opt->inFilename = (char **)malloc((opt->numInFiles+1)*sizeof(char *));
+   opt->gridHitStart = (long int *)malloc(
+      (opt->numInFiles+1)*sizeof(long int));
+   if( numHits<0 || opt->inFilename==NULL || opt->gridHitStart==NULL ) {
+      fprintf(stderr, "oclfilt: out of memory.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   /* (hits are in file order, so each file's are together) */
+   for(f=0, h=0; f<opt->numInFiles; f++) {
+      opt->inFilename[f] = opt->grid.file[f].name;
+      opt->gridHitStart[f] = h;
+      while( h<numHits && opt->gridHit[h].file==f ) h++;
+   }
+   opt->gridHitStart[f] = h;
+
    return SUCCESSFUL;
+}
 
 
-} /* end of main() */
- 
+
+
+
+
+
+
+/* "Filter OCL grid file" - with -G, filter input file #f of the grid: only
+   the stations the grid found in the -l region (if any) are read, each one
+   by seeking straight to it, and the output is the same as filterOCLFile()
+   gives on the whole file.  (The -e/-q summary's totals for the whole file
+   come from the grid.)  If the file's changed since it was gridded, it's
+   just filtered the regular way. */
+int filterOCLGridFile(OCLFiltOptionsType *opt, long int f, FILE *fp_out) {
+
+   OCLGridFileType *gf = &(opt->grid.file[f]);
+   OCLSourceType src;
+   OCLFiltStatsType stats, hitStats;
+   FILE *fp_in=NULL;
+   long int h;
+   int status=SUCCESSFUL;
+
+   stats.stationOutputCount = 0;
+   stats.totalStationOutputBytes = 0;
+   stats.totalStationBytes = gf->totalBytes;
+   stats.endStn = gf->numStations;
+
+   /* (nothing to read for a file with no stations in the region) */
+   if( opt->gridHitStart[f]<opt->gridHitStart[f+1] ) {
+      if( openOCLInput(opt, gf->name, &src, &fp_in) != SUCCESSFUL )
+         return UNSPECIFIED_PROBLEM;
+      if( sizeOfOCLSource(&src) != gf->fileSize ) {
+         fprintf(stderr, "%% oclfilt: %s has changed since the grid was"
+            " made, filtering all of it.\n", gf->name);
+         closeOCLSource(&src);
+         if( fp_in!=NULL ) fclose(fp_in);
+         return filterOCLFile( opt, gf->name, fp_out );
+      }
+   }
+
+   outputQueryHeader( opt, fp_out );
+
+   for(h=opt->gridHitStart[f]; h<opt->gridHitStart[f+1] && status==SUCCESSFUL;
+       h++) {
+      if( seekOCLSource(&src, opt->gridHit[h].offset) != SUCCESSFUL ) {
+         fprintf(stderr, "oclfilt: unable to seek to station %ld in %s.\n",
+            opt->gridHit[h].stn, gf->name);
+         status=UNSPECIFIED_PROBLEM;
+         break;
+      }
+      status = filterOCLStations( opt, &src, NULL, opt->gridHit[h].stn,
+         opt->gridHit[h].stn+1, 0, 0, fp_out, &hitStats );
+      stats.stationOutputCount += hitStats.stationOutputCount;
+      stats.totalStationOutputBytes += hitStats.totalStationOutputBytes;
+   }
+
+   if( status==SUCCESSFUL ) outputSummary( opt, &stats, fp_out );
+
+   if( opt->gridHitStart[f]<opt->gridHitStart[f+1] ) {
+      closeOCLSource(&src);
+      if( fp_in!=NULL ) fclose(fp_in);
+   }
+
+   return status;
+}
+
+
+
+
+
+
+
+
+/* "Filter OCL input" - filter input file #f of opt->inFilename, sending the
+   output to fp_out, or with -O to that file's own output file */
+int filterOCLInput(OCLFiltOptionsType *opt, long int f, FILE *fp_out) {
+
+   char outFilename[512], *base, *dot;
+   int status;
+
+   if( !opt->outDirFlag ) {
+      if( opt->gridFlag ) return filterOCLGridFile( opt, f, fp_out );
+      else return filterOCLFile( opt, opt->inFilename[f], fp_out );
+   }
+
+   /* <outdir>/<input file's name without its directory or any .gz> */
+   base = strrchr(opt->inFilename[f], '/');
+   base = (base==NULL) ? opt->inFilename[f] : base+1;
+   sprintf(outFilename, "%.255s/%.255s", opt->outDirname, base);
+   dot = strrchr(outFilename, '.');
+   if( dot!=NULL && !strcmp(dot, ".gz") ) *dot = '\0';
+
+   if ((fp_out = fopen(outFilename,"w")) == NULL) {
+      fprintf(stderr, "Unable to open file %s.\n", outFilename);
+      return UNSPECIFIED_PROBLEM;
+   }
+   setOCLOutputBuffer( fp_out );
+   outputSoundSpeedHeader( opt, fp_out );
+   if( opt->gridFlag ) status = filterOCLGridFile( opt, f, fp_out );
+   else status = filterOCLFile( opt, opt->inFilename[f], fp_out );
+   if( fclose(fp_out) != 0 ) status=UNSPECIFIED_PROBLEM;
+
+   return status;
+}
+
+
+
+
+
+
+
+/* "Run oclfilt jobs" - filter the input files on opt->numJobs worker
+   processes at once.  Each worker does one input file, writing into its own
+   temp file (or its -O output file); as each file in input order finishes,
+   its temp file is copied to fp_out, so the output comes out the same as
+   filtering the files one after another.  (Separate processes rather than
+   threads, since the decoder bails out with exit() on a corrupt file, and
+   that shouldn't take down the other files' workers.) */
+int runOCLFiltJobs(OCLFiltOptionsType *opt, FILE *fp_out) {
+
+   long int f, next=0, emit=0, running=0, n=opt->numInFiles;
+   pid_t *pid, p;
+   FILE **part;
+   int *done, *jobStatus, ws, status=SUCCESSFUL;
+   char buf[BUFSIZ];
+   size_t nread;
+
+   pid = (pid_t *)malloc(n*sizeof(pid_t));
+   part = (FILE **)calloc(n, sizeof(FILE *));
+   done = (int *)calloc(n, sizeof(int));
+   jobStatus = (int *)calloc(n, sizeof(int));
+   if( pid==NULL || part==NULL || done==NULL || jobStatus==NULL ) {
+      fprintf(stderr, "oclfilt: out of memory.\n");
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   while( emit<n ) {
+
+      /* start workers on the next files while there are free slots */
+      while( running<opt->numJobs && next<n ) {
+         if( !opt->outDirFlag && (part[next]=tmpfile()) == NULL ) {
+            fprintf(stderr, "oclfilt: unable to make temp file.\n");
+            exit(1);
+         }
+         if( !opt->outDirFlag ) setOCLOutputBuffer( part[next] );
+         fflush(NULL);  /* (so nothing buffered gets written twice) */
+         if( (pid[next]=fork()) < 0 ) {
+            fprintf(stderr, "oclfilt: unable to start worker process.\n");
+            exit(1);
+         }
+         if( pid[next]==0 ) {  /* worker */
+            ws = filterOCLInput( opt, next, part[next] );
+            if( opt->arenaStatsFlag ) {
+               sprintf(buf, "oclfilt worker for %.200s",
+                  opt->inFilename[next]);
+               reportOCLArena( &(opt->arena), stderr, buf );
+               reportOCLFilterCounts( &(opt->filterCounts), stderr, buf );
+            }
+            fflush(NULL);
+            _exit( ws==SUCCESSFUL ? SUCCESSFUL : UNSPECIFIED_PROBLEM );
+         }
+         running++;
+         next++;
+      }
+
+      /* wait for a worker to finish */
+      if( (p=wait(&ws)) < 0 ) {
+         fprintf(stderr, "oclfilt: lost track of worker processes.\n");
+         exit(1);
+      }
+      for(f=0; f<next && pid[f]!=p; f++);
+      if( f==next ) continue;  /* (not one of ours) */
+      done[f] = 1;
+      jobStatus[f] = ( WIFEXITED(ws) && WEXITSTATUS(ws)==SUCCESSFUL ) ?
+         SUCCESSFUL : UNSPECIFIED_PROBLEM;
+      running--;
+
+      /* output whatever's finished, in input file order */
+      while( emit<n && done[emit] ) {
+         if( part[emit]!=NULL ) {
+            rewind(part[emit]);
+            while( (nread=fread(buf, 1, sizeof(buf), part[emit])) > 0 )
+               fwrite(buf, 1, nread, fp_out);
+            fclose(part[emit]);
+         }
+         if( jobStatus[emit]!=SUCCESSFUL ) {
+            fprintf(stderr, "oclfilt: problem filtering %s.\n",
+               opt->inFilename[emit]);
+            status=UNSPECIFIED_PROBLEM;
+         }
+         emit++;
+      }
+   }
+
+   free(pid);
+   free(part);
+   free(done);
+   free(jobStatus);
+
+   return status;
+}
+
+
+
+
+
+
+
+
+/* "Read oclfilt queries" - for -X, read the query file queryFilename into
+   opt's queries: a line for each, with the name of the file its stations
+   go to and then its filter expression (as for -x), which gets compiled.
+   Blank lines and lines starting with % are skipped. */
+int readOCLFiltQueries(OCLFiltOptionsType *opt, char *queryFilename) {
+
+   FILE *fp;
+   char line[1024], *text;
+   long int lineNum=0, q, r;
+   size_t len;
+   int n, status=SUCCESSFUL;
+   OCLFiltQueryType *query;
+   OCLExprType *queryExpr;
+   char *queryMatches;
+
+   if ((fp = fopen(queryFilename,"r")) == NULL) {
+      fprintf(stderr, "Unable to open file %s.\n", queryFilename);
+      return UNSPECIFIED_PROBLEM;
+   }
+
+   while( status==SUCCESSFUL && fgets(line, sizeof(line), fp) != NULL ) {
+      lineNum++;
+      len = strlen(line);
+      if( len>0 && line[len-1]=='\n' ) line[len-1] = '\0';
+      else if( !feof(fp) ) {
+         fprintf(stderr, "oclfilt: line %ld of query file %s is too long.\n",
+            lineNum, queryFilename);
+         status=UNSPECIFIED_PROBLEM;
+         break;
+      }
+      for(text=line; isspace((unsigned char)*text); text++);
+      if( *text=='\0' || *text=='%' ) continue;
+
+      /* room for one more query */
+      q = opt->numQueries;
+      query = (OCLFiltQueryType *)realloc(opt->query,
+         (q+1)*sizeof(OCLFiltQueryType));
+      if( query!=NULL ) opt->query = query;
+      queryExpr = (OCLExprType *)realloc(opt->queryExpr,
+         (q+1)*sizeof(OCLExprType));
+      if( queryExpr!=NULL ) opt->queryExpr = queryExpr;
+      queryMatches = (char *)realloc(opt->queryMatches, (q+1)*sizeof(char));
+      if( queryMatches!=NULL ) opt->queryMatches = queryMatches;
+      if( query==NULL || queryExpr==NULL || queryMatches==NULL ) {
+         fprintf(stderr, "oclfilt: out of memory.\n");
+         status=UNSPECIFIED_PROBLEM;
+         break;
+      }
+      memset(&(opt->query[q]), 0, sizeof(OCLFiltQueryType));
+
+      /* <outfilename> <expr> */
+      sscanf(text, "%255s%n", opt->query[q].outFilename, &n);
+      text += n;
+      for(r=0; r<q; r++)
+         if( !strcmp(opt->query[r].outFilename, opt->query[q].outFilename) )
+            break;
+      if( r<q ) {
+         fprintf(stderr, "oclfilt: line %ld of query file %s has the same "
+            "output file as a line\nbefore it - each query needs its own.\n",
+            lineNum, queryFilename);
+         status=UNSPECIFIED_PROBLEM;
+      }
+      else if( compileOCLExpr(text, &(opt->queryExpr[q])) != SUCCESSFUL ) {
+         fprintf(stderr, "oclfilt: (in line %ld of query file %s)\n",
+            lineNum, queryFilename);
+         status=UNSPECIFIED_PROBLEM;
+      }
+      else opt->numQueries++;
+   }
+   fclose(fp);
+
+   if( status==SUCCESSFUL && opt->numQueries==0 ) {
+      fprintf(stderr, "oclfilt: no queries in query file %s.\n",
+         queryFilename);
+      status=UNSPECIFIED_PROBLEM;
+   }
+
+   return status;
+}
+
 
 
 
@@ -476,11 +1767,13 @@ int outputAllStationData(FILE *fp_out, long int i, OCLStationType *stnData) {
   }
   fprintf(fp_out, "depth, var1, var2, etc:\n");
   for(j=0; j<stnData->numberOfLevels; j++) {
-    fprintf(fp_out, "%f (%ld)     ", 
+    fprintf(fp_out, "%f (%d)     ", 
       stnData->depthValue[j], stnData->errCodeForDepthValue[j]);
     for(k=0; k<stnData->numberOfVarCodes; k++)
-      fprintf(fp_out, "%f (%ld)     ", 
-        stnData->varValue[k][j], stnData->errCodeForVarValue[k][j]);
+      if( stnData->decodedVars & OCL_VAR_BIT(k) )
+        fprintf(fp_out, "%f (%d)     ", 
+          stnData->varValue[k][j], stnData->errCodeForVarValue[k][j]);
+      else fprintf(fp_out, "-- (not decoded)     ");
     fprintf(fp_out, "\n");
   }
   fprintf(fp_out, "bytesLeftInStation(%ld)=%ld\n", i,
@@ -497,29 +1790,22 @@ int outputAllStationData(FILE *fp_out, long int i, OCLStationType *stnData) {
 
 
 /* "Parse Command Line" - get the appropriate command line info for oclfilt */
-int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut, 
-   int *botDepthFiltFlag, double *shallowerDLimit, double *deeperDLimit,
-   int *varListFlag, long int *numVarsOnVarList, long int *varList,
-   int *debugFlag, int *endStatsFlag, int *titlesFlag, int *queryFlag, 
-   int *databaseBathyFlag, char *databaseBathyFilename,
-   int *numStnsFlag, long int *numStnsToOutput,
-   int *skipFlag, long int *stnToSkipTo,
-   int *zeroLatLonFlag, char *wmoSquare,
-   int *minLevelsFlag, long int *minLevels,
-   int *latlonRegionFlag, double *latlonRegion,
-   int *yearRangeFlag, long int *yearRange,
-   int *monthRangeFlag, long int *monthRange,
-   int *includeErrorFlaggedData ){
-
-  /* note that by using pointers to the filepointers, I made it so I can
-     access the filepointers from main after they're set in the function -
-     that's the reason for the FILE ** declarations, and why *fp... is used
-     below instead of fp... */
-
-  int c, i_flag=0, o_flag=0, status=SUCCESSFUL;
+int parse_commandline( int argc, char **argv, OCLFiltOptionsType *opt ){
+
+  /* note that everything parsed here goes into the one options struct,
+     which main() then hands to filterOCLFile() for each input file */
+
+  int c, i_flag=0, I_flag=0, status=SUCCESSFUL;
   long int *vp;  /* tmp pointer for filling in varList */
   char filename[256];
   char *tmp;  /* tmp pointer for searching thru *argv for commas */
+  static glob_t inFiles;  /* (input file list, kept for the whole run) */
+
+  /* defaults, for whatever isn't set by cmdline options below: */
+  memset(opt, 0, sizeof(*opt));
+  opt->titlesFlag=1;
+  opt->numJobs=1;
+  strcpy(opt->indexFilename,"");
 
   /* Loop thru and parse the command line options */
   while (--argc > 0 && (*++argv)[0] == '-') {
@@ -529,8 +1815,9 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          *botDepthFiltFlag=1;
-          if( sscanf(*argv, "%lf,%lf", shallowerDLimit, deeperDLimit) !=2 ) {
+          opt->botDepthFiltFlag=1;
+          if( sscanf(*argv, "%lf,%lf", &opt->shallowerDLimit,
+                &opt->deeperDLimit) !=2 ) {
              fprintf(stderr, "The -b param requires an argument of "
                 "<shallowerDLimit>,<deeperDLimit>.\n");
              status=UNSPECIFIED_PROBLEM;
@@ -542,12 +1829,34 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
           status=UNSPECIFIED_PROBLEM;
         }
         break;
+      case 'D':  /* day-of-year range */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          opt->dayRangeFlag=1;
+          sscanf( *argv, "%ld,%ld", &opt->dayRange[0], &opt->dayRange[1] );
+        }
+        else {
+          fprintf(stderr, "The -D param requires an argument of <dayRange>,"
+                  " as day1,day2 of the year, eg 335,59.\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
+      case 'B':  /* binary record stream output flag */
+        opt->recordFlag=1;
+        break;
+      case 'S':  /* sound speed output flag */
+        opt->soundSpeedFlag=1;
+        break;
+      case 'c':  /* decoder stats flag */
+        opt->arenaStatsFlag=1;
+        break;
       case 'd': /* database-bathy file*/
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          sprintf(databaseBathyFilename,"%s",*argv);
-          *databaseBathyFlag=1;
+          sprintf(opt->dbBathyFilename,"%s",*argv);
+          opt->databaseBathyFlag=1;
         }
         else {
           fprintf(stderr, "The -d param requires an argument of <filename>\n");
@@ -555,16 +1864,42 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         }
         break;
       case 'e':  /* end-stats flag */
-        *endStatsFlag=1;
+        opt->endStatsFlag=1;
         break;
       case 'f':  /* full (debug) output flag */
-        *debugFlag=1;
+        opt->debugFlag=1;
+        break;
+      case 'G': /* spatial index ("grid") of stations in many files */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          sprintf(opt->gridFilename,"%.255s",*argv);
+          opt->gridFlag=1;
+        }
+        else {
+          fprintf(stderr, "The -G param requires an argument of <gridfile>."
+                  "\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
+      case 'I': /* station index file */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          sprintf(opt->indexFilename,"%s",*argv);
+          ++I_flag;
+        }
+        else {
+          fprintf(stderr, "The -I param requires an argument of <indexfilename>."
+                  "\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
         break;
       case 'i': /* input file*/
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          sprintf(filename,"%s",*argv);
+          sprintf(filename,"%.255s",*argv);
           ++i_flag;
         }
         else {
@@ -573,14 +1908,41 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
           status=UNSPECIFIED_PROBLEM;
         }
         break;
+      case 'j':  /* number of worker processes for multiple input files */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          opt->numJobs=atol(*argv);
+          if( opt->numJobs<=0 ) opt->numJobs=sysconf(_SC_NPROCESSORS_ONLN);
+          if( opt->numJobs<=0 ) opt->numJobs=1;
+        }
+        else {
+          fprintf(stderr,"The -j param requires an argument of <numjobs>\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
+      case 'k':  /* skip to this OCL station number */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          opt->oclStnFlag=1;
+          opt->oclStnToSkipTo=atol(*argv);
+        }
+        else {
+          fprintf(stderr,"The -k param requires an argument of "
+                  "<oclstationnumber>\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
       case 'l':  /* lat/lon range */
 	++argv;
 	--argc;
 	/* if(*argv!=NULL && *argv[0] != '-') {   this prevents neg lon! */
 	if(*argv!=NULL ) {
-	  *latlonRegionFlag=1;
-          sscanf(*argv, "%lf/%lf/%lf/%lf", &latlonRegion[0], &latlonRegion[1],
-	                                   &latlonRegion[2], &latlonRegion[3]);
+	  opt->latlonRegionFlag=1;
+          sscanf(*argv, "%lf/%lf/%lf/%lf",
+             &opt->latlonRegion[0], &opt->latlonRegion[1],
+             &opt->latlonRegion[2], &opt->latlonRegion[3]);
         }
         else {
           fprintf(stderr, "The -l param requires an argument of <latlonRange>,"
@@ -588,12 +1950,15 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
           status=UNSPECIFIED_PROBLEM;
         }
 	break;
+      case 'M':  /* memory-map the input file */
+        opt->mapInputFlag=1;
+        break;
       case 'm':  /* month range */
 	++argv;
 	--argc;
 	if(*argv!=NULL && *argv[0] != '-') {
-	  *monthRangeFlag=1;
-          sscanf( *argv, "%ld,%ld", &monthRange[0], &monthRange[1] );
+	  opt->monthRangeFlag=1;
+          sscanf( *argv, "%ld,%ld", &opt->monthRange[0], &opt->monthRange[1] );
         }
         else {
           fprintf(stderr, "The -m param requires an argument of <monthRange>,"
@@ -605,8 +1970,8 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          *numStnsFlag=1;
-          *numStnsToOutput=atoi(*argv);
+          opt->numStnsFlag=1;
+          opt->numStnsToOutput=atoi(*argv);
         }
         else {
           fprintf(stderr, "The -n param requires an argument of <numStations>."
@@ -614,12 +1979,24 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
           status=UNSPECIFIED_PROBLEM;
         }
         break;
+      case 'O': /* directory for a separate output file per input file */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          sprintf(opt->outDirname,"%.255s",*argv);
+          opt->outDirFlag=1;
+        }
+        else {
+          fprintf(stderr, "The -O param requires an argument of <outdir>.\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
       case 'o': /* output file*/
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          sprintf(filename,"%s",*argv);
-          ++o_flag;
+          sprintf(opt->outFilename,"%.255s",*argv);
+          opt->outFileFlag=1;
         }
         else {
           fprintf(stderr, "The -o param requires an argument of <outfilename>."
@@ -631,8 +2008,8 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          *minLevelsFlag=1;
-          *minLevels=atoi(*argv);
+          opt->minLevelsFlag=1;
+          opt->minLevels=atoi(*argv);
         }
         else {
           fprintf(stderr, "The -p param requires an argument of <minPts>.\n");
@@ -640,17 +2017,17 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         }
         break;
       case 'q':  /* query-output flag */
-        *queryFlag=1;
+        opt->queryFlag=1;
         break;
       case 'r':  /* include error-flagged data */
-	*includeErrorFlaggedData=1;
+	opt->includeErrorFlaggedData=1;
 	break;
       case 's':  /* skip to this station number */
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          *skipFlag=1;
-          *stnToSkipTo=atoi(*argv);
+          opt->skipFlag=1;
+          opt->stnToSkipTo=atoi(*argv);
         }
         else {
           fprintf(stderr,"The -s param requires an argument of <stationnumber>"
@@ -659,19 +2036,19 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
         }
         break;
       case 't':  /* do NOT print out data-column title headers */
-        *titlesFlag=0;
+        opt->titlesFlag=0;
         break;
       case 'v': /* filter by data-variables - only output if these vars good */
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          *varListFlag=1;
+          opt->varListFlag=1;
 	  tmp=*argv;
-	  vp=varList;
+	  vp=opt->varList;
 	  do {  /* keep allocating varList values as long as there are
                    commas left to delimit them */
 	     sscanf(tmp, "%ld", vp++);
-	     (*numVarsOnVarList)++;
+	     opt->numVarsOnVarList++;
 	     tmp=strchr(tmp,',');
 	     if( tmp!=NULL ) tmp++;
 	  } while(tmp!=NULL);
@@ -681,24 +2058,71 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
           status=UNSPECIFIED_PROBLEM;
         }
         break;
+      case 'V': /* only decode & output these vars' profile columns */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          opt->projectionFlag=1;
+	  tmp=*argv;
+	  do {
+	     if( opt->numProjectionVars<MAX_VARS &&
+	         sscanf(tmp, "%ld",
+	            &(opt->projectionVars[opt->numProjectionVars])) == 1 )
+	        opt->numProjectionVars++;
+	     tmp=strchr(tmp,',');
+	     if( tmp!=NULL ) tmp++;
+	  } while(tmp!=NULL);
+        }
+        else {
+          fprintf(stderr, "The -V param requires an argument of <varlist>.\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
       case 'w': /* WMO square to filter out bad lat/lon zero values */
         ++argv;
         --argc;
         if(*argv!=NULL && *argv[0] != '-') {
-          sprintf(wmoSquare,"%s",*argv);
-          *zeroLatLonFlag=1;
+          sprintf(opt->wmoSquare,"%s",*argv);
+          opt->zeroLatLonFlag=1;
         }
         else {
           fprintf(stderr,"The -w param requires an argument of <wmo_square>\n");
           status=UNSPECIFIED_PROBLEM;
         }
         break;
+      case 'x': /* filter expression */
+        ++argv;
+        --argc;
+        if(*argv!=NULL) {
+          opt->exprFlag=1;
+          if( compileOCLExpr( *argv, &opt->expr ) != SUCCESSFUL )
+            status=UNSPECIFIED_PROBLEM;
+        }
+        else {
+          fprintf(stderr, "The -x param requires an argument of <expr>.\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
+      case 'X': /* batch of queries, each with its own output file */
+        ++argv;
+        --argc;
+        if(*argv!=NULL && *argv[0] != '-') {
+          opt->batchFlag=1;
+          if( readOCLFiltQueries( opt, *argv ) != SUCCESSFUL )
+            status=UNSPECIFIED_PROBLEM;
+        }
+        else {
+          fprintf(stderr, "The -X param requires an argument of "
+             "<queryfilename>.\n");
+          status=UNSPECIFIED_PROBLEM;
+        }
+        break;
       case 'y':  /* year range */
 	++argv;
 	--argc;
 	if(*argv!=NULL && *argv[0] != '-') {
-	  *yearRangeFlag=1;
-          sscanf( *argv, "%ld,%ld", &yearRange[0], &yearRange[1] );
+	  opt->yearRangeFlag=1;
+          sscanf( *argv, "%ld,%ld", &opt->yearRange[0], &opt->yearRange[1] );
         }
         else {
           fprintf(stderr, "The -y param requires an argument of <yearRange>,"
@@ -714,7 +2138,8 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
            "that input file.\n");
         fprintf(stderr, "         (last compiled: %s, %s)\n\n", __DATE__,
            __TIME__);
-        fprintf(stderr, "usage:   oclfilt [optional params -bdefhilmnopqrstvwy]\n");
+        fprintf(stderr, "usage:   oclfilt [optional params "
+           "-BbcDdefGhIijklMmnOopqrSstVvwXxy] [infiles...]\n");
 	fprintf(stderr, "         See oclfilt.manpage for details.\n");
         fprintf(stderr, "         Note that no args assumes stdin & stdout.\n");
         fprintf(stderr, "\n");
@@ -727,45 +2152,76 @@ int parse_commandline( int argc, char **argv, FILE **fpIn, FILE **fpOut,
     }
   }
   /* catch any remaining parsing errors */
-  if (argc!=0) {
+  if (argc<0) {
     fprintf(stderr, "There was some kind of parsing error, probably a\n");
     fprintf(stderr, "missing dash or missing parameter value...\n");
     status=UNSPECIFIED_PROBLEM;
   }
 
-  /* show error messsage and exit if trouble */
-  if( status==UNSPECIFIED_PROBLEM ) {
-    fprintf(stderr, "For usage list, type oclfilt -h\n\n");
-  }
-  if( status!=SUCCESSFUL ) return status;
-
-  /* done parsing command line */
+  /* whatever's left on the cmdline after the options is input files (after
+     the -i one if any) - expand any wildcards the shell didn't, in case they
+     were quoted to get past the shell's argument length limit */
+  if( i_flag ) glob(filename, GLOB_NOCHECK, NULL, &inFiles);
+  for(; argc>0; argc--, argv++)
+    glob(*argv, GLOB_NOCHECK | ((i_flag || inFiles.gl_pathc>0) ?
+       GLOB_APPEND : 0), NULL, &inFiles);
+  opt->numInFiles = (long int)inFiles.gl_pathc;
+  opt->inFilename = inFiles.gl_pathv;
 
+  /* a -d bathy grid is looked up by position, rather than read a line per
+     station like a bathy file, so it goes with any input - but a sidecar,
+     like the bathy file, is only for the one input file */
+  opt->bathyKind = opt->databaseBathyFlag ?
+     isOCLBathyFile(opt->dbBathyFilename) : 0;
 
-
-  /* assign stdin or open file depending on args */
-  if( i_flag ) {
-    if ((*fpIn = fopen(filename,"r")) == NULL) {
-      fprintf(stderr, "Unable to open file %s.\n", filename);
-      status=UNSPECIFIED_PROBLEM;
-    }
+  if( opt->gridFlag && (opt->numInFiles>0 ||
+      (opt->databaseBathyFlag && opt->bathyKind!=OCL_BATHY_GRID) ||
+      I_flag || opt->skipFlag || opt->oclStnFlag || opt->numStnsFlag) ) {
+    fprintf(stderr, "The -G param takes its input files from the grid file,"
+       " and can't be used\nwith -d (but for a bathy grid), -I, -k, -n, or"
+       " -s.\n");
+    status=UNSPECIFIED_PROBLEM;
   }
-  else {
-    *fpIn = stdin;
+  if( opt->mapInputFlag && opt->numInFiles==0 && !opt->gridFlag ) {
+    fprintf(stderr, "The -M param requires an input file (not stdin).\n");
+    status=UNSPECIFIED_PROBLEM;
   }
-
-  /* assign stdout or open file depending on args */
-  if( o_flag ) {
-    if ((*fpOut = fopen(filename,"w")) == NULL) {
-      fprintf(stderr, "Unable to open file %s.\n", filename);
-      status=UNSPECIFIED_PROBLEM;
-    }
+  if( opt->outDirFlag && ((opt->numInFiles==0 && !opt->gridFlag) ||
+      opt->outFileFlag) ) {
+    fprintf(stderr, "The -O param requires input files, and can't be used "
+       "with -o.\n");
+    status=UNSPECIFIED_PROBLEM;
+  }
+  if( opt->batchFlag && (opt->exprFlag || opt->gridFlag || opt->numJobs>1 ||
+      opt->outFileFlag || opt->outDirFlag) ) {
+    fprintf(stderr, "The -X param sends the output to its queries' own files,"
+       " and can't be used\nwith -G, -j, -O, -o, or -x.\n");
+    status=UNSPECIFIED_PROBLEM;
   }
-  else {
-    *fpOut = stdout;
+  if( opt->recordFlag && (opt->debugFlag || opt->endStatsFlag ||
+      opt->queryFlag) ) {
+    fprintf(stderr, "The -B param outputs the profile data, and can't be used"
+       " with -e, -f, or -q.\n");
+    status=UNSPECIFIED_PROBLEM;
+  }
+  if( opt->soundSpeedFlag && (opt->recordFlag || opt->debugFlag ||
+      opt->endStatsFlag || opt->queryFlag) ) {
+    fprintf(stderr, "The -S param outputs the profiles' sound speeds, and"
+       " can't be used with -B,\n-e, -f, or -q.\n");
+    status=UNSPECIFIED_PROBLEM;
+  }
+  if( opt->numInFiles>1 && ((opt->databaseBathyFlag &&
+      opt->bathyKind!=OCL_BATHY_GRID) || I_flag) ) {
+    fprintf(stderr, "The -d (but for a bathy grid) and -I params go with a"
+       " single input file.\n");
+    status=UNSPECIFIED_PROBLEM;
+  }
+
+  /* show error messsage and exit if trouble */
+  if( status==UNSPECIFIED_PROBLEM ) {
+    fprintf(stderr, "For usage list, type oclfilt -h\n\n");
   }
 
   return status;
 
 } /* end of parsing cmd line */
-
@@ -6,31 +6,45 @@
 
 int main (int argc, char *argv[]) {
 
-  int skipFlag=0, varListFlag=0, wantProfileFlag=0, dbBathyFlag=0;
-  int  zeroLatLonFlag, badLatFlag=0, badLonFlag=0;
+  int wantProfileFlag=0, status;
+  int badLatFlag=0, badLonFlag=0;
   char wmoSquare[5]="";
-  long int i, stnToSkipTo=0, varList[1], numVarsOnVarList=0;
-  FILE *fp_dbBathy=NULL;
+  long int i;
+  FILE *fp_in=stdin;
   double badLat=0., badLon=0.;
-  OCLStationType stnData;
+  OCLDecoderType dec;
+  OCLStationType *stnData=&(dec.stnData);
 
-  if( argc!=4 ) {
-    printf("usage: outputAllLatsLons <wmo_square> <bad-lon> <bad-lat>\n");
+  if( argc!=4 && argc!=5 ) {
+    printf("usage: outputAllLatsLons <wmo_square> <bad-lon> <bad-lat> "
+       "[<oclfile>]\n");
+    printf("       (<oclfile> may be gzipped; default reads stdin)\n");
     exit(1);
   }
   else {
     strncpy(wmoSquare,argv[1],4);
-    zeroLatLonFlag=0;
     badLon=atof(argv[2]);
     badLat=atof(argv[3]);
   }
 
+  /* read from stdin, the named file, or the named file decompressed */
+  initOCLDecoder(&dec);
+  if( argc==5 && isGzipFile(argv[4]) ) {
+    if( loadOCLGzSource(&(dec.src), argv[4]) != SUCCESSFUL ) exit(1);
+  }
+  else {
+    if( argc==5 && (fp_in=fopen(argv[4],"r")) == NULL ) {
+      fprintf(stderr, "Unable to open file %s.\n", argv[4]);
+      exit(1);
+    }
+    setOCLSourceFile(&(dec.src), fp_in);
+  }
+
 
   /* loop over stations in this file */
-  for (i=0; !feof(stdin); i++) {
-    if( getOCLStationData( stdin, i, &stnData, wantProfileFlag,
-      skipFlag, stnToSkipTo, varListFlag, varList, numVarsOnVarList,
-      dbBathyFlag, fp_dbBathy, zeroLatLonFlag, wmoSquare) != SUCCESSFUL ) {
+  for (i=0; (status=decodeOCLStation(&dec, wantProfileFlag)) !=
+       OCL_DECODER_END; i++) {
+    if( status != SUCCESSFUL ) {
       fprintf( stderr,
          "outputAllLatsLons: failure in getOCLStationData at stn#%ld.\n", i );
       exit(1);
@@ -41,16 +55,16 @@ int main (int argc, char *argv[]) {
        be any */
     badLatFlag=badLonFlag=0;
        /* (remember can't rely on doubles being exactly equal...) */
-    if( stnData.lon<0.0000001 && stnData.lon>-0.0000001 ) {  /*ie, if zero*/
+    if( stnData->lon<0.0000001 && stnData->lon>-0.0000001 ) {  /*ie, if zero*/
        badLonFlag = !zeroLatLonOkay( wmoSquare, "lon" );
     }
-    if( stnData.lat<0.0000001 && stnData.lat>-0.0000001 ) {  /*ie, if zero*/
+    if( stnData->lat<0.0000001 && stnData->lat>-0.0000001 ) {  /*ie, if zero*/
        badLatFlag = !zeroLatLonOkay( wmoSquare, "lat" );
     }
 
     
     /* catch lats that are out of db bounds : >72 or <-72 */
-    if( stnData.lat>72. || stnData.lat<-72. ) badLatFlag=1;
+    if( stnData->lat>72. || stnData->lat<-72. ) badLatFlag=1;
 
 
     /* substitute valid placeholder values for bad lats or lons, so that
@@ -58,8 +72,8 @@ int main (int argc, char *argv[]) {
        filter out the bad ones, but this way grdtrack won't completely skip
        their line */
     if(badLonFlag || badLatFlag) {
-       stnData.lon=badLon;
-       stnData.lat=badLat;
+       stnData->lon=badLon;
+       stnData->lat=badLat;
     }
     else {
        /* kludgy but effective way of checking if wmosquare is in spac or npac
@@ -71,14 +85,16 @@ int main (int argc, char *argv[]) {
        if(wmoSquare[0]=='5' || wmoSquare[0]=='7') {
          if( atoi(wmoSquare+2) > 6 ) {
            /* at this point all lons should be negative */
-           stnData.lon+=360.; /* convert to positive lon */
+           stnData->lon+=360.; /* convert to positive lon */
          }
        }
     }
 
-    printf("%f  %f %ld\n", stnData.lon, stnData.lat, i);
+    printf("%f  %f %ld\n", stnData->lon, stnData->lat, i);
   }
 
+  freeOCLDecoder(&dec);
+
   return SUCCESSFUL;
 
 }  /* end of main */
@@ -141,3 +141,9 @@ int sspcm2(double P, double T, double S, double *sndspd) {
 
 
 
+
+/* "Depth to Pressure" - quick conversion function, from depth in meters to
+   pressure in bars for sspcm2() (gleaned out of tsspcm2.f - "test sspcm2") */
+double depth2pres(double depth) {
+  return .1 * depth / .99;
+}
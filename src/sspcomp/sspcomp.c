@@ -11,8 +11,14 @@
  *               [comp_sal, comp_sndspd, diff_sndspd, [stdev_ssp, numbins] ]
  *             sspcomp assumes input data is grouped by station, each within
  *             profile depth order (as oclfilt outputs).
+ *             Input can also be the binary record stream that oclfilt -B
+ *             outputs (see ../oclfilt/oclRecord.c), which is told from text
+ *             by its first byte and read without any parsing; its temp and
+ *             sal values are found by their var codes.
  * 
- * required sources/files: sspcomp.c, sspcm2.c, Makefile
+ * required sources/files: sspcomp.c, sspcm2.c, Makefile,
+ *                         ../oclfilt/oclFormat.c, oclRecord.c, ocl.h and
+ *                         oclRecord.h
  *
  * language:   ANSI C
  *
@@ -94,6 +100,12 @@
  *                out "comparison sndspeed" from output; now the substitution
  *                is done automatically when input has no salinity column, and
  *                the output lists a comment when this happens.
+ *    10/16/26-agent-output lines put together with oclfilt's fast number formatting
+ *                (oclFormat.c, same output as printf), and written out in
+ *                big buffered chunks; nan() renamed makeNaN(), as it clashed
+ *                with the C library's
+ *            -reads oclfilt -B's binary record stream input too
+ *            -depth2pres() moved into sspcm2.c, which oclfilt -S shares
  */
 
 
@@ -101,6 +113,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
+#include "oclRecord.h"  /* (../oclfilt's, for reading oclfilt -B output) */
 
 /* function return statuses */
 #define SUCCESSFUL 0
@@ -131,23 +144,28 @@ int read5DegData( FILE *fpIn,
 int sspcm2(double pres, double temp, double sal, double *sndspd);
 double depth2pres(double depth);
 double stdev(double *cumDiffSsp, double avg, long int N);
-double nan();
+double makeNaN();
+char *formatOCLFixed(char *p, const char *prefix, double x, int width,
+  int decimals);
+char *formatOCLLong(char *p, const char *prefix, long int v, int width);
+char *formatOCLString(char *p, const char *s, int width);
+void setOCLOutputBuffer(FILE *fp);
 int getStdLevelInd(double depth);
 int getLatInd(double lat);
 int getLonInd(double lon);
 
 
 
-main(int argc, char *argv[]) {
+int main(int argc, char *argv[]) {
 
-  long int i, j, N=0;
+  long int i, j, k, N=0;
   int depthBinsUsed=0, showTitleHeader=1, firstLine=1, newDepthBin, newStation;
   int compSalType=0, statusActual, statusComp, lastLinePassed=0;
   int status=SUCCESSFUL, salPresent=1;
   int year, month, day, oldyear=-1, oldmonth=-1, oldday=-1, season;
   static double salArray[4][MAX_SDEPTHS][MAX_LAT_INDS][MAX_LON_INDS];
   double time, oldtime=-1.;
-  double badValue=nan();  /* just assigns NaN */
+  double badValue=makeNaN();  /* just assigns NaN */
   double lat, oldLat=361., lon, oldLon=361.;
   double depth, depthBin=0., depthBinSize=10.00, pres, temp,sal,compSal=35.000;
   double sspActual, sspComp, diffSsp;
@@ -157,6 +175,13 @@ main(int argc, char *argv[]) {
   double avgTemp=0., avgSal=0., avgSspComp=0., avgSspActual=0., avgDiffSsp=0.;
   double avgCompSal=0., stdevDiffSsp;
   char inputLine[256], labelString[78]="";
+  char outputLine[256], *p;  /* (see ../oclfilt/oclFormat.c) */
+  int recordInput, tempCol=-1, salCol=-1;  /* (see ../oclfilt/oclRecord.c) */
+  long int recordFlags=0, levelsLeft=0;
+  OCLRecordStationType rec;
+  double value[1+OCL_RECORD_MAX_VARS];
+  unsigned char errCode[1+OCL_RECORD_MAX_VARS];
+  char botDepthStr[32];
   FILE *fpIn, *fpOut;
 
 
@@ -174,6 +199,12 @@ main(int argc, char *argv[]) {
      function - that's the reason for the FILE ** declarations (rather than
      just FILE * ) within the function itself. */
 
+  /* output goes out in big chunks rather than line by line */
+  setOCLOutputBuffer(stdout);
+
+  /* input may be oclfilt -B's binary record stream rather than text */
+  recordInput = isOCLRecordStream(fpIn);
+
 
 
   /* Output title header if specified in cmdline */
@@ -208,41 +239,97 @@ main(int argc, char *argv[]) {
 
 
 
-  /* Loop over the lines in the input stream */
+  /* Loop over the lines (or levels) in the input stream */
   for (i=0; !lastLinePassed; i++) {
 
-    /* get a line of data from the input file */
-    if(fgets(inputLine, 255, fpIn)==NULL) lastLinePassed=1;
-
-    /* comment lines - we want to keep the station-info line,
-       check for existence of salinity column in input, and toss the other
-       comment lines; and afterwards skip to next line-reading */
-    if( !strncmp(inputLine, "%Station", 8) ) {
-      printf("%s", inputLine);
-      continue;
-    }
-    else if( !strncmp(inputLine, "%Columns", 8) ) {
-      if( strstr(inputLine,"Sal")==NULL) {
-        salPresent=0;
-        sal=35.;
-        printf("%%(salinity data not present in input profile - assuming 35ppt.)\n");
-      } else salPresent=1;
-      continue;
+    /* With a record stream, the level's values come straight from its next
+       level record - after the next station's header record once this
+       station's levels are used up.  Its temp and sal are picked out by
+       their var codes (1 and 2), and the station-info line and the missing
+       salinity note are output just as for text input with titles. */
+    if(recordInput) {
+      while(levelsLeft==0 && !lastLinePassed) {
+        status=readOCLRecordStation(fpIn, &rec, &recordFlags);
+        if(status!=SUCCESSFUL) {
+          status = (status==OCL_RECORD_END) ? SUCCESSFUL : FAILED;
+          lastLinePassed=1;
+          break;
+        }
+        levelsLeft=rec.numLevels;
+        tempCol=salCol=-1;
+        for(k=rec.numVars-1; k>=0; k--) {
+          if(rec.varCode[k]==1) tempCol=(int)k;
+          if(rec.varCode[k]==2) salCol=(int)k;
+        }
+        salPresent = salCol>=0;
+        if(!salPresent) sal=35.;
+        if(recordFlags & OCL_RECORD_TITLES) {
+          if(rec.bottomDepthSource!='-')
+            sprintf(botDepthStr,"%.2f m", rec.bottomDepth);
+          else strcpy(botDepthStr,"[no data]");
+          printf("%%Station #%ld, bottom depth %9s (from %c),  %s level data\n",
+            rec.stationNumber, botDepthStr, (char)rec.bottomDepthSource,
+            (rec.stationType==0) ? "observed" : "standard" );
+          if(!salPresent)
+            printf("%%(salinity data not present in input profile - assuming 35ppt.)\n");
+        }
+      }
+      if(!lastLinePassed) {
+        if(readOCLRecordLevel(fpIn, rec.numVars, value, errCode)!=SUCCESSFUL) {
+          status=FAILED;
+          lastLinePassed=1;
+        }
+        levelsLeft--;
+      }
+      if(!lastLinePassed) {
+        lat=rec.lat;
+        lon=rec.lon;
+        year=(int)rec.year;
+        month=(int)rec.month;
+        day=(int)rec.day;
+        time=rec.time;
+        depth=value[0];
+        temp = (tempCol>=0) ? value[1+tempCol] : badValue;
+        if(salPresent) sal=value[1+salCol];
+      }
     }
-    else if(inputLine[0]=='%' && !lastLinePassed) continue;
 
-    /* If last line of input file not passed already, read and compute data
-       for current line */
-    if(!lastLinePassed) {
+    else {
+      /* get a line of data from the input file */
+      if(fgets(inputLine, 255, fpIn)==NULL) lastLinePassed=1;
+
+      /* comment lines - we want to keep the station-info line,
+         check for existence of salinity column in input, and toss the other
+         comment lines; and afterwards skip to next line-reading */
+      if( !strncmp(inputLine, "%Station", 8) ) {
+        printf("%s", inputLine);
+        continue;
+      }
+      else if( !strncmp(inputLine, "%Columns", 8) ) {
+        if( strstr(inputLine,"Sal")==NULL) {
+          salPresent=0;
+          sal=35.;
+          printf("%%(salinity data not present in input profile - assuming 35ppt.)\n");
+        } else salPresent=1;
+        continue;
+      }
+      else if(inputLine[0]=='%' && !lastLinePassed) continue;
 
       /* Read the line's data into vars */
+      if(!lastLinePassed) {
 	  if(salPresent)
-      sscanf(inputLine,"%lf %lf %d %d %d %lf %lf %lf %lf", &lat, &lon, &year,
-        &month, &day, &time, &depth, &temp, &sal);
+        sscanf(inputLine,"%lf %lf %d %d %d %lf %lf %lf %lf", &lat, &lon, &year,
+          &month, &day, &time, &depth, &temp, &sal);
 	  else
-      sscanf(inputLine,"%lf %lf %d %d %d %lf %lf %lf", &lat, &lon, &year,
-        &month, &day, &time, &depth, &temp);
-  
+        sscanf(inputLine,"%lf %lf %d %d %d %lf %lf %lf", &lat, &lon, &year,
+          &month, &day, &time, &depth, &temp);
+      }
+    }
+
+    /* If last line of input file not passed already, compute data
+       for current line */
+    if(!lastLinePassed) {
+
       /* If using salfile for salinities, look up sal for this region/depth */
       if( compSalType == ANNUAL ) {
         compSal =
@@ -326,15 +413,28 @@ main(int argc, char *argv[]) {
 	   stdevDiffSsp=stdev(cumDiffSsp, avgDiffSsp, N);
 	 }
 
-         /* output bin data line */
-         printf("%7.4lf %7.4lf %4d %2d %2d %5.2lf %8.3lf %8.3lf %8.3lf %9.3lf",
-           oldLat, oldLon, oldyear, oldmonth, oldday, oldtime, depthBin,
-	   avgTemp, avgSal, avgSspActual);
+         /* output bin data line, ie "%7.4lf %7.4lf %4d %2d %2d %5.2lf
+            %8.3lf %8.3lf %8.3lf %9.3lf" [" %8.3lf %9.3lf %7.3lf %7.3lf %2ld"]
+            put together in outputLine */
+         p = formatOCLFixed(outputLine, "", oldLat, 7, 4);
+         p = formatOCLFixed(p, " ", oldLon, 7, 4);
+         p = formatOCLLong(p, " ", (long int)oldyear, 4);
+         p = formatOCLLong(p, " ", (long int)oldmonth, 2);
+         p = formatOCLLong(p, " ", (long int)oldday, 2);
+         p = formatOCLFixed(p, " ", oldtime, 5, 2);
+         p = formatOCLFixed(p, " ", depthBin, 8, 3);
+         p = formatOCLFixed(p, " ", avgTemp, 8, 3);
+         p = formatOCLFixed(p, " ", avgSal, 8, 3);
+         p = formatOCLFixed(p, " ", avgSspActual, 9, 3);
 	 if(compSalType!=0) {
-	   printf(" %8.3lf %9.3lf %7.3lf %7.3lf %2ld", avgCompSal, avgSspComp,
-		  avgDiffSsp, stdevDiffSsp, N);
+	   p = formatOCLFixed(p, " ", avgCompSal, 8, 3);
+	   p = formatOCLFixed(p, " ", avgSspComp, 9, 3);
+	   p = formatOCLFixed(p, " ", avgDiffSsp, 7, 3);
+	   p = formatOCLFixed(p, " ", stdevDiffSsp, 7, 3);
+	   p = formatOCLLong(p, " ", N, 2);
 	 }
-	 printf("\n");
+	 formatOCLString(p, "\n", 0);
+	 fputs(outputLine, stdout);
 
         /* reinitialize arrays and avgs */
         for(j=0; j<MAX_BIN_ARRAY; j++) {
@@ -390,33 +490,38 @@ main(int argc, char *argv[]) {
     }
 
     else if (!depthBinsUsed && !lastLinePassed) {
-      /* just output the single resulting line of data */
-      printf("%7.4lf %7.4lf %4d %2d %2d %5.2lf %8.3lf %8.3lf %8.3lf %9.3lf",
-             lat, lon, year, month, day, time, depth, temp, sal, sspActual);
-      if(compSalType!=0)
-	printf(" %8.3lf %9.3lf %7.3lf", compSal, sspComp, diffSsp);
-      printf("\n");
+      /* just output the single resulting line of data, ie "%7.4lf %7.4lf
+         %4d %2d %2d %5.2lf %8.3lf %8.3lf %8.3lf %9.3lf" [" %8.3lf %9.3lf
+         %7.3lf"] put together in outputLine */
+      p = formatOCLFixed(outputLine, "", lat, 7, 4);
+      p = formatOCLFixed(p, " ", lon, 7, 4);
+      p = formatOCLLong(p, " ", (long int)year, 4);
+      p = formatOCLLong(p, " ", (long int)month, 2);
+      p = formatOCLLong(p, " ", (long int)day, 2);
+      p = formatOCLFixed(p, " ", time, 5, 2);
+      p = formatOCLFixed(p, " ", depth, 8, 3);
+      p = formatOCLFixed(p, " ", temp, 8, 3);
+      p = formatOCLFixed(p, " ", sal, 8, 3);
+      p = formatOCLFixed(p, " ", sspActual, 9, 3);
+      if(compSalType!=0) {
+	p = formatOCLFixed(p, " ", compSal, 8, 3);
+	p = formatOCLFixed(p, " ", sspComp, 9, 3);
+	p = formatOCLFixed(p, " ", diffSsp, 7, 3);
+      }
+      formatOCLString(p, "\n", 0);
+      fputs(outputLine, stdout);
   }
 
 
   }  /* end of loop over lines in input stream */
 
-  return SUCCESSFUL;
+  return status;
 
 }  /* end of main */
 
 
 
 
-/* "Depth to Pressure" - quick conversion function */
-double depth2pres(double depth) {
-  return .1 * depth / .99;
-}
-
-
-
-
-
 /* "Parse Command Line" - get the appropriate command line info for sspcomp */
 int parse_commandline(int argc, char **argv, FILE **fp_In, FILE **fp_Out,
   double *compSal, double *depthBinSize, int *depthBinsUsed,
@@ -518,6 +623,7 @@ int parse_commandline(int argc, char **argv, FILE **fp_In, FILE **fp_Out,
         printf("     comparison salinity value) to an input line that\n");
 	printf("     includes depth, temp, salinity, and other possible\n");
 	printf("     values as outputted from the oclfilt program.\n");
+	printf("     (Or reads oclfilt -B's binary record stream.)\n");
         printf("     The ssp calculation model has a limited input domain -\n");
         printf("     valid for Depth<9900 m, 0<Temp<40 C, 0<Sal<40 ppt.\n");
         printf("     If out-of-range values entered, there will be NaN\n");
@@ -715,7 +821,7 @@ double stdev(double *cumDiffSsp, double avg, long int N) {
 }
 
 
-double nan() {
+double makeNaN() {
   double x=0;
   return sqrt(-1/x);
 }